@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include "hal.h"
+#include "bus_spi.h" // RelojMicros
+
+// --- Almacen de ajustes persistentes ---
+// Registro binario versionado con CRC32, escrito alternando dos ranuras (A/B).
+// Un corte de energia durante la escritura solo puede romper la ranura que se
+// estaba escribiendo: la otra conserva la ultima confirmacion valida.
+
+#define AJUSTES_VERSION 1
+
+// Contenido de los ajustes. En el archivo no va el struct crudo (con su
+// relleno) sino cada campo en little endian, uno detras de otro (ver
+// ajustes.cpp). Los campos nuevos se agregan SIEMPRE al final, se sube
+// AJUSTES_VERSION y se anota el largo de la carga de esa version: un
+// registro de una version vieja trae menos campos y el resto queda con los
+// valores por defecto; uno de una version nueva se lee hasta donde llegan
+// los campos conocidos.
+struct Ajustes
+{
+  float kp;
+  float ki;
+  float kd;
+  int16_t consigna[2]; // Decimas de grado por canal
+  int16_t histeresis;  // Decimas de grado
+  uint16_t calTactil[5];
+  uint8_t calValida;
+  uint8_t modo;
+};
+
+struct EstadisticasAjustes
+{
+  uint32_t confirmaciones;
+  uint32_t ultimaLatenciaUs; // Escritura + cierre de la ultima confirmacion
+  uint32_t ultimosBytes;     // Bytes del ultimo registro (cabecera + carga)
+  uint32_t bytesTotales;     // Acumulado desde el arranque
+};
+
+class AlmacenAjustes
+{
+public:
+  AlmacenAjustes(SistemaArchivos &fs, RelojMicros reloj);
+
+  // Solo lee las cabeceras de ambas ranuras; la carga util se lee al primer uso.
+  void begin();
+
+  // Acceso de lectura (carga perezosa en el primer acceso).
+  const Ajustes &leer();
+  // Acceso de escritura: los cambios se persisten con confirmar().
+  Ajustes &editar();
+  // Escribe el registro en la ranura mas vieja. Devuelve false si fallo.
+  bool confirmar();
+
+  bool hayRegistroValido() { cargar(); return valido_; }
+  uint32_t secuencia() const { return secuencia_; }
+  const EstadisticasAjustes &estadisticas() const { return estadisticas_; }
+
+private:
+  struct Cabecera
+  {
+    uint32_t magia;
+    uint16_t version;
+    uint16_t longitud; // Bytes de carga util que siguen a la cabecera
+    uint32_t secuencia;
+    uint32_t crc; // CRC32 de la cabecera (sin este campo) + carga util
+  };
+
+  bool leerCabecera(uint8_t ranura, Cabecera &cab);
+  bool leerRanura(uint8_t ranura, const Cabecera &cab);
+  void cargar();
+  void importarLegado();
+  static void porDefecto(Ajustes &a);
+
+  SistemaArchivos &fs_;
+  RelojMicros reloj_;
+  Ajustes datos_;
+  Cabecera cabeceras_[2];
+  bool cabeceraOk_[2];
+  bool cargado_;
+  bool valido_;
+  uint8_t ranuraActual_;
+  uint32_t secuencia_;
+  EstadisticasAjustes estadisticas_;
+};
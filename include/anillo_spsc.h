@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// --- Anillo de un productor y un consumidor ---
+// Memoria estatica y sin locks: el indice de escritura lo mueve solo el
+// productor y el de lectura solo el consumidor; el acquire/release ordena
+// los datos de la ranura. Solo hay cargas y almacenamientos atomicos de 32
+// bits (nada de read-modify-write), asi que cualquiera de los dos lados
+// puede ser una ISR. Los indices corren libres y dan la vuelta en 2^32: con
+// N potencia de 2 la ranura sale con una mascara y la resta sigue valiendo.
+
+// Separacion entre los dos indices para que no compartan linea de cache. La
+// SRAM interna del ESP32 no pasa por cache: ahi alcanza con una palabra.
+#ifdef ARDUINO
+#define ANILLO_LINEA_CACHE 4
+#else
+#define ANILLO_LINEA_CACHE 64
+#endif
+
+template <typename T, uint16_t N>
+class AnilloSpsc
+{
+public:
+  static_assert(N > 0 && (N & (N - 1)) == 0, "la capacidad debe ser potencia de 2");
+  static const uint16_t CAPACIDAD = N;
+
+  AnilloSpsc() : escritura_(0), perdidos_(0), lectura_(0) {}
+
+  // Lado productor. Devuelve false (y cuenta la perdida) si esta lleno.
+  bool publicar(const T &valor)
+  {
+    uint32_t w = escritura_.load(std::memory_order_relaxed);
+    if (w - lectura_.load(std::memory_order_acquire) >= N)
+    {
+      // Solo lo escribe el productor: cargar y guardar, sin read-modify-write
+      perdidos_.store(perdidos_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    datos_[w & (N - 1)] = valor;
+    escritura_.store(w + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Lado consumidor
+  bool siguiente(T &valor)
+  {
+    uint32_t r = lectura_.load(std::memory_order_relaxed);
+    if (r == escritura_.load(std::memory_order_acquire))
+      return false;
+    valor = datos_[r & (N - 1)];
+    lectura_.store(r + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Desde cualquier lado es una foto: el otro puede moverse enseguida. La
+  // lectura se toma primero, asi nunca queda por delante de la escritura.
+  uint16_t cantidad() const
+  {
+    uint32_t r = lectura_.load(std::memory_order_acquire);
+    return (uint16_t)(escritura_.load(std::memory_order_acquire) - r);
+  }
+  bool vacio() const { return cantidad() == 0; }
+  uint32_t perdidos() const { return perdidos_.load(std::memory_order_relaxed); }
+
+private:
+  // Lo del productor y lo del consumidor en lineas distintas
+  alignas(ANILLO_LINEA_CACHE) std::atomic<uint32_t> escritura_;
+  std::atomic<uint32_t> perdidos_; // Lo escribe solo el productor; se lee de cualquier lado
+  alignas(ANILLO_LINEA_CACHE) std::atomic<uint32_t> lectura_;
+  alignas(ANILLO_LINEA_CACHE) T datos_[N];
+};
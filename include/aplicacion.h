@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "planificador.h"
+#include "mensajes.h" // EstadoControl
+#include "comandos.h"
+
+// --- Aplicacion ---
+// Toda la logica del controlador, sobre la capa de hardware de hal.h. La
+// plataforma (main.cpp en el ESP32, main_host.cpp en Linux) solo crea las
+// tareas, las despierta y decide cuando dormir.
+
+// Cada tarea corre sus trabajos con su propio planificador y se bloquea
+// hasta el proximo o hasta que le avisen que tiene mensajes. Publica cuanto
+// trabajo y cuando vuelve a despertar: con eso la plataforma decide el light
+// sleep y el reporte calcula el uso de CPU. El tiempo ocupado incluye lo que
+// la desalojaron tareas de mayor prioridad, asi que es una cota superior.
+// Con el tiempo ocupado y los plazos vencidos el gobernador elige la
+// frecuencia de la CPU.
+struct Tarea
+{
+  Tarea(const char *nombre_, void (*alDespertar_)(), bool (*puedeDormir_)(), RelojMicros reloj)
+      : nombre(nombre_), alDespertar(alDespertar_), puedeDormir(puedeDormir_), planificador(reloj),
+        handle(nullptr), ocupadoUs(0), vencidos(0), proximoUs(0), sinPlazo(false), enReposo(false),
+        ocupadoVentanaInicio(0)
+  {
+  }
+
+  const char *nombre;
+  void (*alDespertar)(); // Drena sus anillos antes de correr los trabajos
+  bool (*puedeDormir)(); // nullptr: nunca impide el light sleep
+  Planificador planificador;
+  void *handle;          // De la plataforma (TaskHandle_t en el ESP32)
+  std::atomic<uint32_t> ocupadoUs;
+  std::atomic<uint32_t> vencidos;  // Plazos vencidos desde el arranque
+  std::atomic<uint32_t> proximoUs; // micros() de la proxima activacion
+  std::atomic<bool> sinPlazo;      // Ningun trabajo pendiente
+  std::atomic<bool> enReposo;      // Bloqueada y sin impedir el light sleep
+  uint32_t ocupadoVentanaInicio;   // Solo lo usa el reporte
+};
+
+// En orden de prioridad, de mayor a menor
+extern Tarea tareaControl;
+extern Tarea tareaSensores;
+extern Tarea tareaInterfaz;
+extern Tarea tareaComunicaciones;
+extern Tarea *const tareas[];
+extern const uint8_t CANTIDAD_TAREAS;
+
+// Lo levanta la interrupcion de PENIRQ (o el despertar por GPIO)
+extern volatile bool toquePendiente;
+
+// Con false el tactil se sondea sin mirar PENIRQ, para modulos que no
+// cablean T_IRQ: una lectura por periodo aunque nadie toque, y la interfaz
+// no se pausa con la pantalla apagada porque nada la despertaria. Por
+// defecto true.
+void usarPenirq(bool usar);
+
+// Hardware, ajustes, registro y trabajos de cada tarea. Las tareas todavia
+// no corren.
+void iniciarAplicacion();
+
+// Una activacion de la tarea: drena sus anillos, corre los trabajos vencidos
+// y publica su estado. Devuelve cuanto falta para el proximo trabajo (us;
+// UINT32_MAX si no hay ninguno).
+uint32_t pasoTarea(Tarea &t);
+
+// Diferencia contra lo ya dibujado: solo tocan la pantalla si cambio 'vista'.
+// Sueltas para medirlas en los benchmarks del host.
+extern EstadoControl vista;
+void actualizarTemperaturas();
+void actualizarVisualReles();
+
+// Comandos del enlace BT (procesarEntradaBT)
+extern const Comando tablaComandos[];
+extern const size_t CANTIDAD_COMANDOS;
+
+// --- Lo provee la plataforma ---
+// Despierta la tarea (no hace nada si todavia no se creo)
+void avisar(Tarea &t);
+// Minimo de pila libre desde el arranque en bytes; nullptr es la tarea que
+// corre setup()/loop()
+uint32_t pilaLibre(const Tarea *t);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef ARDUINO
+
+// --- Microbenchmarks de los caminos calientes (host) ---
+//   controlador_host --bench [iteraciones] [nombre]
+// Cada benchmark se calienta y despues corre REPETICIONES_BENCH tandas de
+// 'iteraciones' pasos. Imprime una linea JSON por benchmark con ns por paso
+// (minimo, mediana y maximo entre tandas) y pedidos al heap por paso
+// (memoria.h): la mediana es el numero a comparar entre versiones, el
+// minimo y el maximo dicen cuanto ruido hubo.
+// Los que procesan varias unidades por paso agregan su caudal con la
+// mediana, con la unidad en el nombre del campo: bytes_s, muestras_s,
+// lecturas_s, llamadas_s o consultas_s.
+// Los de pasos caros corren una fraccion de las iteraciones y informan las
+// que corrieron.
+
+static const uint32_t ITERACIONES_BENCH = 200000;
+static const uint8_t REPETICIONES_BENCH = 9;
+
+// Corre los benchmarks cuyo nombre empieza con 'filtro' (nullptr: todos).
+// Devuelve cuantos corrio.
+uint8_t correrBenchmarks(uint32_t iteraciones, const char *filtro);
+
+#endif
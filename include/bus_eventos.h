@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Temas de publicacion/suscripcion ---
+// Un tema es un tipo de dato mas una tabla fija de suscriptores armada en
+// tiempo de compilacion. Quien publica no conoce a quien escucha: sumar un
+// consumidor es agregar una entrada a la tabla del tema, sin tocar al
+// productor. Publicar llama a los suscriptores en el orden de la tabla, en
+// el contexto de quien publica y sin reservar memoria; el tema no tiene
+// estado, asi que puede quedar en flash como constante.
+//
+//   static const Tema<Muestra>::Suscriptor alMedir[] = {filtrar, registrar};
+//   const Tema<Muestra> temaMedicion("medicion", alMedir);
+//
+// Para cruzar de tarea, el suscriptor copia el evento a un AnilloSpsc y
+// avisa a la tarea consumidora.
+
+template <typename T>
+class Tema
+{
+public:
+  typedef void (*Suscriptor)(const T &evento);
+
+  template <size_t N>
+  constexpr Tema(const char *nombre, const Suscriptor (&suscriptores)[N])
+      : nombre_(nombre), suscriptores_(suscriptores), cantidad_(N)
+  {
+  }
+
+  void publicar(const T &evento) const
+  {
+    for (size_t i = 0; i < cantidad_; i++)
+      suscriptores_[i](evento);
+  }
+
+  const char *nombre() const { return nombre_; }
+  size_t cantidad() const { return cantidad_; }
+
+private:
+  const char *nombre_;
+  const Suscriptor *suscriptores_;
+  size_t cantidad_;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Arbitraje del bus SPI compartido (pantalla TFT_CS=5 / tactil TOUCH_CS=21) ---
+// Los dibujos se encolan como trabajos divididos en pasos cortos; entre paso y
+// paso el gestor intercala el muestreo del XPT2046 con un periodo garantizado.
+
+// Dibuja un tramo acotado del trabajo. Devuelve true si quedan pasos pendientes.
+typedef bool (*PasoPantalla)(uint8_t paso);
+// Lee el panel tactil. Devuelve true si hay un toque valido en (x, y).
+typedef bool (*MuestreoTactil)(uint16_t *x, uint16_t *y);
+// Recibe cada muestra del tactil (tambien las omitidas, como no presionado).
+typedef void (*ReceptorTactil)(bool presionado, uint16_t x, uint16_t y, uint32_t us);
+// Estado de la linea PENIRQ del XPT2046: true si hay (o hubo) un toque.
+typedef bool (*LineaToque)();
+// Fuente de tiempo en microsegundos (micros() en el ESP32).
+typedef uint32_t (*RelojMicros)();
+
+// Histograma logaritmico (cubetas de potencias de 2 en us) para percentiles.
+struct HistogramaLatencia
+{
+  static const uint8_t CUBETAS = 24;
+  uint32_t cubetas[CUBETAS];
+  uint32_t total;
+  uint32_t maximo;
+
+  void reiniciar();
+  void registrar(uint32_t us);
+  // Cota superior (us) de la cubeta que contiene el percentil p (0-100).
+  uint32_t percentil(uint8_t p) const;
+};
+
+struct EstadisticasBusSPI
+{
+  uint32_t muestrasTactil;   // Transacciones de lectura del tactil
+  uint32_t muestrasEvitadas; // Muestreos omitidos porque PENIRQ no indicaba toque
+  uint32_t pasosPantalla;    // Transacciones (pasos) de dibujo
+  uint32_t pasoMaximoUs;     // Paso de dibujo mas largo observado
+  uint32_t retrasoTactilMaxUs; // Peor retraso del muestreo respecto a su periodo
+};
+
+class GestorBusSPI
+{
+public:
+  static const uint8_t MAX_TRABAJOS = 8;
+
+  GestorBusSPI(RelojMicros reloj, MuestreoTactil muestreo, uint32_t periodoTactilUs);
+
+  void alMuestrear(ReceptorTactil receptor) { receptor_ = receptor; }
+  // Con PENIRQ conectado solo se lee el panel mientras hay un toque en curso.
+  void detectorToque(LineaToque linea) { linea_ = linea; }
+
+  // Encola un trabajo de pantalla. Si ya hay uno igual pendiente se fusiona.
+  bool encolarPantalla(PasoPantalla trabajo);
+
+  // Atiende el bus durante como mucho presupuestoUs: muestrea el tactil cuando
+  // le toca y avanza los trabajos de pantalla paso a paso.
+  void servir(uint32_t presupuestoUs);
+
+  // Ejecuta todos los trabajos pendientes sin muestrear el tactil (setup).
+  void vaciarPantalla();
+
+  // Quien llama a servir() estuvo en pausa (pantalla apagada): el proximo
+  // servir() muestrea enseguida y esa muestra no cuenta como retraso.
+  void reanudar() { sinReferencia_ = true; }
+
+  // Un toque en desdeUs que se responde con 'trabajo': el proximo que se
+  // encole (aunque lo encole otra tarea al recibir el cambio) lleva la
+  // respuesta, y la latencia se registra cuando termina de salir por el bus.
+  // Los toques que no redibujan nada no se miden.
+  void iniciarRespuesta(PasoPantalla trabajo, uint32_t desdeUs);
+
+  bool pantallaPendiente() const { return cantidad_ > 0; }
+  bool tocando() const { return tocando_; }
+
+  const EstadisticasBusSPI &estadisticas() const { return estadisticas_; }
+  const HistogramaLatencia &latenciaToque() const { return latencia_; }
+  void reiniciarEstadisticas();
+
+private:
+  struct Trabajo
+  {
+    PasoPantalla paso;
+    uint8_t indice;
+    bool respuesta; // Termina la respuesta a un toque
+    uint32_t inicioRespuesta;
+  };
+
+  void muestrear(uint32_t ahora);
+  bool ejecutarPaso();
+
+  RelojMicros reloj_;
+  MuestreoTactil muestreo_;
+  ReceptorTactil receptor_;
+  LineaToque linea_;
+  uint32_t periodoTactilUs_;
+  uint32_t ultimoMuestreo_;
+  bool sinReferencia_; // ultimoMuestreo_ no sirve para medir el retraso
+
+  Trabajo trabajos_[MAX_TRABAJOS];
+  uint8_t primero_;
+  uint8_t cantidad_;
+
+  bool tocando_;
+  PasoPantalla trabajoRespuesta_; // El que va a llevar la proxima respuesta
+  uint32_t inicioRespuesta_;
+
+  EstadisticasBusSPI estadisticas_;
+  HistogramaLatencia latencia_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include "anillo_spsc.h"
+#include "bus_spi.h" // RelojMicros, HistogramaLatencia
+
+// --- Cola diferida de eventos entre contextos ---
+// Un productor (callback del stack BT, ISR) publica eventos chicos y el
+// consumidor (la tarea de comunicaciones) los procesa despues. Es un
+// AnilloSpsc que ademas mide cuanto espera cada evento.
+
+struct EventoDiferido
+{
+  uint8_t tipo;
+  uint32_t dato;
+  uint32_t encoladoUs; // Marca al publicar, para medir la espera en la cola
+};
+
+class ColaEventos
+{
+public:
+  static const uint8_t CAPACIDAD = 16; // Potencia de 2
+
+  explicit ColaEventos(RelojMicros reloj);
+
+  // Lado productor. Devuelve false (y cuenta la perdida) si la cola esta llena.
+  bool publicar(uint8_t tipo, uint32_t dato = 0);
+  // Lado productor: duracion del callback que publico, medida por quien llama.
+  void registrarCallback(uint32_t us) { duracionCallback_.registrar(us); }
+
+  // Lado consumidor. Registra cuanto espero el evento en la cola.
+  bool siguiente(EventoDiferido &evento);
+
+  const HistogramaLatencia &duracionCallback() const { return duracionCallback_; }
+  const HistogramaLatencia &latencia() const { return latencia_; }
+  uint32_t perdidos() const { return anillo_.perdidos(); }
+
+private:
+  RelojMicros reloj_;
+  AnilloSpsc<EventoDiferido, CAPACIDAD> anillo_;
+
+  // Cada estadistica la escribe un solo contexto
+  HistogramaLatencia duracionCallback_; // Productor
+  HistogramaLatencia latencia_;         // Consumidor
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Cola de transmision acotada ---
+// Ranuras fijas con mensajes ya armados (texto o tramas). Comunicaciones las vacia de
+// a poco con bombear(), asi que nunca se bloquea esperando al enlace SPP.
+// Los mensajes periodicos (estado, muestras) son reemplazables: si todavia no
+// empezaron a salir, uno nuevo de la misma clase pisa al viejo (coalescido), y
+// si la cola se llena son los primeros en descartarse.
+
+enum ClaseMensaje : uint8_t
+{
+  MSG_RESPUESTA, // Respuesta a un comando: nunca se coalesce ni se descarta
+  MSG_HISTORIAL, // Bloque de una descarga: tampoco
+  MSG_ESTADO,
+  MSG_MUESTRA
+};
+
+inline bool esReemplazable(ClaseMensaje clase)
+{
+  return clase == MSG_ESTADO || clase == MSG_MUESTRA;
+}
+
+// Escribe hasta len bytes en el enlace y devuelve cuantos acepto.
+typedef size_t (*EscritorEnlace)(const uint8_t *datos, size_t len);
+
+struct EstadisticasColaTx
+{
+  uint32_t encolados;
+  uint32_t coalescidos; // Pisados por uno mas nuevo de la misma clase
+  uint32_t descartados; // Reemplazables quitados para hacer lugar
+  uint32_t rechazados;  // No hubo lugar ni nada reemplazable
+  uint32_t bytesEnviados;
+};
+
+class ColaTransmision
+{
+public:
+  static const uint8_t RANURAS = 8;
+  static const size_t TAM_RANURA = 160;
+
+  ColaTransmision()
+  {
+    vaciar();
+    reiniciarEstadisticas();
+  }
+
+  bool encolar(ClaseMensaje clase, const uint8_t *datos, size_t len);
+  bool encolar(ClaseMensaje clase, const char *texto);
+
+  // Entrega como mucho maxBytes al escritor. Devuelve los bytes aceptados.
+  size_t bombear(EscritorEnlace escritor, size_t maxBytes);
+
+  // Descarta lo pendiente (el cliente se fue). Las estadisticas siguen
+  // acumulando desde el arranque; se ponen en cero solo a pedido.
+  void vaciar();
+  void reiniciarEstadisticas();
+  bool vacia() const { return cantidad_ == 0; }
+  uint8_t libres() const { return RANURAS - cantidad_; }
+  const EstadisticasColaTx &estadisticas() const { return estadisticas_; }
+
+private:
+  struct Ranura
+  {
+    ClaseMensaje clase;
+    uint8_t len;
+    uint8_t datos[TAM_RANURA];
+  };
+
+  Ranura &ranura(uint8_t i) { return ranuras_[(primero_ + i) % RANURAS]; }
+  void quitar(uint8_t i);
+
+  Ranura ranuras_[RANURAS];
+  uint8_t primero_;
+  uint8_t cantidad_;
+  uint8_t enviado_; // Bytes ya entregados de la primera ranura
+  EstadisticasColaTx estadisticas_;
+};
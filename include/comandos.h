@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Lector de lineas incremental ---
+// Acumula bytes en un buffer fijo; nunca espera a que llegue el '\n'.
+// Las lineas demasiado largas se descartan completas (hasta el proximo '\n').
+class LectorLineas
+{
+public:
+  static const uint8_t MAX_LINEA = 64;
+
+  LectorLineas() : len_(0), descartando_(false), desbordes_(0) {}
+
+  // Consume un byte. Devuelve true cuando linea() tiene una linea completa.
+  bool consumir(char c);
+  // Linea terminada en '\0', valida hasta el proximo consumir().
+  char *linea() { return buf_; }
+  uint32_t desbordes() const { return desbordes_; }
+
+private:
+  char buf_[MAX_LINEA + 1];
+  uint8_t len_;
+  bool descartando_;
+  uint32_t desbordes_;
+};
+
+// --- Tabla de comandos ---
+struct Comando
+{
+  const char *nombre;
+  uint8_t minArgs;
+  uint8_t maxArgs;
+  void (*ejecutar)(uint8_t argc, char *argv[]);
+};
+
+enum ResultadoComando : uint8_t
+{
+  CMD_OK,
+  CMD_VACIO,
+  CMD_DESCONOCIDO,
+  CMD_ARGUMENTOS
+};
+
+// Separa la linea en palabras sobre el mismo buffer (sin copias) y despacha
+// al comando de la tabla cuyo nombre coincide (sin distinguir mayusculas).
+ResultadoComando despacharComando(char *linea, const Comando *tabla, size_t cantidad);
+
+bool igualSinMayusculas(const char *a, const char *b);
+
+// Entero sin signo en base 10 ("2000"). Falla ante cualquier otro caracter.
+bool parsearEntero(const char *texto, uint32_t &valor);
+
+// "25", "25.5", "-3.25" -> decimas (redondeo a la decima). Sin float.
+bool parsearDecimas(const char *texto, int16_t &decimas);
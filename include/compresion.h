@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "telemetria.h"
+
+// --- Compresion de bloques de lecturas ---
+// Cada bloque se decodifica solo. La primera lectura va completa y las
+// siguientes con codigos de prefijo sobre un flujo de bits (MSB primero):
+//   marca: delta del delta (lecturas periodicas -> un bit)
+//     0 | 10 + 7 bits | 110 + 12 bits | 111 + 32 bits
+//   cada temperatura: delta respecto de la anterior
+//     0 | 10 + 2 bits (+-1, +-2) | 110 + 5 bits | 1110 + 12 bits | 1111 + valor de 16 bits
+//   banderas: 0 si no cambiaron | 1 + 8 bits
+// Una lectura estable ocupa 4 bits; la cantidad de lecturas va aparte (el
+// relleno del ultimo byte no se puede distinguir de lecturas).
+
+class CodificadorBloque
+{
+public:
+  static const size_t BITS_PRIMERA = 32 + 16 + 16 + 8;
+  static const size_t MAX_BITS_LECTURA = (3 + 32) + 2 * (4 + 16) + (1 + 8);
+
+  // Bytes que alcanzan para cualquier bloque de 'cantidad' lecturas.
+  static constexpr size_t maxBytes(uint16_t cantidad)
+  {
+    return (BITS_PRIMERA + (cantidad - 1) * MAX_BITS_LECTURA + 7) / 8;
+  }
+
+  CodificadorBloque() : buf_(nullptr), cap_(0), bits_(0), cantidad_(0) {}
+
+  // Empieza un bloque nuevo sobre buf.
+  void iniciar(uint8_t *buf, size_t cap);
+  // Devuelve false (sin tocar el bloque) si no hay lugar para el peor caso.
+  bool agregar(const Lectura &l);
+
+  uint16_t cantidad() const { return cantidad_; }
+  size_t bytes() const { return (bits_ + 7) / 8; }
+
+private:
+  void poner(uint32_t valor, uint8_t n);
+  void ponerTemperatura(int16_t anterior, int16_t actual);
+
+  uint8_t *buf_;
+  size_t cap_;
+  size_t bits_;
+  uint16_t cantidad_;
+  Lectura anterior_;
+  int32_t deltaMarca_;
+};
+
+class DecodificadorBloque
+{
+public:
+  DecodificadorBloque(const uint8_t *buf, size_t largo, uint16_t cantidad);
+
+  // Marca de la primera lectura: son los primeros 4 bytes del bloque, se
+  // puede leer sin decodificar.
+  static uint32_t marcaInicial(const uint8_t *buf)
+  {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+  }
+
+  // Devuelve false al terminar el bloque o si los datos no alcanzan.
+  bool siguiente(Lectura &l);
+
+private:
+  bool tomar(uint8_t n, uint32_t &valor);
+  bool tomarConSigno(uint8_t n, int32_t &valor);
+  bool tomarPrefijo(uint8_t maximo, uint8_t &unos);
+  bool tomarTemperatura(int16_t anterior, int16_t &actual);
+
+  const uint8_t *buf_;
+  size_t totalBits_;
+  size_t pos_;
+  uint16_t restantes_;
+  bool primera_;
+  Lectura anterior_;
+  int32_t deltaMarca_;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- Logica de control de los reles ---
+// Temperaturas en decimas de grado (int16_t) para no depender de float.
+
+enum ModoControl : uint8_t
+{
+  MODO_DEMO,   // Alterna K1/K2 cada ciclo (comportamiento de prueba original)
+  MODO_MANUAL, // Los reles solo cambian por comando
+  MODO_AUTO    // Termostato con histeresis sobre cada sensor
+};
+
+const char *nombreModo(ModoControl modo);
+
+// Filtro exponencial (alfa = 1/4) en punto fijo. Evita que el ruido del
+// sensor haga oscilar el rele alrededor de la consigna.
+struct FiltroTemperatura
+{
+  int32_t acumulado; // decimas * 4
+  bool iniciado;
+
+  void reiniciar() { iniciado = false; }
+  int16_t paso(int16_t medida);
+  int16_t valor() const { return (int16_t)(acumulado / 4); }
+};
+
+// Termostato de calefaccion: enciende por debajo de consigna - histeresis y
+// apaga por encima de consigna + histeresis. Entre medio mantiene el estado.
+bool pasoTermostato(bool encendido, int16_t medida, int16_t consigna, int16_t histeresis);
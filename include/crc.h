@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE 802.3, polinomio reflejado 0xEDB88320). Para calcular por
+// tramos se pasa el resultado anterior como semilla.
+uint32_t crc32(const void *datos, size_t len, uint32_t semilla = 0);
+
+// CRC-16/CCITT-FALSE (polinomio 0x1021, valor inicial 0xFFFF). Tramas cortas
+// de telemetria, donde 2 bytes de verificacion alcanzan.
+uint16_t crc16(const void *datos, size_t len, uint16_t semilla = 0xFFFF);
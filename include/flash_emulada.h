@@ -0,0 +1,56 @@
+#pragma once
+
+#include "memoria_flash.h"
+
+#ifndef ARDUINO
+#include <vector>
+
+// Tiempos tipicos de la flash SPI del ESP32-WROOM (hoja de datos, valores tipicos)
+struct TiemposFlash
+{
+  uint32_t usPorPagina = 700;    // Programacion de hasta 256 bytes
+  uint32_t usPorBorrado = 45000; // Borrado de un sector de 4 KB
+};
+
+// Flash en RAM con semantica NOR, reloj simulado y cortes de energia
+// programables, para medir y ejercitar el registro en el host.
+class FlashEmulada : public MemoriaFlash
+{
+public:
+  static const uint32_t TAM_PAGINA = 256;
+
+  explicit FlashEmulada(uint32_t tamano, const TiemposFlash &tiempos = TiemposFlash());
+
+  uint32_t tamano() const override { return (uint32_t)datos_.size(); }
+  bool leer(uint32_t dir, void *out, size_t len) override;
+  bool escribir(uint32_t dir, const void *datos, size_t len) override;
+  bool borrarSector(uint32_t dir) override;
+
+  // Reloj simulado: avanza con cada programacion y borrado segun TiemposFlash.
+  uint32_t tiempoUs() const { return tiempoUs_; }
+  void avanzar(uint32_t us) { tiempoUs_ += us; }
+
+  // Despues de programar 'bytes' bytes mas se corta la energia: la escritura
+  // en curso queda a medias y todo lo que siga falla hasta restaurarEnergia().
+  void programarCorte(uint32_t bytes);
+  void restaurarEnergia();
+  bool sinEnergia() const { return cortada_; }
+
+  uint32_t borrados(uint32_t sector) const { return borradosPorSector_[sector]; }
+  uint32_t bytesProgramados() const { return bytesProgramados_; }
+
+  // Persistencia en un archivo del host (imagen cruda de la flash).
+  bool guardar(const char *ruta) const;
+  bool cargar(const char *ruta);
+
+private:
+  TiemposFlash tiempos_;
+  std::vector<uint8_t> datos_;
+  std::vector<uint32_t> borradosPorSector_;
+  uint32_t tiempoUs_;
+  uint32_t bytesProgramados_;
+  bool corteProgramado_;
+  uint32_t bytesHastaCorte_;
+  bool cortada_;
+};
+#endif
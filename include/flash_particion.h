@@ -0,0 +1,25 @@
+#pragma once
+
+#include "memoria_flash.h"
+
+#ifdef ARDUINO
+#include "esp_partition.h"
+
+// Particion de datos de la tabla de particiones (ver particiones.csv),
+// accedida con esp_partition_* sin pasar por SPIFFS.
+class FlashParticion : public MemoriaFlash
+{
+public:
+  FlashParticion() : particion_(nullptr) {}
+
+  bool begin(const char *etiqueta);
+
+  uint32_t tamano() const override { return particion_ ? particion_->size : 0; }
+  bool leer(uint32_t dir, void *out, size_t len) override;
+  bool escribir(uint32_t dir, const void *datos, size_t len) override;
+  bool borrarSector(uint32_t dir) override;
+
+private:
+  const esp_partition_t *particion_;
+};
+#endif
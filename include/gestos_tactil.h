@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- Maquina de estados de gestos tactiles ---
+// Recibe una muestra por periodo de muestreo (presionado o no, con su marca en
+// us) y produce eventos con marca de tiempo en una cola fija. No bloquea ni
+// depende de Arduino: se puede alimentar con trazas sinteticas en el host.
+
+enum TipoEventoTactil : uint8_t
+{
+  TOQUE_BAJADA,     // Presion confirmada tras el antirrebote
+  TOQUE_SUBIDA,     // Liberacion confirmada tras el antirrebote
+  TOQUE_CLICK,      // Subida de un toque que no llego a pulsacion larga
+  TOQUE_LARGO,      // Mantenido mas de msLargo
+  TOQUE_REPETICION  // Cada msRepeticion mientras sigue mantenido tras el largo
+};
+
+struct EventoTactil
+{
+  TipoEventoTactil tipo;
+  uint16_t x;
+  uint16_t y;
+  uint32_t us; // Instante en que el evento quedo confirmado
+};
+
+struct ConfigGestos
+{
+  uint16_t msRebote = 30;
+  uint16_t msLargo = 700;
+  uint16_t msRepeticion = 200;
+};
+
+class MaquinaGestos
+{
+public:
+  static const uint8_t CAPACIDAD_COLA = 16;
+
+  explicit MaquinaGestos(const ConfigGestos &config = ConfigGestos());
+
+  // Procesa una muestra. (x, y) solo se usan si presionado es true.
+  void muestra(bool presionado, uint16_t x, uint16_t y, uint32_t us);
+
+  // Saca el evento mas antiguo. Devuelve false si la cola esta vacia.
+  bool siguiente(EventoTactil &evento);
+
+  bool enReposo() const { return estado_ == REPOSO; }
+  uint32_t descartados() const { return descartados_; }
+  void reiniciar();
+
+private:
+  enum Estado : uint8_t
+  {
+    REPOSO,
+    CONFIRMANDO_BAJADA,
+    PRESIONADO,
+    CONFIRMANDO_SUBIDA
+  };
+
+  void emitir(TipoEventoTactil tipo, uint32_t us);
+
+  ConfigGestos config_;
+  Estado estado_;
+  uint16_t x_;
+  uint16_t y_;
+  uint32_t tCambio_;
+  uint32_t tBajada_;
+  uint32_t tProximaRepeticion_;
+  bool largoEmitido_;
+
+  EventoTactil cola_[CAPACIDAD_COLA];
+  uint8_t primero_;
+  uint8_t cantidad_;
+  uint32_t descartados_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include "bus_spi.h" // RelojMicros
+
+// --- Gobernador de la frecuencia de la CPU ---
+// Una vez por ventana recibe la carga (fraccion del tiempo en que las tareas
+// estuvieron ocupadas, medida a la frecuencia vigente) y los plazos que se
+// vencieron, y elige el escalon mas bajo que alcanza:
+//   - Sube enseguida: al maximo si se vencio algun plazo, y si no al escalon
+//     mas bajo donde la carga quede por debajo de UMBRAL_SUBIDA.
+//   - Baja de a un escalon, y solo despues de VENTANAS_PARA_BAJAR ventanas
+//     seguidas en las que la carga, llevada al escalon de abajo, no pase de
+//     UMBRAL_BAJADA.
+// La distancia entre los dos umbrales y la espera para bajar son la
+// histeresis: una carga estable no hace oscilar la frecuencia. La carga es
+// una cota superior (incluye esperas de bus y flash que no escalan con el
+// reloj), asi que el error va del lado seguro.
+
+class Gobernador
+{
+public:
+  static const uint8_t ESCALONES = 3;
+  static const uint16_t UMBRAL_SUBIDA = 700; // Milesimas
+  static const uint16_t UMBRAL_BAJADA = 500;
+  static const uint8_t VENTANAS_PARA_BAJAR = 5;
+
+  typedef void (*FijarFrecuencia)(uint32_t mhz);
+
+  Gobernador(FijarFrecuencia fijar, RelojMicros reloj);
+
+  // Arranca en el maximo
+  void iniciar();
+  // Una ventana: carga en milesimas y plazos vencidos desde la anterior
+  void evaluar(uint32_t cargaMilesimas, uint32_t vencidos);
+  // Al maximo ya, sin esperar la ventana (el usuario toco la pantalla)
+  void impulsar();
+  // Escalon minimo mientras haga falta (el BT); 0 lo libera
+  void fijarPiso(uint32_t mhz);
+
+  static uint32_t mhz(uint8_t escalon) { return MHZ[escalon]; }
+  uint32_t frecuencia() const { return MHZ[escalon_]; }
+  uint32_t piso() const { return MHZ[piso_]; }
+  // Tiempo en cada escalon desde el arranque hasta la ultima ventana
+  uint64_t tiempoUs(uint8_t escalon) const { return escalon < ESCALONES ? tiempoUs_[escalon] : 0; }
+  uint32_t cambios() const { return cambios_; }
+  uint32_t vencidos() const { return vencidos_; }
+  uint32_t ultimaCarga() const { return ultimaCarga_; }
+
+private:
+  static const uint32_t MHZ[ESCALONES];
+
+  void cambiar(uint8_t escalon);
+  void acumular();
+
+  FijarFrecuencia fijar_;
+  RelojMicros reloj_;
+  uint8_t escalon_;
+  uint8_t piso_;
+  uint8_t ventanasBajas_;
+  uint32_t desdeUs_; // Ultima vez que se acumulo tiempo
+  uint64_t tiempoUs_[ESCALONES];
+  uint32_t cambios_;
+  uint32_t vencidos_;
+  uint32_t ultimaCarga_;
+};
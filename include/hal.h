@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "transporte.h"
+#include "memoria_flash.h"
+#include "memoria.h"
+
+// --- Capa de abstraccion del hardware ---
+// Lo que la aplicacion usa del hardware, detras de interfaces chicas. El
+// ESP32 las implementa con Arduino, TFT_eSPI, DallasTemperature y SPIFFS
+// (hal_esp32.cpp) y el host con dobles en memoria (hal_host.h), asi que la
+// logica completa compila y corre en Linux ([env:native]). El enlace BT
+// (Transporte) y la flash del registro (MemoriaFlash) ya tenian su interfaz.
+
+// --- Configuración de Hardware ---
+#define PIN_BL 32
+#define PIN_RELE1 33
+#define PIN_RELE2 26
+#define ONE_WIRE_BUS 27
+#define PIN_T_IRQ 36 // PENIRQ del XPT2046 (activo en LOW, pull-up en el modulo)
+
+class Reloj
+{
+public:
+  virtual ~Reloj() {}
+  virtual uint32_t micros() = 0;
+  virtual uint32_t millis() = 0;
+  virtual void esperarMs(uint32_t ms) = 0;
+};
+
+class Gpio
+{
+public:
+  virtual ~Gpio() {}
+  virtual void salida(uint8_t pin) = 0;
+  virtual void entrada(uint8_t pin) = 0;
+  virtual void escribir(uint8_t pin, bool alto) = 0;
+  virtual bool leer(uint8_t pin) = 0;
+};
+
+// Primitivas de dibujo que usa la interfaz (colores RGB565)
+class Pantalla
+{
+public:
+  static const uint32_t SIN_FONDO = 0x10000; // Texto transparente
+
+  virtual ~Pantalla() {}
+  virtual void iniciar() = 0; // Limpia en negro
+  // Sale o entra en sleep del controlador (la luz es un pin aparte)
+  virtual void encender(bool encendida) = 0;
+  virtual void rellenar(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) = 0;
+  virtual void rellenarRedondeado(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) = 0;
+  virtual void bordeRedondeado(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) = 0;
+  virtual void lineaHorizontal(int16_t x, int16_t y, int16_t w, uint16_t color) = 0;
+  // Texto centrado en (x, y) con la fuente numerada de TFT_eSPI
+  virtual void textoCentrado(const char *texto, int16_t x, int16_t y, uint8_t fuente, uint16_t color,
+                             uint32_t fondo = SIN_FONDO) = 0;
+};
+
+class Tactil
+{
+public:
+  virtual ~Tactil() {}
+  // Una lectura del controlador; false si no hay presion suficiente
+  virtual bool leer(uint16_t &x, uint16_t &y) = 0;
+  // Linea PENIRQ: true mientras el panel esta presionado
+  virtual bool presionado() = 0;
+  virtual void calibracion(const uint16_t datos[5]) = 0;
+  // Rutina interactiva de calibracion (usa la pantalla)
+  virtual void calibrar(uint16_t datos[5]) = 0;
+};
+
+// Temperaturas en Q4 (1/16 de grado); TEMP_Q4_ERROR si el sensor no responde
+class SensoresTemperatura
+{
+public:
+  virtual ~SensoresTemperatura() {}
+  virtual void iniciar() = 0;
+  // No bloquea: la lectura se hace pasados msConversion()
+  virtual void pedirConversion() = 0;
+  virtual uint32_t msConversion() = 0;
+  virtual int16_t leerQ4(uint8_t indice) = 0;
+};
+
+// Salida de diagnostico (Serial en el ESP32, stdout en el host)
+class Consola
+{
+public:
+  virtual ~Consola() {}
+  virtual void escribir(const char *texto) = 0;
+  virtual bool hayEntrada() = 0;
+  void printf(const char *formato, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class SistemaArchivos
+{
+public:
+  virtual ~SistemaArchivos() {}
+  virtual bool existe(const char *ruta) = 0;
+  virtual bool borrar(const char *ruta) = 0;
+  // Hasta len bytes a partir de 'desde'. Devuelve cuantos leyo.
+  virtual size_t leer(const char *ruta, size_t desde, void *datos, size_t len) = 0;
+  // Reemplaza el contenido del archivo. Devuelve cuantos bytes escribio.
+  virtual size_t escribir(const char *ruta, const void *datos, size_t len) = 0;
+};
+
+class Plataforma
+{
+public:
+  virtual ~Plataforma() {}
+  virtual void frecuenciaCpu(uint32_t mhz) = 0;
+  virtual EstadoMemoria memoria() = 0;
+};
+
+// Instancias de la plataforma (hal_esp32.cpp o hal_host.cpp)
+extern Reloj &reloj;
+extern Gpio &gpio;
+extern Pantalla &pantalla;
+extern Tactil &tactil;
+extern SensoresTemperatura &sensores;
+extern Consola &consola;
+extern SistemaArchivos &archivos;
+extern Plataforma &plataforma;
+extern Transporte &enlaceBT;
+extern MemoriaFlash &flashDatos;
+
+// Puertos, sistema de archivos y particion del registro. Devuelve false si
+// algo no arranco (la aplicacion sigue con lo que haya).
+bool iniciarHal();
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "hal.h"
+
+#ifndef ARDUINO
+#include "flash_emulada.h"
+#include "transporte_host.h"
+#include "telemetria.h" // TEMP_Q4_ERROR
+
+// Dobles del hardware para correr la aplicacion en Linux. Cada uno expone
+// lo necesario para manejarlo desde afuera (tocar el panel, fijar una
+// temperatura) y para ver lo que la aplicacion hizo con el.
+
+// Reloj del sistema (steady_clock) con la misma vuelta en 2^32 que micros()
+// y millis(). En modo simulado el tiempo es virtual: solo avanza con
+// avanzar() o esperarMs(), asi que quien lo maneja salta directo al proximo
+// plazo y una semana de operacion corre en segundos, siempre igual.
+class RelojHost : public Reloj
+{
+public:
+  RelojHost();
+  uint32_t micros() override;
+  uint32_t millis() override;
+  void esperarMs(uint32_t ms) override;
+
+  // Pasa a tiempo virtual a partir de inicioUs (64 bits: se puede arrancar
+  // cerca de la vuelta de millis())
+  void simular(uint64_t inicioUs);
+  void avanzar(uint32_t us) { virtualUs_ += us; }
+  bool simulado() const { return simulado_; }
+  uint64_t us64();
+
+private:
+  int64_t origenUs_;
+  bool simulado_;
+  uint64_t virtualUs_;
+};
+
+class GpioHost : public Gpio
+{
+public:
+  static const uint8_t PINES = 40;
+
+  GpioHost();
+  void salida(uint8_t pin) override;
+  void entrada(uint8_t pin) override;
+  void escribir(uint8_t pin, bool alto) override;
+  bool leer(uint8_t pin) override;
+
+  bool esSalida(uint8_t pin) const { return pin < PINES && salida_[pin]; }
+  // Cambios de nivel escritos en una salida
+  uint32_t cambios(uint8_t pin) const { return pin < PINES ? cambios_[pin] : 0; }
+  // Lado externo: lo que ve un pin de entrada
+  void fijar(uint8_t pin, bool alto);
+
+private:
+  bool nivel_[PINES];
+  bool salida_[PINES];
+  uint32_t cambios_[PINES];
+};
+
+// No dibuja: cuenta operaciones y guarda el ultimo texto
+class PantallaHost : public Pantalla
+{
+public:
+  PantallaHost();
+  void iniciar() override { operaciones_++; }
+  void encender(bool encendida) override { encendida_ = encendida; }
+  void rellenar(int16_t, int16_t, int16_t, int16_t, uint16_t) override { operaciones_++; }
+  void rellenarRedondeado(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t) override { operaciones_++; }
+  void bordeRedondeado(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t) override { operaciones_++; }
+  void lineaHorizontal(int16_t, int16_t, int16_t, uint16_t) override { operaciones_++; }
+  void textoCentrado(const char *texto, int16_t x, int16_t y, uint8_t fuente, uint16_t color,
+                     uint32_t fondo) override;
+
+  uint32_t operaciones() const { return operaciones_; }
+  bool encendida() const { return encendida_; }
+  const char *ultimoTexto() const { return ultimoTexto_; }
+
+private:
+  uint32_t operaciones_;
+  bool encendida_;
+  char ultimoTexto_[32];
+};
+
+class TactilHost : public Tactil
+{
+public:
+  TactilHost();
+  bool leer(uint16_t &x, uint16_t &y) override; // Cuenta una transaccion SPI
+  bool presionado() override { return tocando_; }
+  void calibracion(const uint16_t[5]) override {}
+  void calibrar(uint16_t datos[5]) override;
+
+  // Dedo en (x, y) en coordenadas de pantalla hasta soltar()
+  void tocar(uint16_t x, uint16_t y);
+  void soltar() { tocando_ = false; }
+  // Lecturas del panel (en el XPT2046, una rafaga SPI cada una)
+  uint32_t lecturas() const { return lecturas_; }
+
+private:
+  bool tocando_;
+  uint32_t lecturas_;
+  uint16_t x_;
+  uint16_t y_;
+};
+
+class SensoresHost : public SensoresTemperatura
+{
+public:
+  SensoresHost();
+  void iniciar() override {}
+  void pedirConversion() override { conversiones_++; }
+  uint32_t msConversion() override { return 750; } // DS18B20 a 12 bits
+  int16_t leerQ4(uint8_t indice) override { return indice < 2 ? q4_[indice] : TEMP_Q4_ERROR; }
+
+  void fijar(uint8_t indice, int16_t q4);
+  uint32_t conversiones() const { return conversiones_; }
+
+private:
+  int16_t q4_[2];
+  uint32_t conversiones_;
+};
+
+// A stdout. El CRC de todo lo escrito permite comparar dos corridas aunque
+// la salida este silenciada.
+class ConsolaHost : public Consola
+{
+public:
+  ConsolaHost() : silenciada_(false), crc_(0), lineas_(0) {}
+  void escribir(const char *texto) override;
+  bool hayEntrada() override { return false; }
+
+  void silenciar(bool silenciada) { silenciada_ = silenciada; }
+  uint32_t crc() const { return crc_; }
+  uint32_t lineas() const { return lineas_; }
+
+private:
+  bool silenciada_;
+  uint32_t crc_;
+  uint32_t lineas_;
+};
+
+// Archivos dentro de un directorio del host (se crea si no existe)
+class ArchivosHost : public SistemaArchivos
+{
+public:
+  explicit ArchivosHost(const char *directorio);
+  bool existe(const char *ruta) override;
+  bool borrar(const char *ruta) override;
+  size_t leer(const char *ruta, size_t desde, void *datos, size_t len) override;
+  size_t escribir(const char *ruta, const void *datos, size_t len) override;
+
+  // Cambiarlo antes de iniciarHal()
+  void directorio(const char *directorio) { directorio_ = directorio; }
+  // Ruta del host para un archivo del sistema simulado
+  void completar(const char *ruta, char *completa, size_t cap);
+
+private:
+  const char *directorio_;
+};
+
+class PlataformaHost : public Plataforma
+{
+public:
+  PlataformaHost() : mhz_(240), minimoLibre_(UINT32_MAX) {}
+  void frecuenciaCpu(uint32_t mhz) override { mhz_ = mhz; }
+  uint32_t mhz() const { return mhz_; }
+  // Lo libre dentro de las arenas de glibc. No informa el mayor bloque: se
+  // da el libre entero (sin fragmentacion que ver en el host).
+  EstadoMemoria memoria() override;
+
+private:
+  uint32_t mhz_;
+  uint32_t minimoLibre_;
+};
+
+// Las instancias concretas detras de las referencias de hal.h
+extern RelojHost relojHost;
+extern GpioHost gpioHost;
+extern PantallaHost pantallaHost;
+extern TactilHost tactilHost;
+extern SensoresHost sensoresHost;
+extern ConsolaHost consolaHost;
+extern ArchivosHost archivosHost;
+extern PlataformaHost plataformaHost;
+extern TransporteHost transporteHost; // PTY: ver rutaPty()
+extern FlashEmulada flashHost;
+
+// Imagen de la particion del registro entre corridas, dentro del directorio
+// de archivosHost
+#define ARCHIVO_FLASH_HOST "/datalog.bin"
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef ARDUINO
+
+// --- Lazo cooperativo del host ---
+// Las cuatro tareas corren en un solo hilo: en cada vuelta se atiende, por
+// prioridad, la que tiene un aviso o un trabajo vencido. Lo usan
+// main_host.cpp y las pruebas de test/.
+
+// Engancha los avisos de las tareas (despues de iniciarAplicacion()). Como
+// en el ESP32, cada tarea da su primer paso en la proxima vuelta.
+void iniciarTareasHost();
+// Una vuelta. Devuelve cuantas tareas corrieron.
+uint32_t correrTareasHost();
+// Cuanto esperar hasta la proxima activacion o aviso, como mucho maximoUs
+// (0 si hay un aviso pendiente, UINT32_MAX si no hay nada y maximoUs lo es).
+uint32_t esperaHost(uint32_t maximoUs);
+// Corre 'us' de tiempo virtual (relojHost.simular()) saltando de plazo en
+// plazo. Devuelve cuantas activaciones hubo.
+uint64_t simularHost(uint64_t us);
+
+// Estado limpio para una corrida reproducible, antes de iniciarAplicacion():
+// reloj virtual desde relojInicialUs, 'directorio' sin ajustes ni registro
+// y ajustes sembrados en AUTO con la calibracion del tactil ya confirmada.
+void prepararHost(const char *directorio, uint64_t relojInicialUs);
+// Apoya el dedo en (x, y) y levanta PENIRQ como la interrupcion; sigue
+// apoyado hasta tactilHost.soltar().
+void tocarHost(uint16_t x, uint16_t y);
+// Toque completo: 100 ms apoyado y 400 ms despues de soltar para que la
+// interfaz termine de responder.
+void pulsarHost(uint16_t x, uint16_t y);
+
+// --- Cliente de BT ---
+// Abre el esclavo de un PTY crudo y sin bloqueo, como una terminal serie.
+// Devuelve el descriptor o -1.
+int abrirClientePty(const char *ruta);
+// El del enlace de la aplicacion (transporteHost), ya iniciado con BT ON.
+int abrirClienteBT();
+// Escribe la linea entera y espera a que el kernel la pase al master, para
+// que la proxima vuelta de la tarea bt ya la vea. false si no se pudo.
+bool enviarBT(int cliente, const char *linea);
+
+#endif
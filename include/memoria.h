@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- Memoria dinamica ---
+// Pasado el arranque el firmware no pide memoria: lo periodico trabaja sobre
+// buffers fijos, asi que el heap no se fragmenta aunque corra meses. Para
+// comprobarlo se cuentan los pedidos al heap (memoria.cpp): operator
+// new/delete y malloc/calloc/realloc/free, envueltos en el enlace con
+// -Wl,--wrap (platformio.ini). Asi entran String, Print::printf y File del
+// core de Arduino y las bibliotecas y componentes del IDF enlazados
+// estaticamente. Quedan afuera el codigo en ROM, lo que se pide con
+// heap_caps_malloc() directo (parte del stack BT) y, en el host, lo que
+// piden por dentro las bibliotecas compartidas (glibc, libstdc++); eso se ve
+// en el libre y el mayor bloque que informa la plataforma.
+// Los contadores son globales: una etapa que mide sus asignaciones tambien
+// cuenta las de otra tarea que la desaloje, asi que es una cota superior.
+
+struct EstadoMemoria
+{
+  uint32_t libre;       // Bytes libres del heap
+  uint32_t minimoLibre; // Lo minimo que quedo libre desde el arranque
+  uint32_t mayorBloque; // El pedido mas grande que podria atenderse ahora
+};
+
+// Pedidos y devoluciones al heap desde el arranque. Un realloc que pide
+// memoria cuenta como asignacion; realloc(p, 0) como liberacion.
+uint32_t asignaciones();
+uint32_t liberaciones();
+
+// Porcentaje del libre que no esta en el mayor bloque (0: sin fragmentar)
+uint8_t fragmentacion(const EstadoMemoria &m);
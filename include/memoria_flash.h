@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Flash NOR cruda (sin sistema de archivos) ---
+// Semantica NOR: borrar deja el sector en 0xFF y escribir solo puede pasar
+// bits de 1 a 0. Backend ESP32 (particion de datos) y emulador de host.
+
+class MemoriaFlash
+{
+public:
+  static const uint32_t TAM_SECTOR = 4096;
+
+  virtual ~MemoriaFlash() {}
+
+  virtual uint32_t tamano() const = 0;
+  virtual bool leer(uint32_t dir, void *out, size_t len) = 0;
+  virtual bool escribir(uint32_t dir, const void *datos, size_t len) = 0;
+  // dir alineada a TAM_SECTOR.
+  virtual bool borrarSector(uint32_t dir) = 0;
+};
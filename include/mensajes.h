@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include "telemetria.h"
+
+// --- Mensajes entre tareas ---
+// Cada tarea es duena de su estado y solo lo comunica por anillos
+// (anillo_spsc.h): ninguna lee las variables de otra.
+
+enum TipoOrden : uint8_t
+{
+  ORDEN_SISTEMA,     // valor: 0/1, o -1 para alternar (-> control)
+  ORDEN_RELE,        // canal 1/2, valor 0/1; solo en MODO_MANUAL (-> control)
+  ORDEN_MODO,        // valor: ModoControl (-> control)
+  ORDEN_CONSIGNA,    // canal 1/2, valor en decimas (-> control)
+  ORDEN_BLUETOOTH,   // Alterna el BT (interfaz -> comunicaciones)
+  ORDEN_PANTALLA,    // valor 0/1: pantalla apagada/encendida (interfaz -> comunicaciones)
+  ORDEN_ESTADO_BT,   // valor 0/1: BT apagado/encendido (comunicaciones -> interfaz)
+  ORDEN_IMPULSO_CPU, // CPU al maximo ya, sin esperar al gobernador (-> control)
+  ORDEN_PISO_CPU     // valor: frecuencia minima en MHz, 0 la libera (-> control)
+};
+
+struct Orden
+{
+  uint8_t tipo;
+  uint8_t canal;
+  int16_t valor;
+};
+
+// Lo que publica control tras cada lectura o cambio de reles. La muestra
+// lleva K1/K2/SISTEMA; MUESTRA_PANTALLA lo agrega quien la reenvia.
+struct EstadoControl
+{
+  Muestra muestra;
+  uint8_t modo;
+  bool lecturaNueva; // Trae una lectura de sensores (va al registro)
+};
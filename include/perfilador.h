@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bus_spi.h" // HistogramaLatencia
+#include "memoria.h"
+
+// --- Perfilador por etapas ---
+// Mide cuanto tarda cada etapa (conversion del 1-Wire, dibujo, muestreo del
+// tactil, BT...) con el contador de ciclos de la CPU. Cada etapa acumula
+// cantidad, min/media/max y un histograma logaritmico en memoria fija; los
+// tiempos se guardan en nanosegundos, asi que un cambio de frecuencia no
+// mezcla unidades. Tambien cuenta los pedidos al heap que hubo durante cada
+// etapa (memoria.h): fuera del arranque tienen que quedar en cero. Cada
+// etapa la mide una sola tarea; el volcado desde otra solo lee palabras de
+// 32 bits y puede mezclar dos actualizaciones.
+
+// Contador de ciclos libre que da la vuelta en 2^32
+typedef uint32_t (*RelojCiclos)();
+
+// Reloj de la plataforma: ESP.getCycleCount() en el ESP32 y steady_clock en
+// el host, donde un "ciclo" es un nanosegundo (MHZ_CICLOS_HOST).
+uint32_t ciclosCpu();
+static const uint32_t MHZ_CICLOS_HOST = 1000;
+
+struct EstadisticasEtapa
+{
+  uint32_t cantidad;
+  uint32_t minimoNs;
+  uint32_t maximoNs;
+  uint64_t sumaNs;
+  uint32_t asignaciones;
+  HistogramaLatencia histogramaNs;
+
+  uint32_t mediaNs() const { return cantidad ? (uint32_t)(sumaNs / cantidad) : 0; }
+};
+
+class Perfilador
+{
+public:
+  static const uint8_t MAX_ETAPAS = 16;
+
+  // nombres[i] es el nombre de la etapa i; las etapas las numera quien usa
+  // el perfilador (un enum).
+  Perfilador(RelojCiclos reloj, uint32_t mhz, const char *const *nombres, uint8_t cantidad);
+
+  uint32_t ciclos() const { return reloj_(); }
+  // Llamar despues de cada cambio de frecuencia de la CPU
+  void frecuencia(uint32_t mhz);
+  uint32_t frecuencia() const { return mhz_; }
+
+  void registrar(uint8_t etapa, uint32_t ciclos, uint32_t asignaciones);
+  void reiniciar();
+
+  uint8_t cantidad() const { return cantidad_; }
+  const char *nombre(uint8_t etapa) const { return nombres_[etapa]; }
+  const EstadisticasEtapa &estadisticas(uint8_t etapa) const { return etapas_[etapa]; }
+  // Una linea de texto con la etapa (sin salto de linea). Devuelve el largo.
+  size_t describir(uint8_t etapa, char *buf, size_t tam) const;
+
+private:
+  RelojCiclos reloj_;
+  uint32_t mhz_;
+  uint32_t nsPorCicloQ16_; // 1000 / mhz en punto fijo 16.16
+  const char *const *nombres_;
+  uint8_t cantidad_;
+  EstadisticasEtapa etapas_[MAX_ETAPAS];
+};
+
+// Mide el bloque donde se declara:
+//   { SondaEtapa s(perfil, ETAPA_DIBUJO); ... }
+class SondaEtapa
+{
+public:
+  SondaEtapa(Perfilador &perfilador, uint8_t etapa)
+      : perfilador_(perfilador), etapa_(etapa), inicio_(perfilador.ciclos()), asignaciones_(asignaciones())
+  {
+  }
+  ~SondaEtapa() { perfilador_.registrar(etapa_, perfilador_.ciclos() - inicio_, asignaciones() - asignaciones_); }
+
+private:
+  SondaEtapa(const SondaEtapa &);
+  SondaEtapa &operator=(const SondaEtapa &);
+
+  Perfilador &perfilador_;
+  uint8_t etapa_;
+  uint32_t inicio_;
+  uint32_t asignaciones_;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "telemetria.h"
+
+// --- Resumenes del historial en varias resoluciones ---
+// Cada nivel guarda min/max/media por sensor de intervalos fijos (1 min,
+// 1 h) en un anillo de tamano fijo: al llenarse se pisa el intervalo mas
+// viejo. Cada lectura se suma al intervalo abierto de todos los niveles,
+// asi que mantenerlos cuesta lo mismo con cualquier historial.
+
+// Min/max/media de un intervalo. Un sensor sin lecturas validas queda con
+// min > max y media TEMP_Q4_ERROR.
+struct Agregado
+{
+  uint32_t t; // Inicio del intervalo (o marca de la lectura)
+  int16_t minQ4[2];
+  int16_t maxQ4[2];
+  int16_t mediaQ4[2];
+};
+
+class PiramideResumen
+{
+public:
+  static const uint8_t NIVELES = 2;
+  static const uint16_t CAPACIDAD_MINUTOS = 1440; // 24 h
+  static const uint16_t CAPACIDAD_HORAS = 336;    // 14 dias
+  static const uint32_t SEGUNDOS_NIVEL[NIVELES];
+  static const uint16_t CAPACIDAD_NIVEL[NIVELES];
+
+  PiramideResumen() { reiniciar(); }
+
+  void reiniciar();
+  // Las marcas no deben retroceder (RegistroDatos ya las iguala).
+  void agregar(const Lectura &l);
+
+  // Intervalos guardados del nivel, el abierto incluido como el ultimo.
+  uint16_t tamano(uint8_t nivel) const { return usados_[nivel] + (abiertos_[nivel].abierto ? 1 : 0); }
+  Agregado en(uint8_t nivel, uint16_t i) const;
+  // Primera posicion del nivel con inicio >= t (tamano() si no hay).
+  uint16_t buscar(uint8_t nivel, uint32_t t) const;
+  // true si el nivel no descarto nada posterior a t
+  bool cubre(uint8_t nivel, uint32_t t) const
+  {
+    return usados_[nivel] < CAPACIDAD_NIVEL[nivel] || en(nivel, 0).t <= t;
+  }
+  // Segundos hacia atras que cubre el nivel mas grueso lleno.
+  static uint32_t retencion() { return SEGUNDOS_NIVEL[NIVELES - 1] * CAPACIDAD_NIVEL[NIVELES - 1]; }
+  // Media redondeada al mas cercano (tambien con temperaturas negativas)
+  static int16_t media(int32_t suma, uint16_t cantidad);
+
+private:
+  struct Acumulador
+  {
+    uint32_t t;
+    bool abierto;
+    int16_t minQ4[2];
+    int16_t maxQ4[2];
+    int32_t suma[2];
+    uint16_t cantidad[2];
+  };
+
+  void cerrar(uint8_t nivel);
+  static Agregado agregado(const Acumulador &a);
+
+  Agregado datos_[CAPACIDAD_MINUTOS + CAPACIDAD_HORAS];
+  uint16_t primero_[NIVELES];
+  uint16_t usados_[NIVELES];
+  Acumulador abiertos_[NIVELES];
+};
+
+// Junta puntos (agregados o lecturas) en intervalos de 'ancho' segundos a
+// partir de 'desde' para entregar a lo sumo 'max' puntos. Los puntos deben
+// llegar en orden; la media sale de las medias de cada punto.
+class ReductorSerie
+{
+public:
+  ReductorSerie(uint32_t desde, uint32_t ancho, Agregado *out, size_t max)
+      : desde_(desde), ancho_(ancho), out_(out), max_(max), n_(0), abierto_(false)
+  {
+  }
+
+  void sumar(const Agregado &g);
+  void sumar(const Lectura &l);
+  // Cierra el ultimo intervalo y devuelve cuantos puntos se escribieron.
+  size_t terminar();
+
+private:
+  void cerrar();
+
+  uint32_t desde_;
+  uint32_t ancho_;
+  Agregado *out_;
+  size_t max_;
+  size_t n_;
+  bool abierto_;
+  uint32_t intervalo_;
+  Agregado actual_;
+  int32_t suma_[2];
+  uint16_t cantidad_[2];
+};
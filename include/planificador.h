@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bus_spi.h" // RelojMicros, HistogramaLatencia
+
+// --- Planificador cooperativo por plazos ---
+// Trabajos periodicos y de una vez, cada uno con periodo, plazo y
+// presupuesto. Los que esperan su activacion estan en un monticulo por hora
+// de activacion; los ya activados corren de a uno, el de plazo mas cercano
+// primero. Nada se interrumpe: un trabajo largo atrasa a los demas y eso
+// queda en sus histogramas. Solo depende del reloj inyectado, asi que en el
+// host corre igual con un reloj simulado.
+
+typedef void (*FuncionTrabajo)();
+
+struct EstadisticasTrabajo
+{
+  HistogramaLatencia retraso;  // Inicio real respecto de la activacion
+  HistogramaLatencia duracion;
+  uint32_t vencidos;  // Terminaron despues del plazo
+  uint32_t excedidos; // Duraron mas que el presupuesto
+  uint32_t omitidos;  // Activaciones periodicas salteadas por atraso
+};
+
+class Planificador
+{
+public:
+  static const uint8_t MAX_TRABAJOS = 4; // Por tarea
+  static const uint8_t SIN_TRABAJO = 0xFF;
+
+  explicit Planificador(RelojMicros reloj);
+
+  // Trabajo periodico, primera activacion dentro de faseUs. plazoUs es
+  // relativo a cada activacion (0 = el periodo). Devuelve el id o
+  // SIN_TRABAJO si no hay lugar.
+  uint8_t periodico(const char *nombre, FuncionTrabajo funcion, uint32_t periodoUs, uint32_t plazoUs,
+                    uint32_t presupuestoUs, uint32_t faseUs = 0);
+  // Trabajo de una vez: queda inactivo hasta que se lo activa.
+  uint8_t unaVez(const char *nombre, FuncionTrabajo funcion, uint32_t plazoUs, uint32_t presupuestoUs);
+
+  // Activa el trabajo dentro de demoraUs; si ya estaba pendiente lo
+  // reprograma. Un periodico sigue con su periodo desde ahi.
+  void activar(uint8_t id, uint32_t demoraUs = 0);
+  // Saca el trabajo de la planificacion hasta el proximo activar().
+  void pausar(uint8_t id);
+  bool activo(uint8_t id) const { return id < cantidad_ && trabajos_[id].estado != INACTIVO; }
+
+  // Corre los trabajos ya activados, como mucho uno por trabajo. Devuelve
+  // cuantos corrieron.
+  uint8_t ejecutar();
+  // Microsegundos hasta la proxima activacion: 0 si hay alguno listo,
+  // UINT32_MAX si no hay ninguno pendiente.
+  uint32_t hastaProximo() const;
+
+  uint8_t cantidad() const { return cantidad_; }
+  const char *nombre(uint8_t id) const { return trabajos_[id].nombre; }
+  const EstadisticasTrabajo &estadisticas(uint8_t id) const { return trabajos_[id].estadisticas; }
+  void reiniciarEstadisticas();
+  // Plazos vencidos de todos los trabajos desde el arranque (no se reinicia)
+  uint32_t vencidos() const { return vencidos_; }
+
+private:
+  enum Estado : uint8_t
+  {
+    INACTIVO,
+    ESPERANDO, // En el monticulo de activacion
+    LISTO,     // En el monticulo de plazos
+    CORRIENDO
+  };
+
+  struct Trabajo
+  {
+    const char *nombre;
+    FuncionTrabajo funcion;
+    uint32_t periodoUs; // 0 en los de una vez
+    uint32_t plazoUs;
+    uint32_t presupuestoUs;
+    uint32_t activacion; // Absolutos, en el reloj del planificador
+    uint32_t plazo;
+    Estado estado;
+    EstadisticasTrabajo estadisticas;
+  };
+
+  struct Monticulo
+  {
+    uint8_t ids[MAX_TRABAJOS];
+    uint8_t cantidad;
+    bool porPlazo; // Clave: plazo (listos) o activacion (esperando)
+  };
+
+  uint8_t agregar(const char *nombre, FuncionTrabajo funcion, uint32_t periodoUs, uint32_t plazoUs,
+                  uint32_t presupuestoUs);
+  void programar(uint8_t id, uint32_t activacion);
+  void liberar(uint32_t ahora);
+
+  bool antes(const Monticulo &m, uint8_t a, uint8_t b) const;
+  void subir(Monticulo &m, uint8_t pos);
+  void bajar(Monticulo &m, uint8_t pos);
+  void insertar(Monticulo &m, uint8_t id);
+  uint8_t extraer(Monticulo &m);
+  void quitar(Monticulo &m, uint8_t id);
+
+  RelojMicros reloj_;
+  Trabajo trabajos_[MAX_TRABAJOS];
+  uint8_t cantidad_;
+  uint32_t vencidos_;
+  Monticulo esperando_;
+  Monticulo listos_;
+};
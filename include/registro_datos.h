@@ -0,0 +1,176 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "memoria_flash.h"
+#include "telemetria.h"
+#include "compresion.h"
+#include "piramide.h"
+#include "bus_spi.h" // RelojMicros
+
+// --- Registro de temperaturas en flash (solo agregar) ---
+// La flash se divide en segmentos de un sector que se usan en circulo: al
+// llenarse se pisa el mas viejo, asi que todos los sectores se borran por
+// igual. Cada segmento empieza con una cabecera (secuencia + primer indice)
+// y contiene lotes de lecturas con su CRC; cada lote es un bloque comprimido
+// (compresion.h) que se decodifica solo. Las lecturas se numeran con un
+// indice global que no se reinicia al rotar.
+//
+// Un corte de energia a mitad de escritura deja un lote con CRC invalido: al
+// arrancar se descarta y el segmento se cierra, y lo siguiente va a uno nuevo.
+//
+// Indice disperso en dos niveles para consultas por rango: en RAM un resumen
+// por segmento (primer indice, primera marca, min/max), y en flash la
+// cabecera de cada lote (min/max) seguida de su primera marca. Una consulta
+// busca el segmento en RAM, recorre solo cabeceras de ese segmento y
+// decodifica solo los lotes de los bordes.
+//
+// Ademas mantiene en RAM resumenes por minuto y por hora (piramide.h) que
+// se rearman desde la flash al arrancar.
+//
+// Las lecturas del lote que todavia se arma en RAM ya tienen indice: leer,
+// buscar y resumir las sirven desde el bloque en memoria, asi una consulta
+// no obliga a escribir un lote a medio llenar.
+
+struct EstadisticasRegistro
+{
+  uint32_t lotes;             // Lotes escritos
+  uint32_t bytesEscritos;     // Bytes de lotes y cabeceras de segmento
+  uint32_t borrados;          // Sectores borrados
+  uint32_t borradosEnLinea;   // Borrados que tuvo que esperar una escritura de lote
+  uint32_t ultimaEscrituraUs; // Bloqueo de la ultima escritura de lote
+  uint32_t peorEscrituraUs;   // Peor bloqueo de una escritura de lote
+  uint32_t sellados;          // Segmentos cerrados por un lote incompleto
+  uint32_t errores;           // Lotes perdidos por errores de flash
+  uint32_t cabecerasLeidas;   // Cabeceras de lote leidas por consultas y lecturas
+  uint32_t lotesDecodificados;
+};
+
+// Min/max por sensor de un rango. Sin lecturas validas, min > max.
+struct ResumenLecturas
+{
+  int16_t minQ4[2];
+  int16_t maxQ4[2];
+};
+
+class RegistroDatos
+{
+public:
+  static const uint16_t MAX_SEGMENTOS = 256;
+  static const uint8_t LECTURAS_POR_LOTE = 32; // Agrupa escrituras (~64 s a 2 s por lectura)
+
+  RegistroDatos(MemoriaFlash &flash, RelojMicros reloj);
+
+  // Recorre las cabeceras de todos los segmentos para reconstruir el indice
+  // y ubicar el punto de escritura. false si la flash no alcanza.
+  bool begin();
+
+  // Las marcas nunca retroceden: una marca menor a la ultima se iguala.
+  void agregar(const Lectura &l);
+  // Escribe en flash las lecturas que esperan en RAM.
+  void vaciar();
+  // Borra por adelantado el proximo segmento para que la escritura que
+  // rota no tenga que esperar el borrado. Llamar con tiempo libre.
+  void mantenimiento();
+
+  // Indices disponibles: [inicio(), fin()), con el lote en RAM al final
+  uint32_t inicio() const { return listo_ ? resumenes_[cola_].primerIndice : 0; }
+  uint32_t fin() const { return proximoIndice_ + codificador_.cantidad(); }
+  uint32_t ultimaMarca() const { return ultimaMarca_; }
+
+  // Copia hasta max lecturas desde indice sin cruzar de lote. Devuelve cuantas.
+  size_t leer(uint32_t indice, Lectura *out, size_t max);
+
+  // Primer indice con marca >= t (fin() si no hay ninguno).
+  uint32_t buscarMarca(uint32_t t);
+  // Min/max de las lecturas [desde, hasta). Los segmentos y lotes completos
+  // salen del indice; solo se decodifican los lotes de los bordes.
+  void resumir(uint32_t desde, uint32_t hasta, ResumenLecturas &r);
+  // Hasta maxPuntos agregados del intervalo de marcas [desde, hasta) para
+  // graficos y resumenes. Usa el nivel mas grueso que todavia da maxPuntos
+  // puntos (si ninguno alcanza, el que mas tenga) y junta lo que sobre.
+  // nivel: 0 lecturas de flash, 1 + nivel de la piramide.
+  size_t serie(uint32_t desde, uint32_t hasta, Agregado *out, size_t maxPuntos, uint8_t &nivel);
+  const PiramideResumen &piramide() const { return piramide_; }
+
+  const EstadisticasRegistro &estadisticas() const { return estadisticas_; }
+
+private:
+  struct CabeceraSegmento
+  {
+    uint32_t magia;
+    uint32_t secuencia;
+    uint32_t primerIndice;
+    uint16_t version;
+    uint16_t crc;
+  };
+
+  struct CabeceraLote
+  {
+    uint16_t largo; // Bytes de datos despues de la cabecera
+    uint8_t cantidad;
+    uint8_t formato; // Se pone en 0 al cerrar un segmento en un lote invalido
+    int16_t minQ4[2];
+    int16_t maxQ4[2];
+    uint16_t crc; // De los campos anteriores y los datos
+  };
+
+  struct ResumenSegmento
+  {
+    uint32_t primerIndice;
+    uint32_t primeraMarca; // UINT32_MAX mientras no tenga lotes
+    ResumenLecturas lecturas;
+  };
+
+  static const uint16_t MAX_DATOS_LOTE = CodificadorBloque::maxBytes(LECTURAS_POR_LOTE);
+
+  uint32_t direccion(uint16_t segmento, uint32_t pos) const { return segmento * MemoriaFlash::TAM_SECTOR + pos; }
+  uint16_t segmentoEn(uint16_t orden) const { return (cola_ + orden) % segmentos_; }
+  uint16_t cantidadSegmentos() const { return (cabeza_ + segmentos_ - cola_) % segmentos_ + 1; }
+  uint16_t segmentoDe(uint32_t indice) const;
+
+  bool leerCabecera(uint16_t segmento, CabeceraSegmento &cab);
+  // Cabecera del lote en pos y la marca de su primera lectura, sin leer los
+  // datos. false en la zona borrada o en un lote invalido.
+  bool leerCabeceraLote(uint16_t segmento, uint32_t pos, CabeceraLote &cab, uint32_t &primeraMarca);
+  bool leerDatosLote(uint16_t segmento, uint32_t pos, const CabeceraLote &cab, uint8_t *datos);
+  size_t decodificarLote(uint16_t segmento, uint32_t pos, const CabeceraLote &cab, size_t desde, Lectura *out,
+                         size_t max);
+  // Lo mismo sobre el lote en RAM (indices desde proximoIndice_)
+  size_t decodificarPendientes(size_t desde, Lectura *out, size_t max) const;
+  uint32_t buscarMarcaFlash(uint32_t t);
+  bool recorrerSegmento(uint16_t segmento, bool verificar, uint32_t &pos, uint32_t &cantidad, uint32_t &posUltimo);
+  bool restoBorrado(uint16_t segmento, uint32_t pos);
+  void cerrarEn(uint16_t segmento, uint32_t pos);
+  bool abrirSegmento(uint16_t segmento, uint32_t secuencia);
+  // Pasa al segmento siguiente; si no puede, el activo queda sellado
+  bool rotar();
+
+  MemoriaFlash &flash_;
+  RelojMicros reloj_;
+  bool listo_;
+  uint16_t segmentos_;
+  uint16_t cabeza_;   // Segmento activo
+  uint16_t cola_;     // Segmento mas viejo con datos
+  uint32_t posicion_; // Proximo byte libre del segmento activo
+  uint32_t secuencia_;
+  bool sellado_;               // El segmento activo no admite mas lotes
+  bool siguientePreparado_;    // El segmento que sigue ya esta borrado
+  uint32_t proximoIndice_; // Primer indice que no esta en flash
+  uint32_t ultimaMarca_;
+  ResumenSegmento resumenes_[MAX_SEGMENTOS];
+
+  // Lote en armado: cabecera + bloque que se va comprimiendo al agregar
+  uint8_t lote_[sizeof(CabeceraLote) + MAX_DATOS_LOTE];
+  CodificadorBloque codificador_;
+  ResumenLecturas resumenLote_;
+  PiramideResumen piramide_;
+
+  // Ultimo lote leido: una descarga secuencial no vuelve a recorrer el segmento
+  uint16_t cursorSegmento_;
+  uint32_t cursorPos_;
+  uint32_t cursorIndice_;
+  bool cursorValido_;
+
+  EstadisticasRegistro estadisticas_;
+};
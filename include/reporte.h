@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Formateo del reporte de estado sin memoria dinamica ---
+// Escribe sobre un buffer provisto por el llamador y trunca si no alcanza.
+
+static const size_t TAM_REPORTE = 160;
+
+struct DatosReporte
+{
+  int16_t tempQ4[2]; // 1/16 de grado, como Muestra
+  bool valida[2];
+  bool k1;
+  bool k2;
+  bool sistema;
+  bool pantalla;
+};
+
+// Escritor acotado sobre un buffer fijo; siempre deja el texto terminado en '\0'.
+class EscritorTexto
+{
+public:
+  EscritorTexto(char *buf, size_t cap) : buf_(buf), cap_(cap), len_(0) { buf_[0] = '\0'; }
+
+  EscritorTexto &texto(const char *s);
+  EscritorTexto &caracter(char c);
+  EscritorTexto &entero(uint32_t v);
+  // Temperatura en 1/16 de grado con una decimal, igual que String(q4 / 16.0, 1)
+  EscritorTexto &celsiusQ4(int16_t q4);
+
+  size_t largo() const { return len_; }
+  const char *c_str() const { return buf_; }
+
+private:
+  char *buf_;
+  size_t cap_;
+  size_t len_;
+};
+
+// Decimas de q4 / 16 tal como las imprime dtostrf(valor, 3, 1) (String(valor, 1))
+// para |t| < 128 C, solo con enteros. El signo se devuelve aparte.
+uint32_t q4ADecimasReporte(int16_t q4, bool &negativo);
+
+size_t formatearReporte(char *buf, size_t cap, const DatosReporte &d);
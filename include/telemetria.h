@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Telemetria binaria ---
+// Trama: COBS( tipo | secuencia | carga | crc16 LE ) seguida de 0x00.
+// El 0x00 solo aparece como delimitador, asi que el receptor se resincroniza
+// en la proxima trama si pierde bytes.
+
+#define TELEMETRIA_VERSION 1
+
+enum TipoTrama : uint8_t
+{
+  TRAMA_HOLA = 0x00,     // version(u8): confirma el cambio a modo binario
+  TRAMA_MUESTRAS = 0x01, // n(u8) + n registros de MUESTRA_BYTES
+  TRAMA_ESTADO = 0x02,   // Reemplaza al reporte de texto en modo binario
+  TRAMA_HIST = 0x03,     // indice(u16) + primera lectura(u32) + registros de Lectura
+  TRAMA_HIST_FIN = 0x04  // proxima lectura(u32): la descarga llego al final
+};
+
+static const size_t MAX_CARGA_TRAMA = 128;
+// tipo + secuencia + carga + crc, mas el peor caso de COBS y el delimitador
+static const size_t MAX_TRAMA = 2 + MAX_CARGA_TRAMA + 2 + (2 + MAX_CARGA_TRAMA + 2) / 254 + 2;
+
+// Temperaturas en 1/16 de grado (resolucion nativa del DS18B20)
+static const int16_t TEMP_Q4_ERROR = INT16_MIN;
+
+enum BanderaMuestra : uint8_t
+{
+  MUESTRA_K1 = 0x01,
+  MUESTRA_K2 = 0x02,
+  MUESTRA_SISTEMA = 0x04,
+  MUESTRA_PANTALLA = 0x08,
+  MUESTRA_HORA_VALIDA = 0x10 // La marca de la Lectura es hora real (HORA)
+};
+
+struct Muestra
+{
+  uint32_t ms;
+  int16_t tempQ4[2];
+  uint8_t banderas;
+};
+
+// Muestra guardada en el registro de flash. La marca es en segundos: hora
+// real si MUESTRA_HORA_VALIDA, si no sigue desde la ultima marca guardada.
+struct Lectura
+{
+  uint32_t t;
+  int16_t tempQ4[2];
+  uint8_t banderas;
+};
+
+static const size_t HIST_CABECERA_BYTES = 6;
+static const size_t HIST_DATOS_BYTES = 112;
+
+static const size_t MUESTRA_BYTES = 9; // ms(4) + t1(2) + t2(2) + banderas(1), LE
+static const size_t HIST_LECTURAS = HIST_DATOS_BYTES / MUESTRA_BYTES; // Lectura usa el mismo formato
+// Muestra + modo(1) + consignas en decimas (2 x int16 LE)
+static const size_t ESTADO_BYTES = MUESTRA_BYTES + 5;
+
+int16_t celsiusAQ4(float celsius);
+int16_t q4ADecimas(int16_t q4); // Redondeado al mas cercano
+size_t empaquetarMuestra(const Muestra &m, uint8_t *out);
+void desempaquetarMuestra(const uint8_t *in, Muestra &m);
+size_t empaquetarLectura(const Lectura &l, uint8_t *out);
+void desempaquetarLectura(const uint8_t *in, Lectura &l);
+size_t empaquetarEstado(const Muestra &m, uint8_t modo, const int16_t consigna[2], uint8_t *out);
+size_t empaquetarCabeceraHist(uint16_t indice, uint32_t offset, uint8_t *out);
+
+// COBS. codificar() escribe como mucho n + n/254 + 1 bytes (sin el 0x00 final).
+size_t cobsCodificar(const uint8_t *in, size_t n, uint8_t *out);
+// Devuelve los bytes decodificados, o 0 si la entrada no es COBS valido.
+size_t cobsDecodificar(const uint8_t *in, size_t n, uint8_t *out);
+
+class CodificadorTramas
+{
+public:
+  CodificadorTramas() : secuencia_(0) {}
+  // Arma la trama completa (con delimitador) en out. Devuelve su longitud.
+  size_t codificar(uint8_t tipo, const uint8_t *carga, size_t len, uint8_t *out);
+
+private:
+  uint8_t secuencia_;
+};
+
+class DecodificadorTramas
+{
+public:
+  DecodificadorTramas() : len_(0), descartadas_(0) {}
+
+  // Consume un byte. Devuelve true cuando hay una trama valida disponible.
+  bool consumir(uint8_t b);
+
+  uint8_t tipo() const { return trama_[0]; }
+  uint8_t secuencia() const { return trama_[1]; }
+  const uint8_t *carga() const { return trama_ + 2; }
+  size_t largoCarga() const { return largo_ - 4; }
+  uint32_t descartadas() const { return descartadas_; }
+
+private:
+  uint8_t crudo_[MAX_TRAMA];
+  uint8_t trama_[MAX_TRAMA];
+  size_t len_;
+  size_t largo_;
+  uint32_t descartadas_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Transporte de bytes para el enlace de comandos/telemetria ---
+// Backend ESP32 (SPP) y backend de host (socketpair o pty) con la misma
+// interfaz, para poder ejercitar comandos, streaming y reportes en Linux.
+
+enum EventoTransporte : uint8_t
+{
+  TRANSPORTE_CONECTADO,
+  TRANSPORTE_DESCONECTADO,
+  TRANSPORTE_CONGESTIONADO,
+  TRANSPORTE_DESCONGESTIONADO
+};
+
+// Puede invocarse desde otro contexto (la tarea del stack BT en el ESP32).
+typedef void (*ManejadorTransporte)(EventoTransporte evento);
+
+class Transporte
+{
+public:
+  virtual ~Transporte() {}
+
+  virtual bool iniciar(const char *nombre) = 0;
+  virtual void detener() = 0;
+  virtual bool hayCliente() = 0;
+
+  // Lectura no bloqueante: disponible() bytes se pueden leer ya.
+  virtual int disponible() = 0;
+  virtual int leer() = 0;
+  // Devuelve cuantos bytes acepto (puede ser menos que len).
+  virtual size_t escribir(const uint8_t *datos, size_t len) = 0;
+
+  void alEvento(ManejadorTransporte manejador) { manejador_ = manejador; }
+
+protected:
+  void notificar(EventoTransporte evento)
+  {
+    if (manejador_)
+      manejador_(evento);
+  }
+
+private:
+  ManejadorTransporte manejador_ = nullptr;
+};
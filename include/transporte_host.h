@@ -0,0 +1,56 @@
+#pragma once
+
+#include "transporte.h"
+
+#ifndef ARDUINO
+
+// Backend de host para el enlace BT. Con PAR_SOCKETS el arnes de prueba hace
+// de cliente sobre el otro extremo de un socketpair; con PTY un programa
+// externo (terminal, script) abre la ruta que informa rutaPty().
+// Las escrituras no bloquean: si el otro extremo no lee, se informa
+// congestion igual que el SPP real, y hayCliente() informa el fin de la
+// congestion en cuanto se puede volver a escribir.
+class TransporteHost : public Transporte
+{
+public:
+  enum Modo : uint8_t
+  {
+    PAR_SOCKETS,
+    PTY
+  };
+
+  explicit TransporteHost(Modo modo = PAR_SOCKETS);
+  ~TransporteHost() override;
+
+  bool iniciar(const char *nombre) override;
+  void detener() override;
+  bool hayCliente() override;
+  int disponible() override;
+  int leer() override;
+  size_t escribir(const uint8_t *datos, size_t len) override;
+
+  // Solo PAR_SOCKETS: abre un cliente y devuelve su descriptor.
+  int conectarCliente();
+  void desconectarCliente();
+
+  // Solo PTY: ruta del esclavo (p.ej. /dev/pts/3).
+  const char *rutaPty() const { return rutaPty_; }
+
+private:
+  void sondear();
+  void marcarDesconectado();
+  void rellenar();
+
+  Modo modo_;
+  int fd_;
+  int fdCliente_;
+  bool conectado_;
+  bool congestionado_;
+  char rutaPty_[64];
+  // FIONREAD no funciona sobre el master de un pty: se lee por adelantado
+  uint8_t entrada_[256];
+  size_t inicioEntrada_;
+  size_t finEntrada_;
+};
+
+#endif
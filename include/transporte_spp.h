@@ -0,0 +1,28 @@
+#pragma once
+
+#include "transporte.h"
+
+#ifdef ARDUINO
+#include "BluetoothSerial.h"
+
+// Bluetooth clasico SPP (BluetoothSerial). Los eventos del stack llegan por
+// un callback estatico, asi que solo puede haber una instancia.
+class TransporteSPP : public Transporte
+{
+public:
+  TransporteSPP();
+
+  bool iniciar(const char *nombre) override;
+  void detener() override;
+  bool hayCliente() override { return serial_.hasClient(); }
+  int disponible() override { return serial_.available(); }
+  int leer() override { return serial_.read(); }
+  size_t escribir(const uint8_t *datos, size_t len) override { return serial_.write(datos, len); }
+
+private:
+  static void callbackSPP(esp_spp_cb_event_t evento, esp_spp_cb_param_t *param);
+  static TransporteSPP *instancia_;
+
+  BluetoothSerial serial_;
+};
+#endif
@@ -0,0 +1,274 @@
+#include "ajustes.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "crc.h"
+
+static const uint32_t MAGIA_AJUSTES = 0x54534A41; // "AJST"
+static const char *const RUTAS_AJUSTES[2] = {"/ajustes_a.bin", "/ajustes_b.bin"};
+static const char *const RUTA_LEGADO = "/TouchCalData"; // 14 bytes sin cabecera
+
+// Largo de la carga util de cada version (indice = version). Coincide con
+// el struct crudo de la version 1 sin los 2 bytes de relleno del final, asi
+// que esos registros se leen igual.
+static const uint16_t LARGO_CARGA[AJUSTES_VERSION + 1] = {0, 30};
+static const uint16_t MAX_CARGA = 30;
+
+// --- Carga util en little endian ---
+static void escribirU16(uint8_t *&p, uint16_t v)
+{
+  *p++ = (uint8_t)v;
+  *p++ = (uint8_t)(v >> 8);
+}
+
+static void escribirFloat(uint8_t *&p, float f)
+{
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  escribirU16(p, (uint16_t)v);
+  escribirU16(p, (uint16_t)(v >> 16));
+}
+
+static size_t empaquetar(const Ajustes &a, uint8_t *out)
+{
+  uint8_t *p = out;
+  escribirFloat(p, a.kp);
+  escribirFloat(p, a.ki);
+  escribirFloat(p, a.kd);
+  for (uint8_t i = 0; i < 2; i++)
+    escribirU16(p, (uint16_t)a.consigna[i]);
+  escribirU16(p, (uint16_t)a.histeresis);
+  for (uint8_t i = 0; i < 5; i++)
+    escribirU16(p, a.calTactil[i]);
+  *p++ = a.calValida;
+  *p++ = a.modo;
+  return (size_t)(p - out);
+}
+
+// Lee los campos que entran enteros en 'largo' bytes; los demas no se tocan
+class LectorCarga
+{
+public:
+  LectorCarga(const uint8_t *in, size_t largo) : p_(in), resto_(largo) {}
+
+  void u8(uint8_t &v)
+  {
+    if (resto_ < 1)
+      return;
+    v = *p_++;
+    resto_--;
+  }
+  void u16(uint16_t &v)
+  {
+    if (resto_ < 2)
+    {
+      resto_ = 0;
+      return;
+    }
+    v = (uint16_t)(p_[0] | (p_[1] << 8));
+    p_ += 2;
+    resto_ -= 2;
+  }
+  void i16(int16_t &v)
+  {
+    uint16_t u = (uint16_t)v;
+    u16(u);
+    v = (int16_t)u;
+  }
+  void real(float &f)
+  {
+    if (resto_ < 4)
+    {
+      resto_ = 0;
+      return;
+    }
+    uint32_t v = (uint32_t)p_[0] | ((uint32_t)p_[1] << 8) | ((uint32_t)p_[2] << 16) | ((uint32_t)p_[3] << 24);
+    memcpy(&f, &v, sizeof(f));
+    p_ += 4;
+    resto_ -= 4;
+  }
+
+private:
+  const uint8_t *p_;
+  size_t resto_;
+};
+
+static void desempaquetar(const uint8_t *in, size_t largo, Ajustes &a)
+{
+  LectorCarga l(in, largo);
+  l.real(a.kp);
+  l.real(a.ki);
+  l.real(a.kd);
+  for (uint8_t i = 0; i < 2; i++)
+    l.i16(a.consigna[i]);
+  l.i16(a.histeresis);
+  for (uint8_t i = 0; i < 5; i++)
+    l.u16(a.calTactil[i]);
+  l.u8(a.calValida);
+  l.u8(a.modo);
+}
+
+// Bytes de carga que esta version entiende de un registro de 'version'
+static uint16_t largoConocido(uint16_t version)
+{
+  return LARGO_CARGA[version < AJUSTES_VERSION ? version : AJUSTES_VERSION];
+}
+
+AlmacenAjustes::AlmacenAjustes(SistemaArchivos &fs, RelojMicros reloj)
+    : fs_(fs), reloj_(reloj), cargado_(false), valido_(false), ranuraActual_(0), secuencia_(0)
+{
+  porDefecto(datos_);
+  cabeceraOk_[0] = cabeceraOk_[1] = false;
+  memset(&estadisticas_, 0, sizeof(estadisticas_));
+}
+
+void AlmacenAjustes::porDefecto(Ajustes &a)
+{
+  memset(&a, 0, sizeof(a));
+  a.kp = 2.0f;
+  a.ki = 0.1f;
+  a.kd = 0.0f;
+  a.consigna[0] = 250;
+  a.consigna[1] = 250;
+  a.histeresis = 5;
+}
+
+void AlmacenAjustes::begin()
+{
+  for (uint8_t i = 0; i < 2; i++)
+    cabeceraOk_[i] = leerCabecera(i, cabeceras_[i]);
+  cargado_ = false;
+}
+
+bool AlmacenAjustes::leerCabecera(uint8_t ranura, Cabecera &cab)
+{
+  if (!fs_.existe(RUTAS_AJUSTES[ranura]))
+    return false;
+  if (fs_.leer(RUTAS_AJUSTES[ranura], 0, &cab, sizeof(cab)) != sizeof(cab) || cab.magia != MAGIA_AJUSTES)
+    return false;
+  // Version 0 no existe; cualquier otra tiene que traer por lo menos los
+  // campos que esa version (o esta, si es mas nueva) define
+  return cab.version > 0 && cab.longitud >= largoConocido(cab.version);
+}
+
+bool AlmacenAjustes::leerRanura(uint8_t ranura, const Cabecera &cab)
+{
+  // La carga puede ser mas larga que lo que esta version conoce (version
+  // nueva, o el relleno del struct en los registros v1): se verifica
+  // completa y se desempaqueta solo lo conocido.
+  uint32_t crc = crc32(&cab, offsetof(Cabecera, crc));
+  uint8_t carga[MAX_CARGA];
+  uint8_t bloque[32];
+  uint16_t restante = cab.longitud;
+  size_t pos = 0;
+  while (restante > 0)
+  {
+    size_t n = restante < sizeof(bloque) ? restante : sizeof(bloque);
+    if (fs_.leer(RUTAS_AJUSTES[ranura], sizeof(Cabecera) + pos, bloque, n) != n)
+      return false;
+    crc = crc32(bloque, n, crc);
+    if (pos < sizeof(carga))
+      memcpy(carga + pos, bloque, n < sizeof(carga) - pos ? n : sizeof(carga) - pos);
+    pos += n;
+    restante -= n;
+  }
+  if (crc != cab.crc)
+    return false;
+
+  Ajustes leido;
+  porDefecto(leido);
+  desempaquetar(carga, largoConocido(cab.version), leido);
+  datos_ = leido;
+  return true;
+}
+
+void AlmacenAjustes::cargar()
+{
+  if (cargado_)
+    return;
+  cargado_ = true;
+
+  // Primero la ranura con secuencia mas alta; si su CRC falla, la otra
+  uint8_t orden[2] = {0, 1};
+  if (cabeceraOk_[0] && cabeceraOk_[1] && cabeceras_[1].secuencia > cabeceras_[0].secuencia)
+  {
+    orden[0] = 1;
+    orden[1] = 0;
+  }
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    uint8_t r = orden[i];
+    if (!cabeceraOk_[r])
+      continue;
+    if (cabeceras_[r].secuencia > secuencia_)
+      secuencia_ = cabeceras_[r].secuencia;
+    if (!valido_ && leerRanura(r, cabeceras_[r]))
+    {
+      valido_ = true;
+      ranuraActual_ = r;
+    }
+  }
+
+  if (!valido_)
+    importarLegado();
+}
+
+void AlmacenAjustes::importarLegado()
+{
+  if (!fs_.existe(RUTA_LEGADO))
+    return;
+  // El formato viejo guardaba 14 bytes de un arreglo de 5 uint16_t:
+  // solo los primeros 10 son datos de calibracion.
+  if (fs_.leer(RUTA_LEGADO, 0, datos_.calTactil, sizeof(datos_.calTactil)) != sizeof(datos_.calTactil))
+    return;
+
+  datos_.calValida = 1;
+  if (confirmar())
+    fs_.borrar(RUTA_LEGADO);
+}
+
+const Ajustes &AlmacenAjustes::leer()
+{
+  cargar();
+  return datos_;
+}
+
+Ajustes &AlmacenAjustes::editar()
+{
+  cargar();
+  return datos_;
+}
+
+bool AlmacenAjustes::confirmar()
+{
+  cargar();
+  uint32_t inicio = reloj_();
+
+  // Nunca se pisa la ranura que tiene la ultima confirmacion valida
+  uint8_t destino = valido_ ? (ranuraActual_ ^ 1) : 0;
+  // Cabecera y carga en una sola escritura
+  uint8_t registro[sizeof(Cabecera) + MAX_CARGA];
+  Cabecera cab;
+  cab.magia = MAGIA_AJUSTES;
+  cab.version = AJUSTES_VERSION;
+  cab.longitud = (uint16_t)empaquetar(datos_, registro + sizeof(Cabecera));
+  cab.secuencia = secuencia_ + 1;
+  cab.crc = crc32(registro + sizeof(Cabecera), cab.longitud, crc32(&cab, offsetof(Cabecera, crc)));
+  memcpy(registro, &cab, sizeof(cab));
+  size_t largo = sizeof(Cabecera) + cab.longitud;
+  size_t escritos = fs_.escribir(RUTAS_AJUSTES[destino], registro, largo);
+  if (escritos != largo)
+    return false;
+
+  cabeceras_[destino] = cab;
+  cabeceraOk_[destino] = true;
+  ranuraActual_ = destino;
+  secuencia_ = cab.secuencia;
+  valido_ = true;
+
+  estadisticas_.confirmaciones++;
+  estadisticas_.ultimaLatenciaUs = reloj_() - inicio;
+  estadisticas_.ultimosBytes = escritos;
+  estadisticas_.bytesTotales += escritos;
+  return true;
+}
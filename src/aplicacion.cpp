@@ -0,0 +1,1710 @@
+#include "aplicacion.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "bus_spi.h"
+#include "gestos_tactil.h"
+#include "ajustes.h"
+#include "control.h"
+#include "comandos.h"
+#include "telemetria.h"
+#include "reporte.h"
+#include "cola_tx.h"
+#include "registro_datos.h"
+#include "cola_eventos.h"
+#include "planificador.h"
+#include "anillo_spsc.h"
+#include "mensajes.h"
+#include "bus_eventos.h"
+#include "perfilador.h"
+#include "gobernador.h"
+
+// --- Bus SPI ---
+#define PERIODO_TACTIL_US 20000 // Muestreo garantizado del tactil (50 Hz)
+#define PRESUPUESTO_BUS_US 5000 // Tiempo maximo de bus por corrida de la interfaz
+
+// --- Comandos BT ---
+#define MAX_BYTES_BT_POR_VUELTA 64 // Acota el tiempo de parseo por corrida del trabajo "bt"
+#define MAX_BYTES_TX_POR_VUELTA 256 // Acota lo que se entrega al SPP por vuelta
+#define PERIODO_SUB_MINIMO_MS 100
+#define ESPERA_BIENVENIDA_MS 200 // El cliente recien conectado tarda en estar listo
+
+// --- Planificacion (us) ---
+#define PERIODO_SENSORES_US 2000000
+#define PERIODO_CONTROL_US 3000000
+#define PERIODO_INTERFAZ_US 10000 // Dibujo por pasos y muestreo del tactil
+#define PERIODO_BT_US 4000
+#define PERIODO_MANTENIMIENTO_US 1000000
+#define PERIODO_REPORTE_US 30000000
+#define PERIODO_GOBERNADOR_US 1000000 // Ventana de carga del gobernador de la CPU
+
+// --- Energia ---
+#define PISO_BT_MHZ 160 // El stack BT corre en tareas propias que no se miden
+
+// --- Instancias ---
+uint32_t relojMicros() { return reloj.micros(); }
+AlmacenAjustes ajustes(archivos, relojMicros);
+
+// --- Perfilador: etapas medidas (cada una la mide una sola tarea) ---
+enum EtapaPerfil : uint8_t
+{
+  ETAPA_CONVERSION,    // sensores: pedido de conversion al 1-Wire
+  ETAPA_LECTURA,       // sensores: lectura de los dos DS18B20
+  ETAPA_CONTROL,       // control: paso del termostato y salida a reles
+  ETAPA_BUS_SPI,       // interfaz: una corrida del gestor de bus (tactil + dibujo)
+  ETAPA_TACTIL,        // interfaz: un muestreo del XPT2046
+  ETAPA_TEMPERATURAS,  // interfaz: drawString de las temperaturas
+  ETAPA_FONDO,         // interfaz: una franja del fondo
+  ETAPA_BT_ENTRADA,    // comunicaciones: parseo y despacho de comandos
+  ETAPA_BT_SALIDA,     // comunicaciones: entrega de la cola al SPP
+  ETAPA_REGISTRO,      // comunicaciones: agregar una lectura (con el lote a flash)
+  ETAPA_MANTENIMIENTO, // comunicaciones: borrado anticipado de segmentos
+  ETAPAS_PERFIL
+};
+static const char *const nombresEtapas[ETAPAS_PERFIL] = {
+    "conversion", "lectura", "control", "bus spi", "tactil", "temperaturas",
+    "fondo", "bt entrada", "bt salida", "registro", "mantenimiento"};
+Perfilador perfil(ciclosCpu, 240, nombresEtapas, ETAPAS_PERFIL);
+
+// --- Anillos entre tareas (un productor, un consumidor cada uno) ---
+AnilloSpsc<Muestra, 4> sensoresAControl;
+typedef AnilloSpsc<Orden, 8> AnilloOrdenes;
+AnilloOrdenes interfazAControl;
+AnilloOrdenes comunicacionesAControl;
+AnilloSpsc<EstadoControl, 8> controlAInterfaz;
+AnilloSpsc<EstadoControl, 8> controlAComunicaciones;
+AnilloOrdenes interfazAComunicaciones;
+AnilloOrdenes comunicacionesAInterfaz;
+
+// --- Estado de la tarea de control ---
+bool sistemaEstado = false;
+bool estadoRele = false;  // K1
+bool estadoRele2 = true;  // K2 (en DEMO es siempre el opuesto de K1)
+FiltroTemperatura filtros[2];
+int16_t decimasFiltradas[2];
+bool lecturaValida[2] = {false, false};
+int16_t tempQ4[2] = {TEMP_Q4_ERROR, TEMP_Q4_ERROR};
+uint8_t modoControl = MODO_DEMO; // Copias de los ajustes: las cambia ORDEN_*
+int16_t consignaControl[2];
+int16_t histeresisControl;
+
+// --- Estado de la tarea de interfaz ---
+bool pantallaEncendida = true; // Forzar estado activo
+bool btIndicado = false;       // Lo que informo comunicaciones
+EstadoControl vista;           // Ultimo estado recibido de control
+uint32_t toquesReportados = 0;
+uint32_t muestrasVentanaInicio = 0;
+uint32_t pasosVentanaInicio = 0;
+uint32_t tactilVentanaInicioUs = 0;
+
+// --- Estado de la tarea de comunicaciones ---
+bool btActivo = false;
+bool pantallaInformada = true; // Lo que informo la interfaz
+EstadoControl estadoActual;    // Ultimo estado recibido de control
+bool sistemaReportado = false;
+LectorLineas lectorBT;
+bool telemetriaBinaria = false; // Negociado por el cliente con TELEM BIN
+CodificadorTramas codificadorBT;
+ColaTransmision colaTx;
+bool btCongestionado = false;
+bool bienvenidaPendiente = false; // Reporte inicial diferido tras conectar
+unsigned long bienvenidaDesde = 0;
+
+// Suscripciones del cliente (0 = sin suscripcion)
+uint32_t periodoSubEstadoMs = 0;
+uint32_t periodoSubMuestrasMs = 0;
+unsigned long ultimoSubEstado = 0;
+unsigned long ultimoSubMuestras = 0;
+
+// Descarga del historial en curso (HIST)
+bool descargaActiva = false;
+uint32_t descargaLectura = 0; // Indice de la proxima lectura a enviar
+uint16_t descargaIndice = 0;
+
+// Hora de las lecturas del registro: segundos desde 1970 una vez recibido
+// HORA; antes sigue desde la ultima marca guardada.
+uint32_t horaSegundos = 0;
+unsigned long horaRefMs = 0;
+bool horaValida = false;
+uint32_t lotesReportados = 0;
+uint32_t comandosMaxUs = 0;
+
+// Ultimo valor dibujado (evita rafagas SPI cuando nada cambio)
+#define SIN_DIBUJAR INT32_MIN // Fuera del rango de int16_t, TEMP_Q4_ERROR incluido
+int32_t tempDibujadaQ4[2] = {SIN_DIBUJAR, SIN_DIBUJAR};
+int8_t releDibujado = -1;
+
+// --- Colores ---
+#define COL_FONDO 0x0842
+#define COL_CARD 0x10A4
+#define COL_ACCENT 0x03EF
+#define COL_BTN_ON 0x2661
+#define COL_BTN_OFF 0x114F
+#define COL_TEXTO 0xFFFF
+#define COL_SUBTEXTO 0xAD75
+#define COL_BORDE 0xFFFF
+
+// --- Geometría ---
+const int btnY = 250;
+const int btnH = 60;
+const int btnW = 105;
+const int btn1X = 10;
+const int btn2X = 125;
+int cardH = 85;
+
+// Prototipos
+bool dibujarInterfazBase(uint8_t paso);
+void dibujarBotonSistema(bool estado);
+void dibujarBotonBL();
+void calibrarTactil();
+void gestionarModoEnergia(bool despertar);
+void actualizarVisualReles();
+void actualizarTemperaturas();
+void toggleBluetooth();
+void enviarReporteEstado();
+const char *formatearReporteActual();
+void manejarEventoTactil(const EventoTactil &ev);
+void encolarInterfazCompleta();
+void reportarBusSPI();
+void procesarEntradaBT();
+void leerSensores();
+void aplicarControl();
+void escribirReles();
+void encolarMuestraBT();
+void encolarEstadoBT(const char *reporte);
+void encolarTramaBT(ClaseMensaje clase, uint8_t tipo, const uint8_t *carga, size_t len);
+void responderBT(const char *formato, ...);
+void atenderBT();
+void procesarEventosBT();
+void avanzarDescarga();
+Muestra muestraActual();
+uint32_t horaActual();
+void reportarRegistro();
+void reportarPlanificador(Planificador &planificador);
+void reportarTareas();
+void reportarMemoria();
+void iniciarConversion();
+void atenderInterfaz();
+void atenderComunicaciones();
+void mantenerRegistro();
+void reportarSensores();
+void reportarControl();
+void reportarGobernador();
+void ajustarFrecuencia();
+void reportarInterfaz();
+void reportarComunicaciones();
+void controlAlDespertar();
+void interfazAlDespertar();
+void comunicacionesAlDespertar();
+bool interfazPuedeDormir();
+void reanudarInterfaz();
+bool comunicacionesPuedenDormir();
+EstadoControl estadoControl(bool lecturaNueva);
+void enviarEstadoAInterfaz(const EstadoControl &e);
+void enviarEstadoAComunicaciones(const EstadoControl &e);
+void actualizarVista(const EstadoControl &e);
+void seguirEstado(const EstadoControl &e);
+void registrarLectura(const EstadoControl &e);
+void reportarCambioSistema(const EstadoControl &e);
+void enviarPantallaAComunicaciones(const bool &encendida);
+void enviarBluetoothAInterfaz(const bool &activo);
+
+bool muestrearTactil(uint16_t *x, uint16_t *y)
+{
+  SondaEtapa sonda(perfil, ETAPA_TACTIL);
+  return tactil.leer(*x, *y);
+}
+
+// Los tiempos del perfilador se convierten con la frecuencia vigente
+void fijarFrecuenciaCpu(uint32_t mhz)
+{
+  plataforma.frecuenciaCpu(mhz);
+  perfil.frecuencia(mhz);
+}
+
+// Es de la tarea de control: las demas le piden con ORDEN_*_CPU
+Gobernador gobernador(fijarFrecuenciaCpu, relojMicros);
+
+// --- Tareas ---
+Tarea tareaControl("control", controlAlDespertar, nullptr, relojMicros);
+Tarea tareaSensores("sensores", nullptr, nullptr, relojMicros);
+Tarea tareaInterfaz("interfaz", interfazAlDespertar, interfazPuedeDormir, relojMicros);
+Tarea tareaComunicaciones("comunicaciones", comunicacionesAlDespertar, comunicacionesPuedenDormir, relojMicros);
+Tarea *const tareas[] = {&tareaControl, &tareaSensores, &tareaInterfaz, &tareaComunicaciones};
+const uint8_t CANTIDAD_TAREAS = sizeof(tareas) / sizeof(tareas[0]);
+uint32_t tareasVentanaInicioUs = 0;
+uint32_t gobernadorVentanaInicioUs = 0;
+uint32_t ocupadoGobernador[sizeof(tareas) / sizeof(tareas[0])]; // Al cierre de la ultima ventana
+uint32_t vencidosGobernador[sizeof(tareas) / sizeof(tareas[0])];
+
+uint8_t idLectura = Planificador::SIN_TRABAJO;
+uint8_t idInterfaz = Planificador::SIN_TRABAJO;
+uint8_t idComunicaciones = Planificador::SIN_TRABAJO;
+
+void enviarOrden(AnilloOrdenes &anillo, Tarea &destino, uint8_t tipo, uint8_t canal, int16_t valor)
+{
+  Orden o;
+  o.tipo = tipo;
+  o.canal = canal;
+  o.valor = valor;
+  anillo.publicar(o);
+  avisar(destino);
+}
+
+// --- Temas ---
+// Quien escucha cada cambio se declara aca, no en el productor. Los que
+// cruzan de tarea pasan por los anillos; del otro lado la tarea vuelve a
+// publicar en su propio tema.
+
+// Control publica su estado tras cada lectura o cambio de reles
+static const Tema<EstadoControl>::Suscriptor alCambiarEstado[] = {enviarEstadoAInterfaz,
+                                                                  enviarEstadoAComunicaciones};
+const Tema<EstadoControl> temaEstado("estado", alCambiarEstado);
+
+// El mismo estado ya del lado de cada tarea. seguirEstado va primero: los
+// demas leen el estado actual.
+static const Tema<EstadoControl>::Suscriptor alRecibirEstadoInterfaz[] = {actualizarVista};
+const Tema<EstadoControl> temaEstadoInterfaz("estado interfaz", alRecibirEstadoInterfaz);
+static const Tema<EstadoControl>::Suscriptor alRecibirEstadoComunicaciones[] = {seguirEstado, registrarLectura,
+                                                                                reportarCambioSistema};
+const Tema<EstadoControl> temaEstadoComunicaciones("estado comunicaciones", alRecibirEstadoComunicaciones);
+
+// Pantalla encendida/apagada (interfaz) y BT activo/apagado (comunicaciones)
+static const Tema<bool>::Suscriptor alCambiarPantalla[] = {enviarPantallaAComunicaciones};
+const Tema<bool> temaPantalla("pantalla", alCambiarPantalla);
+static const Tema<bool>::Suscriptor alCambiarBluetooth[] = {enviarBluetoothAInterfaz};
+const Tema<bool> temaBluetooth("bluetooth", alCambiarBluetooth);
+
+uint32_t pasoTarea(Tarea &t)
+{
+  uint32_t inicio = reloj.micros();
+  t.enReposo = false;
+  if (t.alDespertar)
+    t.alDespertar();
+  t.planificador.ejecutar();
+
+  uint32_t esperaUs = t.planificador.hastaProximo();
+  uint32_t fin = reloj.micros();
+  t.ocupadoUs.fetch_add(fin - inicio, std::memory_order_relaxed);
+  t.vencidos = t.planificador.vencidos();
+  t.sinPlazo = esperaUs == UINT32_MAX;
+  t.proximoUs = fin + esperaUs;
+  t.enReposo = !t.puedeDormir || t.puedeDormir();
+  return esperaUs;
+}
+
+// Uso de CPU en la ventana: tiempo entre que la tarea despierta y se vuelve
+// a bloquear
+float usoCpu(const Tarea &t, uint32_t ventanaUs)
+{
+  return ventanaUs ? 100.0f * (t.ocupadoUs - t.ocupadoVentanaInicio) / ventanaUs : 0.0f;
+}
+
+uint32_t perdidosAnillos()
+{
+  return sensoresAControl.perdidos() + interfazAControl.perdidos() + comunicacionesAControl.perdidos() +
+         controlAInterfaz.perdidos() + controlAComunicaciones.perdidos() + interfazAComunicaciones.perdidos() +
+         comunicacionesAInterfaz.perdidos();
+}
+
+// PENIRQ baja mientras el panel esta presionado. El flag lo levanta la
+// interrupcion y retiene toques cortos que empiezan y terminan entre dos
+// muestreos.
+volatile bool toquePendiente = false;
+bool lineaToque()
+{
+  bool hubo = toquePendiente;
+  toquePendiente = false;
+  return hubo || tactil.presionado();
+}
+bool conPenirq = true; // usarPenirq()
+
+GestorBusSPI busSPI(relojMicros, muestrearTactil, PERIODO_TACTIL_US);
+MaquinaGestos gestos;
+ColaEventos eventosBT(relojMicros);
+RegistroDatos registro(flashDatos, relojMicros);
+
+void recibirMuestraTactil(bool presionado, uint16_t x, uint16_t y, uint32_t us)
+{
+  gestos.muestra(presionado, x, y, us);
+}
+
+// --- Trabajos de pantalla (cada paso es una rafaga SPI corta) ---
+bool trabajoBotonSistema(uint8_t)
+{
+  dibujarBotonSistema(vista.muestra.banderas & MUESTRA_SISTEMA);
+  return false;
+}
+bool trabajoBotonBL(uint8_t) { dibujarBotonBL(); return false; }
+bool trabajoReles(uint8_t) { actualizarVisualReles(); return false; }
+bool trabajoTemperaturas(uint8_t) { actualizarTemperaturas(); return false; }
+bool trabajoIndicadorBT(uint8_t)
+{
+  pantalla.rellenar(190, 5, 45, 30, btIndicado ? COL_ACCENT : COL_CARD);
+  pantalla.textoCentrado(btIndicado ? "BT ON" : "BT OFF", 212, 20, 1, COL_TEXTO);
+  return false;
+}
+
+void alEventoBT(EventoTransporte evento)
+{
+  // Corre en la tarea del stack BT: solo se publica el evento. La consola, la
+  // cola de transmision y los reportes los atiende comunicaciones.
+  uint32_t inicio = reloj.micros();
+  eventosBT.publicar(evento);
+  eventosBT.registrarCallback(reloj.micros() - inicio);
+}
+
+void iniciarAplicacion()
+{
+  // 1. Hardware y Frecuencia Máxima
+  if (!iniciarHal())
+    consola.escribir("Error iniciando el hardware\n");
+  gobernador.iniciar();
+
+  // 2. Configurar pines de relés
+  gpio.salida(PIN_RELE1);
+  gpio.salida(PIN_RELE2);
+  gpio.escribir(PIN_RELE1, false);
+  gpio.escribir(PIN_RELE2, true);
+
+  // 3. Inicializar Sensores, ajustes y registro
+  sensores.iniciar();
+  ajustes.begin();
+  if (!registro.begin())
+    consola.escribir("Error registro de datos\n");
+  horaSegundos = registro.ultimaMarca() + 1;
+  horaRefMs = reloj.millis();
+
+  // Control arranca con los ajustes guardados; despues solo cambian por ORDEN_*
+  const Ajustes &a = ajustes.leer();
+  modoControl = a.modo;
+  consignaControl[0] = a.consigna[0];
+  consignaControl[1] = a.consigna[1];
+  histeresisControl = a.histeresis;
+  vista = estadoActual = estadoControl(false);
+
+  // 4. Inicializar Pantalla (La librería podría intentar apagar el pin 32 aquí)
+  pantalla.iniciar();
+
+  // 5. Configuración de Bluetooth
+  enlaceBT.alEvento(alEventoBT);
+
+  // 6. Dibujar Interfaz (Aún con la luz apagada para evitar ver el "dibujado")
+  calibrarTactil();
+  encolarInterfazCompleta();
+  busSPI.vaciarPantalla();
+  busSPI.alMuestrear(recibirMuestraTactil);
+
+  // La interrupcion de PENIRQ la engancha la plataforma
+  gpio.entrada(PIN_T_IRQ);
+  busSPI.detectorToque(conPenirq ? lineaToque : nullptr);
+
+  // 7. FINAL DEL SETUP: FORZAR ENCENDIDO DE LUZ
+  gpio.salida(PIN_BL);
+  gpio.escribir(PIN_BL, false); // LOW = ON
+  pantallaEncendida = true;
+
+  // 8. Trabajos de cada tarea: periodo, plazo (0 = el periodo) y presupuesto
+  Planificador &ps = tareaSensores.planificador;
+  ps.periodico("sensores", iniciarConversion, PERIODO_SENSORES_US, 0, 2000);
+  idLectura = ps.unaVez("lectura", leerSensores, 200000, 40000);
+  ps.periodico("reporte sensores", reportarSensores, PERIODO_REPORTE_US, 0, 5000, PERIODO_REPORTE_US);
+
+  Planificador &pc = tareaControl.planificador;
+  pc.periodico("control", aplicarControl, PERIODO_CONTROL_US, 100000, 5000);
+  pc.periodico("reporte control", reportarControl, PERIODO_REPORTE_US, 0, 5000, PERIODO_REPORTE_US);
+  pc.periodico("gobernador", ajustarFrecuencia, PERIODO_GOBERNADOR_US, 0, 1000);
+
+  Planificador &pi = tareaInterfaz.planificador;
+  idInterfaz = pi.periodico("interfaz", atenderInterfaz, PERIODO_INTERFAZ_US, 0, PRESUPUESTO_BUS_US + 2000);
+  pi.periodico("reporte interfaz", reportarInterfaz, PERIODO_REPORTE_US, 0, 10000, PERIODO_REPORTE_US);
+
+  Planificador &pb = tareaComunicaciones.planificador;
+  idComunicaciones = pb.periodico("bt", atenderComunicaciones, PERIODO_BT_US, 0, 3000);
+  pb.pausar(idComunicaciones); // Hasta que se encienda el BT
+  pb.periodico("mantenimiento", mantenerRegistro, PERIODO_MANTENIMIENTO_US, 0, 60000);
+  pb.periodico("reporte", reportarComunicaciones, PERIODO_REPORTE_US, 0, 20000, PERIODO_REPORTE_US);
+
+  tareasVentanaInicioUs = gobernadorVentanaInicioUs = reloj.micros();
+}
+
+// --- Tarea de comunicaciones ---
+
+void comunicacionesAlDespertar()
+{
+  EstadoControl e;
+  while (controlAComunicaciones.siguiente(e))
+    temaEstadoComunicaciones.publicar(e);
+
+  Orden o;
+  while (interfazAComunicaciones.siguiente(o))
+  {
+    if (o.tipo == ORDEN_BLUETOOTH)
+      toggleBluetooth();
+    else if (o.tipo == ORDEN_PANTALLA)
+      pantallaInformada = o.valor != 0;
+  }
+}
+
+bool comunicacionesPuedenDormir() { return !btActivo; }
+
+void seguirEstado(const EstadoControl &e) { estadoActual = e; }
+
+void registrarLectura(const EstadoControl &e)
+{
+  if (!e.lecturaNueva)
+    return;
+  Muestra m = muestraActual();
+  Lectura l;
+  l.t = horaActual();
+  l.tempQ4[0] = m.tempQ4[0];
+  l.tempQ4[1] = m.tempQ4[1];
+  l.banderas = m.banderas | (horaValida ? MUESTRA_HORA_VALIDA : 0);
+  SondaEtapa sonda(perfil, ETAPA_REGISTRO);
+  registro.agregar(l);
+}
+
+// Encender o apagar el sistema (tactil) se informa por serie y BT
+void reportarCambioSistema(const EstadoControl &e)
+{
+  bool sistema = e.muestra.banderas & MUESTRA_SISTEMA;
+  if (sistema == sistemaReportado)
+    return;
+  sistemaReportado = sistema;
+  enviarReporteEstado();
+}
+
+void enviarBluetoothAInterfaz(const bool &activo)
+{
+  enviarOrden(comunicacionesAInterfaz, tareaInterfaz, ORDEN_ESTADO_BT, 0, activo);
+}
+
+// Bluetooth: eventos del stack, comandos recibidos, suscripciones y cola de
+// salida (nunca espera)
+void atenderComunicaciones()
+{
+  procesarEventosBT();
+  if (btActivo)
+    atenderBT();
+}
+
+// Con tiempo libre: el borrado del proximo segmento se hace ahora y no
+// dentro de la escritura de un lote
+void mantenerRegistro()
+{
+  SondaEtapa sonda(perfil, ETAPA_MANTENIMIENTO);
+  registro.mantenimiento();
+}
+
+void reportarComunicaciones()
+{
+  reportarTareas();
+  reportarMemoria();
+  reportarRegistro();
+  reportarPlanificador(tareaComunicaciones.planificador);
+  if (btActivo)
+  {
+    const EstadisticasColaTx &tx = colaTx.estadisticas();
+    consola.printf("[BT] comandos: peor vuelta=%luus lineas descartadas=%lu\n",
+                   (unsigned long)comandosMaxUs, (unsigned long)lectorBT.desbordes());
+    consola.printf("[BT] tx: enviados=%luB coalescidos=%lu descartados=%lu rechazados=%lu\n",
+                   (unsigned long)tx.bytesEnviados, (unsigned long)tx.coalescidos,
+                   (unsigned long)tx.descartados, (unsigned long)tx.rechazados);
+    const HistogramaLatencia &cb = eventosBT.duracionCallback();
+    const HistogramaLatencia &espera = eventosBT.latencia();
+    consola.printf("[BT] eventos: callback p99=%luus max=%luus cola p50=%luus p99=%luus max=%luus perdidos=%lu\n",
+                   (unsigned long)cb.percentil(99), (unsigned long)cb.maximo,
+                   (unsigned long)espera.percentil(50), (unsigned long)espera.percentil(99),
+                   (unsigned long)espera.maximo, (unsigned long)eventosBT.perdidos());
+  }
+}
+
+// --- Tarea de interfaz ---
+
+void interfazAlDespertar()
+{
+  EstadoControl e;
+  while (controlAInterfaz.siguiente(e))
+    temaEstadoInterfaz.publicar(e);
+
+  Orden o;
+  while (comunicacionesAInterfaz.siguiente(o))
+  {
+    if (o.tipo != ORDEN_ESTADO_BT)
+      continue;
+    btIndicado = o.valor != 0;
+    if (pantallaEncendida)
+      busSPI.encolarPantalla(trabajoIndicadorBT);
+  }
+
+  // Un toque con la interfaz en pausa (pantalla apagada) la vuelve a activar
+  if (toquePendiente)
+    reanudarInterfaz();
+}
+
+void reanudarInterfaz()
+{
+  if (tareaInterfaz.planificador.activo(idInterfaz))
+    return;
+  // El ultimo muestreo del tactil es de antes de la pausa: no es un retraso
+  busSPI.reanudar();
+  tareaInterfaz.planificador.activar(idInterfaz);
+}
+
+bool interfazPuedeDormir() { return !tareaInterfaz.planificador.activo(idInterfaz); }
+
+void usarPenirq(bool usar)
+{
+  conPenirq = usar;
+  busSPI.detectorToque(usar ? lineaToque : nullptr);
+  if (!usar)
+    reanudarInterfaz();
+}
+
+void actualizarVista(const EstadoControl &e)
+{
+  uint8_t cambios = e.muestra.banderas ^ vista.muestra.banderas;
+  vista = e;
+  if (!pantallaEncendida)
+    return;
+  // Los trabajos comparan con lo ya dibujado: repetidos no tocan el bus
+  busSPI.encolarPantalla(trabajoTemperaturas);
+  busSPI.encolarPantalla(trabajoReles);
+  if (cambios & MUESTRA_SISTEMA)
+    busSPI.encolarPantalla(trabajoBotonSistema);
+}
+
+void enviarPantallaAComunicaciones(const bool &encendida)
+{
+  enviarOrden(interfazAComunicaciones, tareaComunicaciones, ORDEN_PANTALLA, 0, encendida);
+}
+
+// Pantalla y tactil comparten el bus: el gestor intercala ambos
+void atenderInterfaz()
+{
+  {
+    SondaEtapa sonda(perfil, ETAPA_BUS_SPI);
+    busSPI.servir(PRESUPUESTO_BUS_US);
+  }
+
+  // Eventos tactiles ya confirmados (nunca se espera a que se suelte el dedo)
+  EventoTactil ev;
+  while (gestos.siguiente(ev))
+    manejarEventoTactil(ev);
+
+  // Con la pantalla apagada solo hace falta mientras dura un toque: PENIRQ
+  // la vuelve a activar
+  if (conPenirq && !pantallaEncendida && !busSPI.pantallaPendiente() && !busSPI.tocando() && gestos.enReposo())
+    tareaInterfaz.planificador.pausar(idInterfaz);
+}
+
+void reportarInterfaz()
+{
+  reportarBusSPI();
+  reportarPlanificador(tareaInterfaz.planificador);
+}
+
+// --- Tarea de sensores: duena del bus 1-Wire ---
+
+// Arranca la conversion de los DS18B20 y programa su lectura para cuando
+// termine, asi el bus 1-Wire no bloquea la tarea mientras tanto.
+void iniciarConversion()
+{
+  {
+    SondaEtapa sonda(perfil, ETAPA_CONVERSION);
+    sensores.pedirConversion();
+  }
+  tareaSensores.planificador.activar(idLectura, sensores.msConversion() * 1000UL);
+}
+
+void leerSensores()
+{
+  Muestra m;
+  m.ms = reloj.millis();
+  m.banderas = 0;
+  {
+    SondaEtapa sonda(perfil, ETAPA_LECTURA);
+    for (uint8_t i = 0; i < 2; i++)
+      m.tempQ4[i] = sensores.leerQ4(i);
+  }
+  sensoresAControl.publicar(m);
+  avisar(tareaControl);
+}
+
+void reportarSensores() { reportarPlanificador(tareaSensores.planificador); }
+
+// --- Tarea de control: duena de los reles y del estado del sistema ---
+
+EstadoControl estadoControl(bool lecturaNueva)
+{
+  EstadoControl e;
+  e.muestra.ms = reloj.millis();
+  e.muestra.tempQ4[0] = tempQ4[0];
+  e.muestra.tempQ4[1] = tempQ4[1];
+  e.muestra.banderas = (estadoRele ? MUESTRA_K1 : 0) | (estadoRele2 ? MUESTRA_K2 : 0) |
+                       (sistemaEstado ? MUESTRA_SISTEMA : 0);
+  e.modo = modoControl;
+  e.lecturaNueva = lecturaNueva;
+  return e;
+}
+
+void publicarEstado(bool lecturaNueva) { temaEstado.publicar(estadoControl(lecturaNueva)); }
+
+void enviarEstadoAInterfaz(const EstadoControl &e)
+{
+  controlAInterfaz.publicar(e);
+  avisar(tareaInterfaz);
+}
+
+void enviarEstadoAComunicaciones(const EstadoControl &e)
+{
+  controlAComunicaciones.publicar(e);
+  avisar(tareaComunicaciones);
+}
+
+void procesarLectura(const Muestra &m)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    tempQ4[i] = m.tempQ4[i];
+    lecturaValida[i] = (tempQ4[i] != TEMP_Q4_ERROR);
+    if (lecturaValida[i])
+      decimasFiltradas[i] = filtros[i].paso(q4ADecimas(tempQ4[i]));
+    else
+      filtros[i].reiniciar();
+  }
+  publicarEstado(true);
+}
+
+void aplicarOrden(const Orden &o)
+{
+  switch ((TipoOrden)o.tipo)
+  {
+  case ORDEN_SISTEMA:
+    sistemaEstado = o.valor < 0 ? !sistemaEstado : o.valor != 0;
+    publicarEstado(false);
+    break;
+  case ORDEN_RELE:
+    if (modoControl != MODO_MANUAL || (o.canal != 1 && o.canal != 2))
+      break;
+    (o.canal == 1 ? estadoRele : estadoRele2) = o.valor != 0;
+    escribirReles();
+    break;
+  case ORDEN_MODO:
+    modoControl = (uint8_t)o.valor;
+    publicarEstado(false);
+    break;
+  case ORDEN_CONSIGNA:
+    if (o.canal == 1 || o.canal == 2)
+      consignaControl[o.canal - 1] = o.valor;
+    break;
+  case ORDEN_IMPULSO_CPU:
+    gobernador.impulsar();
+    break;
+  case ORDEN_PISO_CPU:
+    gobernador.fijarPiso((uint32_t)o.valor);
+    break;
+  default:
+    break;
+  }
+}
+
+void controlAlDespertar()
+{
+  Muestra m;
+  while (sensoresAControl.siguiente(m))
+    procesarLectura(m);
+  Orden o;
+  while (interfazAControl.siguiente(o))
+    aplicarOrden(o);
+  while (comunicacionesAControl.siguiente(o))
+    aplicarOrden(o);
+}
+
+// Carga de todas las tareas sumada, como si fueran un solo nucleo: sobreestima
+// cuando las dos CPUs trabajan a la vez, que es el lado seguro
+void ajustarFrecuencia()
+{
+  uint32_t ahora = reloj.micros();
+  uint32_t ventanaUs = ahora - gobernadorVentanaInicioUs;
+  uint32_t ocupadoUs = 0;
+  uint32_t vencidos = 0;
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+  {
+    uint32_t ocupado = tareas[i]->ocupadoUs;
+    uint32_t v = tareas[i]->vencidos;
+    ocupadoUs += ocupado - ocupadoGobernador[i];
+    vencidos += v - vencidosGobernador[i];
+    ocupadoGobernador[i] = ocupado;
+    vencidosGobernador[i] = v;
+  }
+  gobernadorVentanaInicioUs = ahora;
+  if (ventanaUs > 0)
+    gobernador.evaluar((uint32_t)((uint64_t)ocupadoUs * 1000 / ventanaUs), vencidos);
+}
+
+void reportarControl()
+{
+  reportarPlanificador(tareaControl.planificador);
+  reportarGobernador();
+}
+
+// Tiempo en cada frecuencia desde el arranque, cambios y plazos vencidos que
+// vio el gobernador
+void reportarGobernador()
+{
+  consola.printf("[CPU] %luMHz piso=%luMHz carga=%lu.%lu%% cambios=%lu vencidos=%lu",
+                 (unsigned long)gobernador.frecuencia(), (unsigned long)gobernador.piso(),
+                 (unsigned long)(gobernador.ultimaCarga() / 10), (unsigned long)(gobernador.ultimaCarga() % 10),
+                 (unsigned long)gobernador.cambios(), (unsigned long)gobernador.vencidos());
+  for (uint8_t i = 0; i < Gobernador::ESCALONES; i++)
+    consola.printf(" %luMHz=%lus", (unsigned long)Gobernador::mhz(i),
+                   (unsigned long)(gobernador.tiempoUs(i) / 1000000));
+  consola.escribir("\n");
+}
+
+uint32_t horaActual()
+{
+  // Se re-ancla en cada consulta, asi sobrevive a la vuelta de reloj.millis()
+  uint32_t pasados = (reloj.millis() - horaRefMs) / 1000;
+  horaSegundos += pasados;
+  horaRefMs += pasados * 1000;
+  return horaSegundos;
+}
+
+// Ultimo estado de control visto por comunicaciones
+Muestra muestraActual()
+{
+  Muestra m = estadoActual.muestra;
+  m.ms = reloj.millis();
+  if (pantallaInformada)
+    m.banderas |= MUESTRA_PANTALLA;
+  return m;
+}
+
+// --- Salida Bluetooth (todo pasa por la cola de transmision) ---
+
+void encolarTramaBT(ClaseMensaje clase, uint8_t tipo, const uint8_t *carga, size_t len)
+{
+  uint8_t trama[MAX_TRAMA];
+  size_t n = codificadorBT.codificar(tipo, carga, len, trama);
+  colaTx.encolar(clase, trama, n);
+}
+
+void responderBT(const char *formato, ...)
+{
+  char texto[96];
+  va_list args;
+  va_start(args, formato);
+  int n = vsnprintf(texto, sizeof(texto), formato, args);
+  va_end(args);
+  if (n < 0)
+    return;
+  size_t len = (size_t)n < sizeof(texto) ? (size_t)n : sizeof(texto) - 1;
+  // En modo binario el texto se cierra con 0x00: el receptor lo descarta
+  // como una trama invalida y no pierde la sincronizacion de la siguiente.
+  if (telemetriaBinaria)
+    len++;
+  colaTx.encolar(MSG_RESPUESTA, (const uint8_t *)texto, len);
+}
+
+void encolarMuestraBT()
+{
+  Muestra m = muestraActual();
+  if (telemetriaBinaria)
+  {
+    uint8_t carga[1 + MUESTRA_BYTES];
+    carga[0] = 1;
+    empaquetarMuestra(m, carga + 1);
+    encolarTramaBT(MSG_MUESTRA, TRAMA_MUESTRAS, carga, sizeof(carga));
+    return;
+  }
+
+  // Texto: "M <ms> <t1> <t2> <K1><K2>"
+  char linea[48];
+  EscritorTexto w(linea, sizeof(linea));
+  w.texto("M ").entero(m.ms);
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    w.caracter(' ');
+    if (m.tempQ4[i] == TEMP_Q4_ERROR)
+      w.texto("ERR");
+    else
+      w.celsiusQ4(m.tempQ4[i]);
+  }
+  w.caracter(' ').caracter(m.banderas & MUESTRA_K1 ? '1' : '0').caracter(m.banderas & MUESTRA_K2 ? '1' : '0');
+  w.caracter('\n');
+  colaTx.encolar(MSG_MUESTRA, w.c_str());
+}
+
+void encolarEstadoBT(const char *reporte)
+{
+  if (!enlaceBT.hayCliente())
+    return;
+  if (telemetriaBinaria)
+  {
+    uint8_t carga[ESTADO_BYTES];
+    const Ajustes &a = ajustes.leer();
+    empaquetarEstado(muestraActual(), a.modo, a.consigna, carga);
+    encolarTramaBT(MSG_ESTADO, TRAMA_ESTADO, carga, sizeof(carga));
+  }
+  else
+    colaTx.encolar(MSG_ESTADO, reporte);
+}
+
+size_t escribirEnlaceBT(const uint8_t *datos, size_t len)
+{
+  return enlaceBT.escribir(datos, len);
+}
+
+// Eventos publicados por el callback del stack BT, en el orden en que llegaron
+void procesarEventosBT()
+{
+  EventoDiferido ev;
+  while (eventosBT.siguiente(ev))
+  {
+    switch ((EventoTransporte)ev.tipo)
+    {
+    case TRANSPORTE_CONECTADO:
+      // Cada cliente arranca en modo texto y sin suscripciones
+      consola.escribir("\n[BT] ¡Cliente conectado!\n");
+      telemetriaBinaria = false;
+      periodoSubEstadoMs = periodoSubMuestrasMs = 0;
+      bienvenidaPendiente = true;
+      bienvenidaDesde = reloj.millis();
+      break;
+    case TRANSPORTE_DESCONECTADO:
+      btCongestionado = false;
+      bienvenidaPendiente = false;
+      descargaActiva = false;
+      colaTx.vaciar();
+      periodoSubEstadoMs = periodoSubMuestrasMs = 0;
+      break;
+    case TRANSPORTE_CONGESTIONADO:
+      btCongestionado = true;
+      break;
+    case TRANSPORTE_DESCONGESTIONADO:
+      btCongestionado = false;
+      break;
+    }
+  }
+}
+
+void atenderBT()
+{
+  if (bienvenidaPendiente && reloj.millis() - bienvenidaDesde >= ESPERA_BIENVENIDA_MS)
+  {
+    bienvenidaPendiente = false;
+    enviarReporteEstado();
+  }
+
+  procesarEntradaBT();
+
+  unsigned long ahora = reloj.millis();
+  if (periodoSubEstadoMs && ahora - ultimoSubEstado >= periodoSubEstadoMs)
+  {
+    ultimoSubEstado = ahora;
+    encolarEstadoBT(formatearReporteActual());
+  }
+  if (periodoSubMuestrasMs && ahora - ultimoSubMuestras >= periodoSubMuestrasMs)
+  {
+    ultimoSubMuestras = ahora;
+    encolarMuestraBT();
+  }
+
+  if (descargaActiva)
+    avanzarDescarga();
+
+  // Con el enlace congestionado no se entrega nada: la cola coalesce/descarta
+  if (enlaceBT.hayCliente() && !btCongestionado)
+  {
+    SondaEtapa sonda(perfil, ETAPA_BT_SALIDA);
+    colaTx.bombear(escribirEnlaceBT, MAX_BYTES_TX_POR_VUELTA);
+  }
+}
+
+void escribirReles()
+{
+  gpio.escribir(PIN_RELE1, estadoRele);
+  gpio.escribir(PIN_RELE2, estadoRele2);
+  publicarEstado(false);
+}
+
+void aplicarControl()
+{
+  SondaEtapa sonda(perfil, ETAPA_CONTROL);
+  switch ((ModoControl)modoControl)
+  {
+  case MODO_DEMO:
+    estadoRele = !estadoRele;
+    estadoRele2 = !estadoRele;
+    break;
+  case MODO_AUTO:
+    // Sin sistema activo o sin lectura valida, el rele queda apagado
+    estadoRele = sistemaEstado && lecturaValida[0] &&
+                 pasoTermostato(estadoRele, decimasFiltradas[0], consignaControl[0], histeresisControl);
+    estadoRele2 = sistemaEstado && lecturaValida[1] &&
+                  pasoTermostato(estadoRele2, decimasFiltradas[1], consignaControl[1], histeresisControl);
+    break;
+  case MODO_MANUAL:
+    return;
+  }
+  escribirReles();
+}
+
+// --- Comandos Bluetooth ---
+
+void responderDecimas(const char *prefijo, uint8_t canal, int16_t decimas)
+{
+  int16_t absoluto = decimas < 0 ? -decimas : decimas;
+  responderBT("%s%u=%s%d.%d\n", prefijo, canal, decimas < 0 ? "-" : "", absoluto / 10, absoluto % 10);
+}
+
+// SP <1|2> <grados> : fija y persiste la consigna del canal. La respuesta
+// informa lo que costo persistirla (bytes del registro y us de escritura).
+void cmdConsigna(uint8_t argc, char *argv[])
+{
+  int16_t decimas;
+  uint8_t canal = argv[0][0] - '0';
+  if ((canal != 1 && canal != 2) || argv[0][1] || !parsearDecimas(argv[1], decimas))
+  {
+    responderBT("ERR uso: SP <1|2> <grados>\n");
+    return;
+  }
+  ajustes.editar().consigna[canal - 1] = decimas;
+  if (!ajustes.confirmar())
+  {
+    responderBT("ERR guardando\n");
+    return;
+  }
+  enviarOrden(comunicacionesAControl, tareaControl, ORDEN_CONSIGNA, canal, decimas);
+  const EstadisticasAjustes &est = ajustes.estadisticas();
+  int16_t absoluto = decimas < 0 ? -decimas : decimas;
+  responderBT("OK SP%u=%s%d.%d bytes=%lu us=%lu\n", canal, decimas < 0 ? "-" : "", absoluto / 10, absoluto % 10,
+              (unsigned long)est.ultimosBytes, (unsigned long)est.ultimaLatenciaUs);
+}
+
+// ESTADO : envia el reporte completo
+void cmdEstado(uint8_t argc, char *argv[])
+{
+  enviarReporteEstado();
+}
+
+// RELE <1|2> [ON|OFF] : sin estado alterna. Solo en modo MANUAL.
+void cmdRele(uint8_t argc, char *argv[])
+{
+  uint8_t canal = argv[0][0] - '0';
+  if ((canal != 1 && canal != 2) || argv[0][1])
+  {
+    responderBT("ERR uso: RELE <1|2> [ON|OFF]\n");
+    return;
+  }
+  if ((ModoControl)ajustes.leer().modo != MODO_MANUAL)
+  {
+    responderBT("ERR requiere MODO MANUAL\n");
+    return;
+  }
+  bool rele;
+  if (argc == 1)
+    rele = !(estadoActual.muestra.banderas & (canal == 1 ? MUESTRA_K1 : MUESTRA_K2));
+  else if (igualSinMayusculas(argv[1], "ON"))
+    rele = true;
+  else if (igualSinMayusculas(argv[1], "OFF"))
+    rele = false;
+  else
+  {
+    responderBT("ERR uso: RELE <1|2> [ON|OFF]\n");
+    return;
+  }
+  enviarOrden(comunicacionesAControl, tareaControl, ORDEN_RELE, canal, rele);
+  responderBT("OK K%u=%s\n", canal, rele ? "ON" : "OFF");
+}
+
+// MODO <DEMO|MANUAL|AUTO> : cambia y persiste el modo de control; como SP,
+// informa bytes y us de la escritura
+void cmdModo(uint8_t argc, char *argv[])
+{
+  for (uint8_t m = MODO_DEMO; m <= MODO_AUTO; m++)
+  {
+    if (!igualSinMayusculas(argv[0], nombreModo((ModoControl)m)))
+      continue;
+    ajustes.editar().modo = m;
+    if (!ajustes.confirmar())
+    {
+      responderBT("ERR guardando\n");
+      return;
+    }
+    enviarOrden(comunicacionesAControl, tareaControl, ORDEN_MODO, 0, m);
+    const EstadisticasAjustes &est = ajustes.estadisticas();
+    responderBT("OK MODO=%s bytes=%lu us=%lu\n", nombreModo((ModoControl)m), (unsigned long)est.ultimosBytes,
+                (unsigned long)est.ultimaLatenciaUs);
+    return;
+  }
+  responderBT("ERR uso: MODO <DEMO|MANUAL|AUTO>\n");
+}
+
+// TELEM <TXT|BIN> : en BIN las muestras y el estado viajan en tramas COBS
+void cmdTelemetria(uint8_t argc, char *argv[])
+{
+  if (igualSinMayusculas(argv[0], "BIN"))
+  {
+    telemetriaBinaria = true;
+    uint8_t version = TELEMETRIA_VERSION;
+    encolarTramaBT(MSG_RESPUESTA, TRAMA_HOLA, &version, 1);
+    // Sin suscripcion previa, una muestra por ciclo de sensores
+    if (periodoSubMuestrasMs == 0)
+    {
+      periodoSubMuestrasMs = 2000;
+      ultimoSubMuestras = reloj.millis();
+    }
+  }
+  else if (igualSinMayusculas(argv[0], "TXT"))
+  {
+    telemetriaBinaria = false;
+    responderBT("OK TELEM=TXT\n");
+  }
+  else
+    responderBT("ERR uso: TELEM <TXT|BIN>\n");
+}
+
+// SUB : estado de la suscripcion
+// SUB <ESTADO|MUESTRAS> <ms> : envio periodico (0 = cancelar)
+// SUB OFF : cancela todo
+void cmdSuscripcion(uint8_t argc, char *argv[])
+{
+  if (argc == 1 && igualSinMayusculas(argv[0], "OFF"))
+  {
+    periodoSubEstadoMs = periodoSubMuestrasMs = 0;
+  }
+  else if (argc == 2)
+  {
+    uint32_t periodo;
+    bool esEstado = igualSinMayusculas(argv[0], "ESTADO");
+    if ((!esEstado && !igualSinMayusculas(argv[0], "MUESTRAS")) || !parsearEntero(argv[1], periodo))
+    {
+      responderBT("ERR uso: SUB <ESTADO|MUESTRAS> <ms>\n");
+      return;
+    }
+    if (periodo && periodo < PERIODO_SUB_MINIMO_MS)
+      periodo = PERIODO_SUB_MINIMO_MS;
+    (esEstado ? periodoSubEstadoMs : periodoSubMuestrasMs) = periodo;
+    (esEstado ? ultimoSubEstado : ultimoSubMuestras) = reloj.millis() - periodo; // El primero sale ya
+  }
+  else if (argc != 0)
+  {
+    responderBT("ERR uso: SUB <ESTADO|MUESTRAS> <ms> | SUB OFF\n");
+    return;
+  }
+
+  const EstadisticasColaTx &est = colaTx.estadisticas();
+  responderBT("OK SUB estado=%lums muestras=%lums coalescidos=%lu descartados=%lu rechazados=%lu\n",
+              (unsigned long)periodoSubEstadoMs, (unsigned long)periodoSubMuestrasMs,
+              (unsigned long)est.coalescidos, (unsigned long)est.descartados, (unsigned long)est.rechazados);
+}
+
+// HIST [lectura] : descarga el registro desde ese indice en tramas TRAMA_HIST
+// HIST STOP : corta la descarga. Para retomar, se pide desde la lectura que
+// sigue a la ultima recibida.
+void cmdHistorial(uint8_t argc, char *argv[])
+{
+  if (argc == 1 && igualSinMayusculas(argv[0], "STOP"))
+  {
+    descargaActiva = false;
+    responderBT("OK HIST STOP lectura=%lu\n", (unsigned long)descargaLectura);
+    return;
+  }
+  uint32_t desde = 0;
+  if (argc == 1 && !parsearEntero(argv[0], desde))
+  {
+    responderBT("ERR uso: HIST [lectura] | HIST STOP\n");
+    return;
+  }
+  if (!telemetriaBinaria)
+  {
+    responderBT("ERR requiere TELEM BIN\n");
+    return;
+  }
+
+  // El lote que se arma en RAM tambien entra en la descarga, sin escribirlo
+  descargaLectura = desde > registro.inicio() ? desde : registro.inicio();
+  descargaIndice = 0;
+  descargaActiva = true;
+  responderBT("OK HIST desde=%lu hasta=%lu\n", (unsigned long)descargaLectura, (unsigned long)registro.fin());
+}
+
+// Un bloque por vuelta y solo si la cola tiene lugar: se lee directo de
+// flash al ritmo que el enlace acepta, sin cargar el historial en RAM.
+void avanzarDescarga()
+{
+  if (colaTx.libres() <= 2)
+    return;
+
+  // Si el registro roto mientras tanto, lo mas viejo ya no esta
+  uint32_t desde = descargaLectura > registro.inicio() ? descargaLectura : registro.inicio();
+  Lectura lecturas[HIST_LECTURAS];
+  size_t n = 0;
+  while (n < HIST_LECTURAS)
+  {
+    size_t leidas = registro.leer(desde + n, lecturas + n, HIST_LECTURAS - n);
+    if (leidas == 0)
+      break;
+    n += leidas;
+  }
+  if (n == 0)
+  {
+    uint8_t fin[4] = {(uint8_t)desde, (uint8_t)(desde >> 8), (uint8_t)(desde >> 16), (uint8_t)(desde >> 24)};
+    encolarTramaBT(MSG_HISTORIAL, TRAMA_HIST_FIN, fin, sizeof(fin));
+    descargaActiva = false;
+    descargaLectura = desde;
+    return;
+  }
+
+  uint8_t carga[HIST_CABECERA_BYTES + HIST_LECTURAS * MUESTRA_BYTES];
+  empaquetarCabeceraHist(descargaIndice++, desde, carga);
+  for (size_t i = 0; i < n; i++)
+    empaquetarLectura(lecturas[i], carga + HIST_CABECERA_BYTES + i * MUESTRA_BYTES);
+  encolarTramaBT(MSG_HISTORIAL, TRAMA_HIST, carga, HIST_CABECERA_BYTES + n * MUESTRA_BYTES);
+  descargaLectura = desde + n;
+}
+
+// HORA [segundos desde 1970] : consulta o fija la hora de las lecturas
+void cmdHora(uint8_t argc, char *argv[])
+{
+  if (argc == 1)
+  {
+    uint32_t segundos;
+    if (!parsearEntero(argv[0], segundos))
+    {
+      responderBT("ERR uso: HORA [segundos desde 1970]\n");
+      return;
+    }
+    horaSegundos = segundos;
+    horaRefMs = reloj.millis();
+    horaValida = true;
+  }
+  responderBT("OK HORA %lu %s\n", (unsigned long)horaActual(), horaValida ? "real" : "relativa");
+}
+
+// RANGO <desde> <hasta> : indices y min/max de las lecturas con marca en
+// [desde, hasta). Sale del indice del registro sin recorrer las lecturas; el
+// primer indice sirve para empezar la descarga ahi con HIST.
+void cmdRango(uint8_t argc, char *argv[])
+{
+  uint32_t desde, hasta;
+  if (!parsearEntero(argv[0], desde) || !parsearEntero(argv[1], hasta) || hasta < desde)
+  {
+    responderBT("ERR uso: RANGO <desde> <hasta>\n");
+    return;
+  }
+
+  // Incluye el lote en RAM sin escribirlo: consultar seguido (un grafico en
+  // vivo) no gasta flash
+  uint32_t primera = registro.buscarMarca(desde);
+  uint32_t ultima = registro.buscarMarca(hasta);
+  ResumenLecturas r;
+  registro.resumir(primera, ultima, r);
+  responderBT("OK RANGO lecturas=%lu-%lu\n", (unsigned long)primera, (unsigned long)ultima);
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (r.minQ4[i] > r.maxQ4[i])
+    {
+      responderBT("T%u sin datos\n", i + 1);
+      continue;
+    }
+    responderDecimas("MIN", i + 1, q4ADecimas(r.minQ4[i]));
+    responderDecimas("MAX", i + 1, q4ADecimas(r.maxQ4[i]));
+  }
+}
+
+// RESUMEN [horas] : min/max/media de las ultimas horas (24 por defecto).
+// Sale de los resumenes por hora del registro, sin decodificar lecturas.
+void cmdResumen(uint8_t argc, char *argv[])
+{
+  uint32_t horas = 24;
+  if (argc == 1 && (!parsearEntero(argv[0], horas) || horas == 0 || horas > PiramideResumen::retencion() / 3600))
+  {
+    responderBT("ERR uso: RESUMEN [horas]\n");
+    return;
+  }
+
+  uint32_t ahora = horaActual();
+  uint32_t desde = ahora > horas * 3600 ? ahora - horas * 3600 : 0;
+  Agregado g;
+  uint8_t nivel;
+  if (registro.serie(desde, ahora + 1, &g, 1, nivel) == 0)
+  {
+    responderBT("ERR sin datos\n");
+    return;
+  }
+  responderBT("OK RESUMEN horas=%lu nivel=%u\n", (unsigned long)horas, nivel);
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (g.minQ4[i] > g.maxQ4[i])
+    {
+      responderBT("T%u sin datos\n", i + 1);
+      continue;
+    }
+    responderDecimas("MIN", i + 1, q4ADecimas(g.minQ4[i]));
+    responderDecimas("MAX", i + 1, q4ADecimas(g.maxQ4[i]));
+    responderDecimas("MEDIA", i + 1, q4ADecimas(g.mediaQ4[i]));
+  }
+}
+
+// TAREAS : uso de CPU desde el ultimo reporte y pila libre minima de cada
+// tarea; al final la frecuencia elegida por el gobernador y los segundos en
+// cada una desde el arranque
+void cmdTareas(uint8_t argc, char *argv[])
+{
+  uint32_t ventanaUs = reloj.micros() - tareasVentanaInicioUs;
+  responderBT("OK TAREAS ventana=%lums anillos perdidos=%lu\n", (unsigned long)(ventanaUs / 1000),
+              (unsigned long)perdidosAnillos());
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+    responderBT("%s cpu=%.1f%% pila=%luB\n", tareas[i]->nombre, usoCpu(*tareas[i], ventanaUs),
+                (unsigned long)pilaLibre(tareas[i]));
+  responderBT("gobernador %luMHz piso=%luMHz cambios=%lu vencidos=%lu\n", (unsigned long)gobernador.frecuencia(),
+              (unsigned long)gobernador.piso(), (unsigned long)gobernador.cambios(),
+              (unsigned long)gobernador.vencidos());
+  for (uint8_t i = 0; i < Gobernador::ESCALONES; i++)
+    responderBT("gobernador %luMHz=%lus\n", (unsigned long)Gobernador::mhz(i),
+                (unsigned long)(gobernador.tiempoUs(i) / 1000000));
+}
+
+// PERFIL [desde] : min/media/p99/max de cada etapa medida desde el arranque,
+// tambien por serie. Si la cola se llena, sigue con PERFIL <desde>.
+void cmdPerfil(uint8_t argc, char *argv[])
+{
+  uint32_t desde = 0;
+  if (argc == 1 && (!parsearEntero(argv[0], desde) || desde >= perfil.cantidad()))
+  {
+    responderBT("ERR uso: PERFIL [desde]\n");
+    return;
+  }
+  responderBT("OK PERFIL mhz=%lu\n", (unsigned long)perfil.frecuencia());
+  for (uint8_t i = desde; i < perfil.cantidad(); i++)
+  {
+    if (colaTx.libres() <= 1)
+    {
+      responderBT("SIGUE PERFIL %u\n", i);
+      return;
+    }
+    char linea[88]; // Deja lugar al salto de linea en responderBT()
+    perfil.describir(i, linea, sizeof(linea));
+    consola.printf("[PERFIL] %s\n", linea);
+    responderBT("%s\n", linea);
+  }
+}
+
+// MEM : heap libre, minimo y mayor bloque, asignaciones y liberaciones
+// desde el arranque y las etapas del perfilador que pidieron memoria
+void cmdMemoria(uint8_t argc, char *argv[])
+{
+  EstadoMemoria m = plataforma.memoria();
+  responderBT("OK MEM libre=%luB minimo=%luB bloque=%luB frag=%u%% asig=%lu lib=%lu\n", (unsigned long)m.libre,
+              (unsigned long)m.minimoLibre, (unsigned long)m.mayorBloque, fragmentacion(m),
+              (unsigned long)asignaciones(), (unsigned long)liberaciones());
+  for (uint8_t i = 0; i < perfil.cantidad(); i++)
+  {
+    uint32_t n = perfil.estadisticas(i).asignaciones;
+    if (n > 0)
+      responderBT("%s asignaciones=%lu\n", perfil.nombre(i), (unsigned long)n);
+  }
+}
+
+const Comando tablaComandos[] = {
+    {"SP", 2, 2, cmdConsigna},
+    {"ESTADO", 0, 0, cmdEstado},
+    {"RELE", 1, 2, cmdRele},
+    {"MODO", 1, 1, cmdModo},
+    {"TELEM", 1, 1, cmdTelemetria},
+    {"SUB", 0, 2, cmdSuscripcion},
+    {"HIST", 0, 1, cmdHistorial},
+    {"HORA", 0, 1, cmdHora},
+    {"RANGO", 2, 2, cmdRango},
+    {"RESUMEN", 0, 1, cmdResumen},
+    {"TAREAS", 0, 0, cmdTareas},
+    {"PERFIL", 0, 1, cmdPerfil},
+    {"MEM", 0, 0, cmdMemoria},
+};
+const size_t CANTIDAD_COMANDOS = sizeof(tablaComandos) / sizeof(tablaComandos[0]);
+
+void procesarEntradaBT()
+{
+  SondaEtapa sonda(perfil, ETAPA_BT_ENTRADA);
+  uint32_t inicio = reloj.micros();
+  for (uint8_t n = 0; n < MAX_BYTES_BT_POR_VUELTA && enlaceBT.disponible(); n++)
+  {
+    if (!lectorBT.consumir((char)enlaceBT.leer()))
+      continue;
+
+    char *linea = lectorBT.linea();
+    consola.printf("BT RECIBIDO: %s\n", linea);
+    switch (despacharComando(linea, tablaComandos, CANTIDAD_COMANDOS))
+    {
+    case CMD_DESCONOCIDO:
+      responderBT("ERR comando desconocido\n");
+      break;
+    case CMD_ARGUMENTOS:
+      responderBT("ERR argumentos\n");
+      break;
+    default:
+      break;
+    }
+  }
+  uint32_t duracion = reloj.micros() - inicio;
+  if (duracion > comandosMaxUs)
+    comandosMaxUs = duracion;
+}
+
+void manejarEventoTactil(const EventoTactil &ev)
+{
+  // Los botones actuan al soltar (click); el antirrebote ya lo hizo la maquina
+  if (ev.tipo != TOQUE_CLICK)
+    return;
+
+  uint16_t x = ev.x;
+  uint16_t y = ev.y;
+  // Cada boton arma la medicion de latencia con el trabajo de pantalla que lo
+  // responde, aunque lo encole otra tarea al recibir el cambio. Los toques
+  // fuera de los botones y el apagado de la pantalla no redibujan: no se miden.
+
+  // Esquina superior derecha: Toggle BT
+  if (y < 40 && x > 180)
+  {
+    if (pantallaEncendida)
+      busSPI.iniciarRespuesta(trabajoIndicadorBT, ev.us);
+    enviarOrden(interfazAComunicaciones, tareaComunicaciones, ORDEN_BLUETOOTH, 0, 0);
+    return;
+  }
+
+  if (!pantallaEncendida)
+  {
+    // Área de botón para despertar
+    if ((x > btn2X) && (x < (btn2X + btnW)) && (y > btnY) && (y < (btnY + btnH)))
+    {
+      busSPI.iniciarRespuesta(trabajoTemperaturas, ev.us); // El ultimo de la interfaz completa
+      gestionarModoEnergia(true);
+    }
+  }
+  else
+  {
+    // Botón Táctil ON/OFF
+    if ((x > btn1X) && (x < (btn1X + btnW)) && (y > btnY) && (y < (btnY + btnH)))
+    {
+      // Control lo cambia y publica el estado: los suscriptores de
+      // temaEstado redibujan el boton y envian el reporte
+      busSPI.iniciarRespuesta(trabajoBotonSistema, ev.us);
+      enviarOrden(interfazAControl, tareaControl, ORDEN_SISTEMA, 0, -1);
+      consola.printf("Tactil presionado: %s\n", vista.muestra.banderas & MUESTRA_SISTEMA ? "OFF" : "ON");
+    }
+    // Botón Sleep
+    else if ((x > btn2X) && (x < (btn2X + btnW)) && (y > btnY) && (y < (btnY + btnH)))
+    {
+      gestionarModoEnergia(false);
+    }
+  }
+}
+
+void reportarBusSPI()
+{
+  // Transacciones SPI por segundo en la ultima ventana (la CPU sale en [TAREAS])
+  const EstadisticasBusSPI &est = busSPI.estadisticas();
+  uint32_t ahoraUs = reloj.micros();
+  uint32_t ventanaUs = ahoraUs - tactilVentanaInicioUs;
+  if (ventanaUs > 0)
+  {
+    float segundos = ventanaUs / 1e6f;
+    consola.printf("[CARGA] tactil=%.1f/s pantalla=%.1f/s evitadas=%lu\n",
+                   (est.muestrasTactil - muestrasVentanaInicio) / segundos,
+                   (est.pasosPantalla - pasosVentanaInicio) / segundos,
+                   (unsigned long)est.muestrasEvitadas);
+  }
+  tactilVentanaInicioUs = ahoraUs;
+  muestrasVentanaInicio = est.muestrasTactil;
+  pasosVentanaInicio = est.pasosPantalla;
+
+  const HistogramaLatencia &lat = busSPI.latenciaToque();
+  if (lat.total == toquesReportados)
+    return;
+  toquesReportados = lat.total;
+
+  consola.printf("[SPI] toques=%lu p50=%luus p90=%luus p99=%luus max=%luus\n",
+                 (unsigned long)lat.total, (unsigned long)lat.percentil(50),
+                 (unsigned long)lat.percentil(90), (unsigned long)lat.percentil(99),
+                 (unsigned long)lat.maximo);
+  consola.printf("[SPI] muestras=%lu pasos=%lu pasoMax=%luus retrasoTactilMax=%luus\n",
+                 (unsigned long)est.muestrasTactil, (unsigned long)est.pasosPantalla,
+                 (unsigned long)est.pasoMaximoUs, (unsigned long)est.retrasoTactilMaxUs);
+}
+
+void reportarRegistro()
+{
+  const EstadisticasRegistro &est = registro.estadisticas();
+  if (est.lotes == lotesReportados)
+    return;
+  lotesReportados = est.lotes;
+  consola.printf("[LOG] lecturas=%lu..%lu lotes=%lu bytes=%lu borrados=%lu enLinea=%lu escritura=%luus peor=%luus sellados=%lu errores=%lu\n",
+                 (unsigned long)registro.inicio(), (unsigned long)registro.fin(), (unsigned long)est.lotes,
+                 (unsigned long)est.bytesEscritos, (unsigned long)est.borrados, (unsigned long)est.borradosEnLinea,
+                 (unsigned long)est.ultimaEscrituraUs, (unsigned long)est.peorEscrituraUs,
+                 (unsigned long)est.sellados, (unsigned long)est.errores);
+}
+
+// Retraso y duracion de cada trabajo en la ultima ventana. Lo llama la
+// tarea duena del planificador.
+void reportarPlanificador(Planificador &planificador)
+{
+  for (uint8_t i = 0; i < planificador.cantidad(); i++)
+  {
+    const EstadisticasTrabajo &e = planificador.estadisticas(i);
+    if (e.duracion.total == 0)
+      continue;
+    consola.printf("[PLAN] %s: n=%lu retraso p99=%luus max=%luus duracion p99=%luus max=%luus vencidos=%lu excedidos=%lu omitidos=%lu\n",
+                   planificador.nombre(i), (unsigned long)e.duracion.total,
+                   (unsigned long)e.retraso.percentil(99), (unsigned long)e.retraso.maximo,
+                   (unsigned long)e.duracion.percentil(99), (unsigned long)e.duracion.maximo,
+                   (unsigned long)e.vencidos, (unsigned long)e.excedidos, (unsigned long)e.omitidos);
+  }
+  planificador.reiniciarEstadisticas();
+}
+
+// CPU de cada tarea y lo minimo que le quedo libre de pila desde el arranque
+void reportarTareas()
+{
+  uint32_t ahora = reloj.micros();
+  uint32_t ventanaUs = ahora - tareasVentanaInicioUs;
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+  {
+    Tarea &t = *tareas[i];
+    consola.printf("[TAREAS] %s: cpu=%.1f%% pila libre=%luB\n", t.nombre, usoCpu(t, ventanaUs),
+                   (unsigned long)pilaLibre(&t));
+    t.ocupadoVentanaInicio = t.ocupadoUs;
+  }
+  consola.printf("[TAREAS] loop: pila libre=%luB anillos perdidos=%lu\n",
+                 (unsigned long)pilaLibre(nullptr), (unsigned long)perdidosAnillos());
+  tareasVentanaInicioUs = ahora;
+}
+
+// Heap y asignaciones desde el arranque. Una etapa con asignaciones es un
+// camino periodico que pide memoria.
+void reportarMemoria()
+{
+  EstadoMemoria m = plataforma.memoria();
+  consola.printf("[MEM] libre=%luB minimo=%luB mayor bloque=%luB frag=%u%% asignaciones=%lu liberaciones=%lu\n",
+                 (unsigned long)m.libre, (unsigned long)m.minimoLibre, (unsigned long)m.mayorBloque, fragmentacion(m),
+                 (unsigned long)asignaciones(), (unsigned long)liberaciones());
+  for (uint8_t i = 0; i < perfil.cantidad(); i++)
+  {
+    uint32_t n = perfil.estadisticas(i).asignaciones;
+    if (n > 0)
+      consola.printf("[MEM] %s: asignaciones=%lu\n", perfil.nombre(i), (unsigned long)n);
+  }
+}
+
+void enviarReporteEstado()
+{
+  const char *reporte = formatearReporteActual();
+  consola.escribir(reporte);
+  encolarEstadoBT(reporte);
+}
+
+const char *formatearReporteActual()
+{
+  static char reporte[TAM_REPORTE];
+  // Lo ultimo que publico control: el 1-Wire no se toca desde aca
+  Muestra m = muestraActual();
+  DatosReporte datos;
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    datos.valida[i] = (m.tempQ4[i] != TEMP_Q4_ERROR);
+    datos.tempQ4[i] = datos.valida[i] ? m.tempQ4[i] : 0;
+  }
+  datos.k1 = m.banderas & MUESTRA_K1;
+  datos.k2 = m.banderas & MUESTRA_K2;
+  datos.sistema = m.banderas & MUESTRA_SISTEMA;
+  datos.pantalla = m.banderas & MUESTRA_PANTALLA;
+  formatearReporte(reporte, sizeof(reporte), datos);
+  return reporte;
+}
+
+void toggleBluetooth()
+{
+  btActivo = !btActivo;
+  enviarOrden(comunicacionesAControl, tareaControl, ORDEN_PISO_CPU, 0, btActivo ? PISO_BT_MHZ : 0);
+  if (btActivo)
+  {
+    enviarOrden(comunicacionesAControl, tareaControl, ORDEN_IMPULSO_CPU, 0, 0);
+    enlaceBT.iniciar("ESP32_TFT_TEST");
+    consola.escribir("BT: Visible\n");
+  }
+  else
+  {
+    enlaceBT.detener();
+    consola.escribir("BT: Apagado\n");
+  }
+  if (btActivo)
+    tareaComunicaciones.planificador.activar(idComunicaciones);
+  else
+  {
+    procesarEventosBT(); // Lo que haya publicado el stack antes de apagarse
+    tareaComunicaciones.planificador.pausar(idComunicaciones);
+  }
+
+  temaBluetooth.publicar(btActivo);
+}
+
+void gestionarModoEnergia(bool despertar)
+{
+  if (despertar)
+  {
+    enviarOrden(interfazAControl, tareaControl, ORDEN_IMPULSO_CPU, 0, 0);
+    pantalla.encender(true);
+    gpio.escribir(PIN_BL, false); // LOW = ON
+    pantallaEncendida = true;
+
+    encolarInterfazCompleta();
+    reanudarInterfaz();
+  }
+  else
+  {
+    gpio.escribir(PIN_BL, false); // 0 = OFF
+    pantalla.encender(false);
+    pantallaEncendida = false; // El gobernador baja la CPU cuando cae la carga
+  }
+  temaPantalla.publicar(pantallaEncendida);
+}
+
+void actualizarTemperaturas()
+{
+  SondaEtapa sonda(perfil, ETAPA_TEMPERATURAS);
+  // Lo ultimo que publico control: el 1-Wire no se toca desde la interfaz
+  const int16_t *q4 = vista.muestra.tempQ4;
+  const int16_t xs[2] = {62, 177};
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (q4[i] == tempDibujadaQ4[i])
+      continue;
+    char texto[16];
+    EscritorTexto w(texto, sizeof(texto));
+    if (q4[i] == TEMP_Q4_ERROR)
+      w.texto("--.- C");
+    else
+      w.celsiusQ4(q4[i]).texto(" C");
+    pantalla.textoCentrado(w.c_str(), xs[i], 105, 4, COL_TEXTO, COL_CARD);
+    tempDibujadaQ4[i] = q4[i];
+  }
+}
+
+void actualizarVisualReles()
+{
+  bool k1 = vista.muestra.banderas & MUESTRA_K1;
+  bool k2 = vista.muestra.banderas & MUESTRA_K2;
+  int8_t dibujo = (k1 ? 1 : 0) | (k2 ? 2 : 0);
+  if (releDibujado == dibujo)
+    return;
+  releDibujado = dibujo;
+  pantalla.textoCentrado(k1 ? " ESTADO: ON " : " ESTADO: OFF", 62, 195, 2, k1 ? COL_BTN_ON : COL_SUBTEXTO, COL_CARD);
+  pantalla.textoCentrado(k2 ? " ESTADO: ON " : " ESTADO: OFF", 177, 195, 2, k2 ? COL_BTN_ON : COL_SUBTEXTO, COL_CARD);
+}
+
+void dibujarBotonSistema(bool estado)
+{
+  uint16_t color = estado ? COL_BTN_ON : COL_BTN_OFF;
+  pantalla.rellenarRedondeado(btn1X, btnY, btnW, btnH, 8, color);
+  pantalla.bordeRedondeado(btn1X, btnY, btnW, btnH, 8, COL_ACCENT);
+  pantalla.textoCentrado(estado ? "TACTIL ON" : "TACTIL OFF", btn1X + (btnW / 2), btnY + (btnH / 2), 2, COL_TEXTO);
+}
+
+void dibujarBotonBL()
+{
+  pantalla.rellenarRedondeado(btn2X, btnY, btnW, btnH, 8, COL_CARD);
+  pantalla.bordeRedondeado(btn2X, btnY, btnW, btnH, 8, COL_ACCENT);
+  pantalla.textoCentrado("SLEEP", btn2X + (btnW / 2), btnY + (btnH / 2), 2, COL_TEXTO);
+}
+
+void encolarInterfazCompleta()
+{
+  busSPI.encolarPantalla(dibujarInterfazBase);
+  busSPI.encolarPantalla(trabajoBotonSistema);
+  busSPI.encolarPantalla(trabajoBotonBL);
+  busSPI.encolarPantalla(trabajoReles);
+  busSPI.encolarPantalla(trabajoTemperaturas);
+}
+
+// El fondo completo son ~45ms de bus a 27MHz: se pinta en 8 franjas para que
+// el tactil se siga muestreando entre medio.
+bool dibujarInterfazBase(uint8_t paso)
+{
+  const uint8_t FRANJAS = 8;
+  const int altoFranja = 320 / FRANJAS;
+
+  if (paso < FRANJAS)
+  {
+    SondaEtapa sonda(perfil, ETAPA_FONDO);
+    if (paso == 0)
+    {
+      // Todo se repinta: invalidar lo dibujado antes
+      tempDibujadaQ4[0] = SIN_DIBUJAR;
+      tempDibujadaQ4[1] = SIN_DIBUJAR;
+      releDibujado = -1;
+    }
+    pantalla.rellenar(0, paso * altoFranja, 240, altoFranja, COL_FONDO);
+    return true;
+  }
+
+  switch (paso - FRANJAS)
+  {
+  case 0:
+    pantalla.rellenar(0, 0, 240, 40, COL_CARD);
+    pantalla.lineaHorizontal(0, 40, 240, COL_ACCENT);
+    pantalla.textoCentrado("PANEL DE CONTROL", 100, 20, 2, COL_TEXTO);
+    pantalla.rellenar(190, 5, 45, 30, btIndicado ? COL_ACCENT : COL_CARD);
+    pantalla.textoCentrado(btIndicado ? "BT ON" : "BT OFF", 212, 20, 1, COL_TEXTO);
+    return true;
+  case 1:
+    pantalla.bordeRedondeado(10, 55, 105, cardH, 8, COL_BORDE);
+    pantalla.bordeRedondeado(125, 55, 105, cardH, 8, COL_BORDE);
+    pantalla.bordeRedondeado(10, 150, 105, cardH, 8, COL_BORDE);
+    pantalla.bordeRedondeado(125, 150, 105, cardH, 8, COL_BORDE);
+    return true;
+  default:
+    pantalla.textoCentrado("Sensor 1", 62, 70, 2, COL_SUBTEXTO);
+    pantalla.textoCentrado("Sensor 2", 177, 70, 2, COL_SUBTEXTO);
+    pantalla.textoCentrado("Rele 1", 62, 165, 2, COL_SUBTEXTO);
+    pantalla.textoCentrado("Rele 2", 177, 165, 2, COL_SUBTEXTO);
+    return false;
+  }
+}
+
+void calibrarTactil()
+{
+  uint16_t calData[5];
+  const Ajustes &guardados = ajustes.leer();
+
+  if (guardados.calValida && !consola.hayEntrada())
+  {
+    // 1. Si hay calibracion confirmada, cargarla
+    memcpy(calData, guardados.calTactil, sizeof(calData));
+    tactil.calibracion(calData);
+    consola.printf("Calibracion cargada (registro #%lu)\n", (unsigned long)ajustes.secuencia());
+  }
+  else
+  {
+    // 2. Si no existe, ejecutar calibracion interactiva
+    tactil.calibrar(calData);
+
+    // 3. Confirmar en el almacen de ajustes (ranuras A/B con CRC)
+    Ajustes &nuevos = ajustes.editar();
+    memcpy(nuevos.calTactil, calData, sizeof(calData));
+    nuevos.calValida = 1;
+    if (ajustes.confirmar())
+    {
+      const EstadisticasAjustes &est = ajustes.estadisticas();
+      consola.printf("Calibracion guardada: %lu bytes en %luus\n",
+                     (unsigned long)est.ultimosBytes, (unsigned long)est.ultimaLatenciaUs);
+    }
+    else
+      consola.escribir("Error guardando calibracion\n");
+  }
+}
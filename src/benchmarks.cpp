@@ -0,0 +1,1032 @@
+#ifndef ARDUINO
+
+#include "benchmarks.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "anillo_spsc.h"
+#include "aplicacion.h"
+#include "bus_eventos.h"
+#include "cola_tx.h"
+#include "comandos.h"
+#include "compresion.h"
+#include "control.h"
+#include "flash_emulada.h"
+#include "memoria.h"
+#include "mensajes.h"
+#include "perfilador.h"
+#include "registro_datos.h"
+#include "reporte.h"
+#include "telemetria.h"
+#include "transporte_host.h"
+
+// Los resultados van a parar aca para que el compilador no descarte el trabajo
+static volatile uint32_t sumidero = 0;
+
+// Entradas que varian con la iteracion sin calcular nada en el paso: una
+// rampa de 64 valores alrededor de la consigna (25.0 C)
+static const uint8_t TAM_RAMPA = 64;
+static int16_t rampaQ4[TAM_RAMPA];
+static int16_t rampaDecimas[TAM_RAMPA];
+static float rampaCelsius[TAM_RAMPA];
+
+static void prepararRampa()
+{
+  for (uint8_t i = 0; i < TAM_RAMPA; i++)
+  {
+    int16_t q4 = (int16_t)(25 * 16 - TAM_RAMPA / 2 + (i < TAM_RAMPA / 2 ? i * 2 : (TAM_RAMPA - i) * 2));
+    rampaQ4[i] = q4;
+    rampaDecimas[i] = q4ADecimas(q4);
+    rampaCelsius[i] = q4 / 16.0f;
+  }
+}
+
+// --- Reporte de estado (enviarReporteEstado) ---
+static void pasoReporte(uint32_t i)
+{
+  char buf[TAM_REPORTE];
+  DatosReporte d;
+  d.tempQ4[0] = rampaQ4[i % TAM_RAMPA];
+  d.tempQ4[1] = rampaQ4[(i + TAM_RAMPA / 2) % TAM_RAMPA];
+  d.valida[0] = true;
+  d.valida[1] = (i & 0xFF) != 0;
+  d.k1 = i & 1;
+  d.k2 = !(i & 1);
+  d.sistema = true;
+  d.pantalla = i & 2;
+  sumidero += formatearReporte(buf, sizeof(buf), d);
+}
+
+// El mismo reporte como lo armaba antes enviarReporteEstado(): String con
+// sus concatenaciones y String(t, 1). std::string hace de String y esta es
+// la conversion de dtostrf() del core del ESP32 (ancho 3, un decimal).
+static std::string celsiusString(float t)
+{
+  char buf[16];
+  char *out = buf;
+  double v = t;
+  if (v < 0.0)
+  {
+    *out++ = '-';
+    v = -v;
+  }
+  v += 0.05;
+  double potencia = 1.0;
+  int digitos = 1;
+  while (v >= 10.0 * potencia)
+  {
+    potencia *= 10.0;
+    digitos++;
+  }
+  v /= potencia;
+  digitos += 1;
+  while (digitos-- > 0)
+  {
+    int digito = (int)v;
+    if (digito > 9)
+      digito = 9;
+    *out++ = (char)('0' | digito);
+    if (digitos == 1)
+      *out++ = '.';
+    v = (v - digito) * 10.0;
+  }
+  *out = '\0';
+  return buf;
+}
+
+static void pasoReporteString(uint32_t i)
+{
+  float t1 = rampaCelsius[i % TAM_RAMPA];
+  float t2 = rampaCelsius[(i + TAM_RAMPA / 2) % TAM_RAMPA];
+  bool valida2 = (i & 0xFF) != 0;
+  std::string reporte = "\n--- REPORTE ESP32 ---\n";
+  reporte += "S1: " + celsiusString(t1) + "C" + " | ";
+  reporte += "S2: " + (!valida2 ? std::string("ERR") : celsiusString(t2) + "C") + "\n";
+  reporte += "Reles: K1=" + std::string(i & 1 ? "ON" : "OFF") + " K2=" + std::string(!(i & 1) ? "ON" : "OFF") + "\n";
+  reporte += "Tactil: " + std::string("ENCENDIDO") + "\n";
+  reporte += "Pantalla: " + std::string(i & 2 ? "ON" : "SLEEP") + "\n";
+  reporte += "---------------------\n";
+  sumidero += reporte.size();
+}
+
+// --- Temperatura a texto (actualizarTemperaturas) ---
+static void pasoCelsius(uint32_t i)
+{
+  char buf[16];
+  EscritorTexto w(buf, sizeof(buf));
+  w.celsiusQ4(rampaQ4[i % TAM_RAMPA]).texto(" C");
+  sumidero += w.largo();
+}
+
+// --- Control: filtro y termostato de los dos canales (aplicarControl) ---
+static FiltroTemperatura filtrosBench[2];
+static bool relesBench[2];
+
+static void prepararControl()
+{
+  for (uint8_t c = 0; c < 2; c++)
+  {
+    filtrosBench[c].reiniciar();
+    relesBench[c] = false;
+  }
+}
+
+static void pasoFiltro(uint32_t i)
+{
+  sumidero += filtrosBench[0].paso(rampaDecimas[i % TAM_RAMPA]);
+  sumidero += filtrosBench[1].paso(rampaDecimas[(i + TAM_RAMPA / 2) % TAM_RAMPA]);
+}
+
+static void pasoControl(uint32_t i)
+{
+  for (uint8_t c = 0; c < 2; c++)
+  {
+    int16_t medida = filtrosBench[c].paso(rampaDecimas[(i + c * TAM_RAMPA / 2) % TAM_RAMPA]);
+    relesBench[c] = pasoTermostato(relesBench[c], medida, 250, 5);
+    sumidero += relesBench[c];
+  }
+}
+
+// --- Diferencia de pantalla (trabajos del bus SPI de la interfaz) ---
+// Sin cambios solo compara; con cambios una temperatura y los reles cambian
+// en cada paso y se redibujan sobre PantallaHost.
+static void prepararRender()
+{
+  memset(&vista, 0, sizeof(vista));
+  vista.muestra.tempQ4[0] = vista.muestra.tempQ4[1] = 25 * 16;
+  actualizarTemperaturas();
+  actualizarVisualReles();
+}
+
+static void pasoRenderSinCambios(uint32_t)
+{
+  actualizarTemperaturas();
+  actualizarVisualReles();
+}
+
+static void pasoRenderConCambios(uint32_t i)
+{
+  vista.muestra.tempQ4[i & 1] = rampaQ4[i % TAM_RAMPA];
+  vista.muestra.banderas = (uint8_t)(i & (MUESTRA_K1 | MUESTRA_K2));
+  actualizarTemperaturas();
+  actualizarVisualReles();
+}
+
+// --- Comandos: lector de lineas y despacho (procesarEntradaBT) ---
+// Nombres y cantidad de argumentos de la tabla de la aplicacion; cada
+// comando solo parsea sus argumentos (numero o decimas), sin efectos
+static const uint8_t MAX_COMANDOS_BENCH = 32;
+static Comando comandosBench[MAX_COMANDOS_BENCH];
+static size_t cantidadComandosBench = 0;
+
+static void parsearArgumentos(uint8_t argc, char *argv[])
+{
+  for (uint8_t i = 0; i < argc; i++)
+  {
+    uint32_t entero = 0;
+    int16_t decimas = 0;
+    if (parsearEntero(argv[i], entero))
+      sumidero += entero;
+    else if (parsearDecimas(argv[i], decimas))
+      sumidero += decimas;
+    else
+      sumidero += igualSinMayusculas(argv[i], "ESTADO");
+  }
+}
+
+static const char *const LINEAS_BENCH[] = {"SP 1 30.5\n", "modo auto\n", "ESTADO\n", "SUB ESTADO 2000\n",
+                                           "RELE 2 1\n"};
+static const uint8_t CANTIDAD_LINEAS_BENCH = sizeof(LINEAS_BENCH) / sizeof(LINEAS_BENCH[0]);
+static LectorLineas lectorBench;
+
+static void prepararComando()
+{
+  cantidadComandosBench = CANTIDAD_COMANDOS < MAX_COMANDOS_BENCH ? CANTIDAD_COMANDOS : MAX_COMANDOS_BENCH;
+  for (size_t i = 0; i < cantidadComandosBench; i++)
+  {
+    comandosBench[i] = tablaComandos[i];
+    comandosBench[i].ejecutar = parsearArgumentos;
+  }
+  // Todas las lineas tienen que llegar a su comando: si no, se mediria el error
+  for (uint8_t i = 0; i < CANTIDAD_LINEAS_BENCH; i++)
+  {
+    char linea[LectorLineas::MAX_LINEA + 1];
+    strncpy(linea, LINEAS_BENCH[i], sizeof(linea) - 1);
+    linea[sizeof(linea) - 1] = '\0';
+    linea[strcspn(linea, "\n")] = '\0';
+    if (despacharComando(linea, comandosBench, cantidadComandosBench) != CMD_OK)
+      fprintf(stderr, "comando: \"%s\" no despacha\n", LINEAS_BENCH[i]);
+  }
+}
+
+static void pasoComando(uint32_t i)
+{
+  for (const char *c = LINEAS_BENCH[i % CANTIDAD_LINEAS_BENCH]; *c; c++)
+  {
+    if (lectorBench.consumir(*c))
+      sumidero += despacharComando(lectorBench.linea(), comandosBench, cantidadComandosBench);
+  }
+}
+
+// --- Comandos por vuelta (procesarEntradaBT) ---
+// Un flujo de bytes que se entrega de a MAX_BYTES_BT_POR_VUELTA (64) por
+// paso, como llega del enlace: comandos validos, uno desconocido, uno con
+// argumentos de mas y una linea demasiado larga que se descarta. Informa
+// bytes_s. Aparte se cronometra cada vuelta por separado para el
+// peor caso (incluye leer el reloj, unos 20 ns).
+static const uint8_t BYTES_POR_VUELTA_BENCH = 64;
+static char flujoBench[512];
+static size_t largoFlujoBench = 0;
+static LectorLineas lectorVueltaBench;
+static uint32_t lineasVueltaBench = 0;
+
+static void prepararComandoVuelta()
+{
+  prepararComando();
+  largoFlujoBench = 0;
+  for (uint8_t i = 0; i < CANTIDAD_LINEAS_BENCH; i++)
+    largoFlujoBench += snprintf(flujoBench + largoFlujoBench, sizeof(flujoBench) - largoFlujoBench, "%s",
+                                LINEAS_BENCH[i]);
+  largoFlujoBench += snprintf(flujoBench + largoFlujoBench, sizeof(flujoBench) - largoFlujoBench,
+                              "FOO 1\nRELE 1 2 3\n%0100d\n", 0);
+  lineasVueltaBench = 0;
+}
+
+static void pasoComandoVuelta(uint32_t i)
+{
+  size_t desde = (size_t)i * BYTES_POR_VUELTA_BENCH % largoFlujoBench;
+  for (uint8_t n = 0; n < BYTES_POR_VUELTA_BENCH; n++)
+  {
+    if (!lectorVueltaBench.consumir(flujoBench[(desde + n) % largoFlujoBench]))
+      continue;
+    lineasVueltaBench++;
+    sumidero += despacharComando(lectorVueltaBench.linea(), comandosBench, cantidadComandosBench);
+  }
+}
+
+static double ahoraNs();
+
+// El flujo se repite cada P vueltas con el lector en el mismo estado: cada
+// una de esas P vueltas se cronometra RONDAS veces y de cada una se toma la
+// mediana. El peor caso es la mayor de esas medianas, sin el ruido del
+// sistema que tiene el maximo crudo.
+static void informarComandoVuelta()
+{
+  static const uint16_t RONDAS = 101;
+  static uint32_t ns[sizeof(flujoBench)][RONDAS];
+  size_t a = largoFlujoBench, b = BYTES_POR_VUELTA_BENCH;
+  while (b)
+  {
+    size_t r = a % b;
+    a = b;
+    b = r;
+  }
+  uint32_t periodo = (uint32_t)(largoFlujoBench / a);
+
+  uint32_t lineas = lineasVueltaBench;
+  for (uint16_t r = 0; r < RONDAS; r++)
+  {
+    for (uint32_t k = 0; k < periodo; k++)
+    {
+      double inicio = ahoraNs();
+      pasoComandoVuelta(r * periodo + k);
+      ns[k][r] = (uint32_t)(ahoraNs() - inicio);
+    }
+  }
+  lineas = lineasVueltaBench - lineas;
+
+  uint32_t peor = 0;
+  for (uint32_t k = 0; k < periodo; k++)
+  {
+    std::sort(ns[k], ns[k] + RONDAS);
+    peor = std::max(peor, ns[k][RONDAS / 2]);
+  }
+  printf(",\"lineas_por_vuelta\":%.2f,\"vuelta_ns_peor\":%lu", (double)lineas / (RONDAS * periodo),
+         (unsigned long)peor);
+}
+
+// --- Registro: una lectura al lote comprimido (RegistroDatos::agregar) ---
+static uint8_t loteBench[CodificadorBloque::maxBytes(32)];
+static CodificadorBloque codificadorBench;
+
+static void prepararRegistro() { codificadorBench.iniciar(loteBench, sizeof(loteBench)); }
+
+static void pasoRegistro(uint32_t i)
+{
+  Lectura l;
+  l.t = i * 2;
+  l.tempQ4[0] = rampaQ4[i % TAM_RAMPA];
+  l.tempQ4[1] = rampaQ4[(i + TAM_RAMPA / 2) % TAM_RAMPA];
+  l.banderas = MUESTRA_SISTEMA | (i & 1);
+  if (codificadorBench.cantidad() == 32)
+    codificadorBench.iniciar(loteBench, sizeof(loteBench));
+  codificadorBench.agregar(l);
+  sumidero += codificadorBench.bytes();
+}
+
+// Lecturas cada 2 s sobre la rampa con +-1 LSB de ruido de sensor, como
+// las que llegan al registro
+static Lectura lecturaBench(uint32_t i)
+{
+  Lectura l;
+  l.t = i * 2;
+  l.tempQ4[0] = (int16_t)(rampaQ4[(i / 8) % TAM_RAMPA] + (int16_t)(i * 7 % 3) - 1);
+  l.tempQ4[1] = (int16_t)(rampaQ4[(i / 8 + TAM_RAMPA / 2) % TAM_RAMPA] + (int16_t)(i * 5 % 3) - 1);
+  l.banderas = MUESTRA_SISTEMA | ((i / 300) & 1);
+  return l;
+}
+
+// --- Registro en flash: agregar una lectura (guardarLectura) ---
+// Sobre una flash emulada del tamano de la particion, cuyo reloj simulado
+// tambien es el del registro: el bloqueo de cada lote sale en us de flash.
+// Entre lotes corre mantenimiento() como en la tarea de comunicaciones.
+static FlashEmulada flashBench(0xB0000);
+static uint32_t relojFlashBench() { return flashBench.tiempoUs(); }
+static RegistroDatos registroFlashBench(flashBench, relojFlashBench);
+static uint32_t lecturasFlashBench = 0;
+static uint32_t flashUsInicioBench = 0;
+
+static void prepararRegistroFlash()
+{
+  registroFlashBench.begin();
+  lecturasFlashBench = 0;
+  flashUsInicioBench = flashBench.tiempoUs();
+}
+
+static void pasoRegistroFlash(uint32_t)
+{
+  registroFlashBench.agregar(lecturaBench(lecturasFlashBench++));
+  if (lecturasFlashBench % RegistroDatos::LECTURAS_POR_LOTE == 0)
+    registroFlashBench.mantenimiento();
+}
+
+static void informarRegistroFlash()
+{
+  const EstadisticasRegistro &e = registroFlashBench.estadisticas();
+  double lecturas = lecturasFlashBench ? lecturasFlashBench : 1;
+  // Una lectura cada 2 s: bytes/s que recibe la flash y bloqueo de flash
+  printf(",\"flash_b_por_lectura\":%.2f,\"flash_b_s\":%.2f,\"flash_us_por_lectura\":%.1f,"
+         "\"peor_lote_us\":%lu,\"borrados_en_linea\":%lu",
+         e.bytesEscritos / lecturas, e.bytesEscritos / lecturas / 2,
+         (flashBench.tiempoUs() - flashUsInicioBench) / lecturas, (unsigned long)e.peorEscrituraUs,
+         (unsigned long)e.borradosEnLinea);
+}
+
+// --- Compresion: bloques enteros de un lote (CodificadorBloque) ---
+// Una traza de 64 lotes; codificar arma un bloque por paso y decodificar
+// recorre uno ya armado. Informa lecturas_s.
+static const uint8_t LOTES_BLOQUE_BENCH = 64;
+static const uint8_t LECTURAS_BLOQUE_BENCH = RegistroDatos::LECTURAS_POR_LOTE;
+static const size_t MAX_BYTES_BLOQUE_BENCH = CodificadorBloque::maxBytes(LECTURAS_BLOQUE_BENCH);
+static Lectura trazaBloqueBench[LOTES_BLOQUE_BENCH][LECTURAS_BLOQUE_BENCH];
+static uint8_t bloquesBench[LOTES_BLOQUE_BENCH][MAX_BYTES_BLOQUE_BENCH];
+static size_t largoBloquesBench[LOTES_BLOQUE_BENCH];
+
+static size_t codificarBloqueBench(uint8_t lote, uint8_t *buf)
+{
+  CodificadorBloque c;
+  c.iniciar(buf, MAX_BYTES_BLOQUE_BENCH);
+  for (uint8_t k = 0; k < LECTURAS_BLOQUE_BENCH; k++)
+    c.agregar(trazaBloqueBench[lote][k]);
+  return c.bytes();
+}
+
+static void prepararBloque()
+{
+  for (uint8_t b = 0; b < LOTES_BLOQUE_BENCH; b++)
+  {
+    for (uint8_t k = 0; k < LECTURAS_BLOQUE_BENCH; k++)
+      trazaBloqueBench[b][k] = lecturaBench(b * LECTURAS_BLOQUE_BENCH + k);
+    largoBloquesBench[b] = codificarBloqueBench(b, bloquesBench[b]);
+
+    // Ida y vuelta exacta: si no, se mediria otra cosa
+    DecodificadorBloque d(bloquesBench[b], largoBloquesBench[b], LECTURAS_BLOQUE_BENCH);
+    Lectura l;
+    for (uint8_t k = 0; k < LECTURAS_BLOQUE_BENCH; k++)
+    {
+      const Lectura &e = trazaBloqueBench[b][k];
+      if (!d.siguiente(l) || l.t != e.t || l.tempQ4[0] != e.tempQ4[0] || l.tempQ4[1] != e.tempQ4[1] ||
+          l.banderas != e.banderas)
+      {
+        fprintf(stderr, "bloque: el lote %u no vuelve igual\n", (unsigned)b);
+        break;
+      }
+    }
+  }
+}
+
+static void pasoCodificarBloque(uint32_t i)
+{
+  uint8_t buf[MAX_BYTES_BLOQUE_BENCH];
+  sumidero += codificarBloqueBench(i % LOTES_BLOQUE_BENCH, buf);
+}
+
+static void pasoDecodificarBloque(uint32_t i)
+{
+  uint8_t b = i % LOTES_BLOQUE_BENCH;
+  DecodificadorBloque d(bloquesBench[b], largoBloquesBench[b], LECTURAS_BLOQUE_BENCH);
+  Lectura l;
+  while (d.siguiente(l))
+    sumidero += l.tempQ4[0];
+}
+
+static void informarBloque()
+{
+  size_t bytes = 0;
+  for (uint8_t b = 0; b < LOTES_BLOQUE_BENCH; b++)
+    bytes += largoBloquesBench[b];
+  double lecturas = (double)LOTES_BLOQUE_BENCH * LECTURAS_BLOQUE_BENCH;
+  // Sin comprimir, una lectura ocupa lo mismo que la primera del bloque
+  printf(",\"bits_por_lectura\":%.2f,\"bits_crudos\":%u", bytes * 8 / lecturas,
+         (unsigned)CodificadorBloque::BITS_PRIMERA);
+}
+
+// --- Consultas al registro (RANGO) segun el tamano del log ---
+// Un solo log sobre su propia flash emulada que crece de un benchmark al
+// siguiente (van de menor a mayor). Cada paso es una consulta en un punto
+// pseudoaleatorio del log: buscarMarca() sola, o la de RANGO (dos busquedas
+// y resumir() de una hora).
+static FlashEmulada flashConsultaBench(0xB0000);
+static uint32_t relojConsultaBench() { return flashConsultaBench.tiempoUs(); }
+static RegistroDatos registroConsultaBench(flashConsultaBench, relojConsultaBench);
+static uint32_t lecturasConsultaBench = 0;
+static uint32_t consultasBench = 0;
+static uint32_t cabecerasInicioBench = 0;
+static uint32_t decodificadosInicioBench = 0;
+static const uint32_t VENTANA_RANGO_BENCH_S = 3600;
+
+template <uint16_t LOTES>
+static void prepararConsulta()
+{
+  if (lecturasConsultaBench == 0)
+    registroConsultaBench.begin();
+  while (lecturasConsultaBench < (uint32_t)LOTES * RegistroDatos::LECTURAS_POR_LOTE)
+  {
+    registroConsultaBench.agregar(lecturaBench(lecturasConsultaBench++));
+    if (lecturasConsultaBench % RegistroDatos::LECTURAS_POR_LOTE == 0)
+      registroConsultaBench.mantenimiento();
+  }
+  consultasBench = 0;
+  cabecerasInicioBench = registroConsultaBench.estadisticas().cabecerasLeidas;
+  decodificadosInicioBench = registroConsultaBench.estadisticas().lotesDecodificados;
+}
+
+// Marca dentro de lo que queda en flash, repartida por todo el log
+static uint32_t marcaConsulta(uint32_t i)
+{
+  uint32_t primera = lecturaBench(registroConsultaBench.inicio()).t;
+  uint32_t ultima = lecturaBench(registroConsultaBench.fin() - 1).t;
+  return primera + (uint32_t)((i * 2654435761u) % (ultima - primera + 1));
+}
+
+static void pasoBuscarMarca(uint32_t i)
+{
+  consultasBench++;
+  sumidero += registroConsultaBench.buscarMarca(marcaConsulta(i));
+}
+
+static void pasoRango(uint32_t i)
+{
+  consultasBench++;
+  uint32_t desde = marcaConsulta(i);
+  ResumenLecturas r;
+  registroConsultaBench.resumir(registroConsultaBench.buscarMarca(desde),
+                                registroConsultaBench.buscarMarca(desde + VENTANA_RANGO_BENCH_S), r);
+  sumidero += r.maxQ4[0];
+}
+
+static void informarConsulta()
+{
+  const EstadisticasRegistro &e = registroConsultaBench.estadisticas();
+  double consultas = consultasBench ? consultasBench : 1;
+  uint32_t lotes = (registroConsultaBench.fin() - registroConsultaBench.inicio()) / RegistroDatos::LECTURAS_POR_LOTE;
+  printf(",\"lotes_en_log\":%lu,\"cabeceras_por_consulta\":%.1f,\"lotes_decodificados_por_consulta\":%.2f",
+         (unsigned long)lotes, (e.cabecerasLeidas - cabecerasInicioBench) / consultas,
+         (e.lotesDecodificados - decodificadosInicioBench) / consultas);
+}
+
+// --- Telemetria: muestras empaquetadas en tramas COBS ---
+// Una muestra por trama (lo que manda cada ciclo de sensores) y lotes de
+// MUESTRAS_LOTE_TRAMA, codificando y decodificando. Informa muestras_s, y
+// bytes_por_muestra es lo que cuesta cada una en el enlace, con
+// delimitador incluido.
+static const uint8_t MUESTRAS_LOTE_TRAMA = (MAX_CARGA_TRAMA - 1) / MUESTRA_BYTES;
+static const uint8_t TRAMAS_DECODIFICAR_BENCH = TAM_RAMPA;
+static CodificadorTramas tramasBench;
+static DecodificadorTramas decodificadorBench;
+static uint8_t tramasDecodificarBench[TRAMAS_DECODIFICAR_BENCH][MAX_TRAMA];
+static size_t largoTramasDecodificarBench[TRAMAS_DECODIFICAR_BENCH];
+static uint32_t bytesTramasBench = 0;
+static uint32_t muestrasTramasBench = 0;
+
+static Muestra muestraBench(uint32_t i)
+{
+  Muestra m;
+  m.ms = i * 2000;
+  m.tempQ4[0] = rampaQ4[i % TAM_RAMPA];
+  m.tempQ4[1] = rampaQ4[(i + TAM_RAMPA / 2) % TAM_RAMPA];
+  m.banderas = MUESTRA_SISTEMA | MUESTRA_PANTALLA | (i & 0x40 ? MUESTRA_K1 : 0);
+  return m;
+}
+
+// Las 'n' muestras que siguen a la 'i' en una trama TRAMA_MUESTRAS
+static size_t tramaMuestras(uint32_t i, uint8_t n, uint8_t *trama)
+{
+  uint8_t carga[MAX_CARGA_TRAMA];
+  size_t len = 1;
+  carga[0] = n;
+  for (uint8_t k = 0; k < n; k++)
+    len += empaquetarMuestra(muestraBench(i + k), carga + len);
+  return tramasBench.codificar(TRAMA_MUESTRAS, carga, len, trama);
+}
+
+template <uint8_t N>
+static void pasoCodificarTrama(uint32_t i)
+{
+  uint8_t trama[MAX_TRAMA];
+  size_t n = tramaMuestras(i * N, N, trama);
+  sumidero += trama[n / 2];
+}
+
+template <uint8_t N>
+static void prepararTrama()
+{
+  bytesTramasBench = 0;
+  muestrasTramasBench = 0;
+  for (uint8_t t = 0; t < TRAMAS_DECODIFICAR_BENCH; t++)
+  {
+    largoTramasDecodificarBench[t] = tramaMuestras((uint32_t)t * N, N, tramasDecodificarBench[t]);
+    bytesTramasBench += largoTramasDecodificarBench[t];
+    muestrasTramasBench += N;
+  }
+}
+
+// Lo que hace el cliente: byte a byte por el decodificador y cada registro
+// de vuelta a Muestra
+static void pasoDecodificarTrama(uint32_t i)
+{
+  uint8_t t = i % TRAMAS_DECODIFICAR_BENCH;
+  const uint8_t *trama = tramasDecodificarBench[t];
+  for (size_t k = 0; k < largoTramasDecodificarBench[t]; k++)
+  {
+    if (!decodificadorBench.consumir(trama[k]))
+      continue;
+    const uint8_t *carga = decodificadorBench.carga();
+    for (uint8_t r = 0; r < carga[0]; r++)
+    {
+      Muestra m;
+      desempaquetarMuestra(carga + 1 + r * MUESTRA_BYTES, m);
+      sumidero += m.ms + (uint16_t)m.tempQ4[1];
+    }
+  }
+}
+
+static void informarTrama()
+{
+  printf(",\"bytes_por_muestra\":%.2f,\"tramas_descartadas\":%lu",
+         (double)bytesTramasBench / muestrasTramasBench, (unsigned long)decodificadorBench.descartadas());
+}
+
+// --- Transporte de host: bytes por segundo por el PTY y el socketpair ---
+// Cada paso pasa una ranura de la cola de transmision de punta a punta: la
+// aplicacion escribe y el cliente lee hasta recibirla entera, o el cliente
+// escribe y la aplicacion la consume con leer() byte a byte como el lector
+// de comandos. Si el kernel se llena se drena y se reintenta, asi que bytes_s
+// es el caudal sostenido.
+static const size_t BYTES_TRANSPORTE_BENCH = ColaTransmision::TAM_RANURA;
+static TransporteHost transportePtyBench(TransporteHost::PTY);
+static TransporteHost transporteSocketsBench(TransporteHost::PAR_SOCKETS);
+static TransporteHost *transporteBench = nullptr;
+static int clienteTransporteBench = -1;
+static int clientePtyBench = -1;
+static int clienteSocketsBench = -1;
+static uint8_t bloqueTransporteBench[BYTES_TRANSPORTE_BENCH];
+static uint32_t congestionesBench = 0;
+
+static void contarCongestion(EventoTransporte evento)
+{
+  if (evento == TRANSPORTE_CONGESTIONADO)
+    congestionesBench++;
+}
+
+static int abrirPtyBench()
+{
+  if (!transportePtyBench.iniciar("bench"))
+    return -1;
+  int fd = open(transportePtyBench.rutaPty(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  struct termios t;
+  if (fd >= 0 && tcgetattr(fd, &t) == 0)
+  {
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  return fd;
+}
+
+template <TransporteHost::Modo MODO>
+static void prepararTransporte()
+{
+  if (MODO == TransporteHost::PTY)
+  {
+    if (clientePtyBench < 0)
+      clientePtyBench = abrirPtyBench();
+    transporteBench = &transportePtyBench;
+    clienteTransporteBench = clientePtyBench;
+  }
+  else
+  {
+    if (clienteSocketsBench < 0)
+      clienteSocketsBench = transporteSocketsBench.conectarCliente();
+    transporteBench = &transporteSocketsBench;
+    clienteTransporteBench = clienteSocketsBench;
+  }
+  transporteBench->alEvento(contarCongestion);
+  transporteBench->hayCliente();
+  congestionesBench = 0;
+  for (size_t k = 0; k < BYTES_TRANSPORTE_BENCH; k++)
+    bloqueTransporteBench[k] = (uint8_t)(' ' + k % 64);
+}
+
+static bool transporteListo()
+{
+  return clienteTransporteBench >= 0 && transporteBench->hayCliente();
+}
+
+static size_t drenarClienteBench()
+{
+  uint8_t buf[512];
+  ssize_t n = read(clienteTransporteBench, buf, sizeof(buf));
+  if (n <= 0)
+    return 0;
+  sumidero += buf[n - 1];
+  return (size_t)n;
+}
+
+static void pasoTransporteEscribir(uint32_t)
+{
+  if (!transporteListo())
+    return;
+  size_t escritos = 0;
+  size_t recibidos = 0;
+  while (recibidos < BYTES_TRANSPORTE_BENCH)
+  {
+    if (escritos < BYTES_TRANSPORTE_BENCH)
+      escritos += transporteBench->escribir(bloqueTransporteBench + escritos, BYTES_TRANSPORTE_BENCH - escritos);
+    recibidos += drenarClienteBench();
+  }
+}
+
+static void pasoTransporteLeer(uint32_t)
+{
+  if (!transporteListo())
+    return;
+  size_t escritos = 0;
+  size_t leidos = 0;
+  while (leidos < BYTES_TRANSPORTE_BENCH)
+  {
+    if (escritos < BYTES_TRANSPORTE_BENCH)
+    {
+      ssize_t n = write(clienteTransporteBench, bloqueTransporteBench + escritos, BYTES_TRANSPORTE_BENCH - escritos);
+      if (n > 0)
+        escritos += (size_t)n;
+    }
+    int c;
+    while ((c = transporteBench->leer()) >= 0)
+    {
+      sumidero += (uint32_t)c;
+      leidos++;
+    }
+  }
+}
+
+static void informarTransporte()
+{
+  printf(",\"conectado\":%s,\"congestiones\":%lu", transporteListo() ? "true" : "false",
+         (unsigned long)congestionesBench);
+}
+
+// --- Anillo SPSC: una rafaga de muestras de una tarea a otra ---
+// Productor y consumidor en el mismo hilo: el costo de las dos puntas sin
+// contencion, que es lo que paga cada tarea por muestra
+static const uint8_t RAFAGA_ANILLO = 4;
+static AnilloSpsc<Muestra, 8> anilloBench;
+
+static void pasoAnillo(uint32_t i)
+{
+  Muestra m;
+  m.ms = i;
+  m.tempQ4[0] = rampaQ4[i % TAM_RAMPA];
+  m.tempQ4[1] = rampaQ4[(i + TAM_RAMPA / 2) % TAM_RAMPA];
+  m.banderas = MUESTRA_SISTEMA;
+  for (uint8_t k = 0; k < RAFAGA_ANILLO; k++)
+  {
+    m.ms += k;
+    sumidero += anilloBench.publicar(m);
+  }
+  while (anilloBench.siguiente(m))
+    sumidero += m.ms;
+}
+
+// --- Anillo SPSC entre dos hilos: caudal con las dos puntas a la vez ---
+// El hilo del benchmark publica la rafaga y un consumidor aparte la saca,
+// cada uno fijado a su nucleo si hay mas de uno, asi los indices y las
+// ranuras viajan de verdad entre caches. El productor reintenta si esta
+// lleno: muestras_s es el caudal sostenido. El consumidor verifica el orden
+// y termina en informar(); lleno_por_muestra dice cuanto espero el productor.
+static const uint8_t ESPERAS_ANTES_DE_CEDER = 64;
+static AnilloSpsc<Muestra, 8> anilloHilosBench;
+static std::thread consumidorBench;
+static std::atomic<bool> pararConsumidorBench(false);
+static std::atomic<uint32_t> consumidasBench(0);
+static uint32_t fueraDeOrdenBench = 0;
+static uint32_t publicadasBench = 0;
+static cpu_set_t afinidadOriginalBench;
+static bool fijadosBench = false;
+
+// En un solo nucleo esperar girando le quita el turno al otro hilo: despues
+// de unas vueltas se cede
+static void esperarOtroHilo(uint8_t &vueltas)
+{
+  if (++vueltas >= ESPERAS_ANTES_DE_CEDER)
+  {
+    vueltas = 0;
+    std::this_thread::yield();
+  }
+}
+
+static bool fijarANucleo(pthread_t hilo, int nucleo)
+{
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(nucleo, &cpus);
+  return pthread_setaffinity_np(hilo, sizeof(cpus), &cpus) == 0;
+}
+
+static void consumirAnilloHilos()
+{
+  uint32_t esperada = 0;
+  uint8_t vueltas = 0;
+  Muestra m;
+  for (;;)
+  {
+    if (!anilloHilosBench.siguiente(m))
+    {
+      if (pararConsumidorBench.load(std::memory_order_acquire) && anilloHilosBench.vacio())
+        break;
+      esperarOtroHilo(vueltas);
+      continue;
+    }
+    if (m.ms != esperada)
+      fueraDeOrdenBench++;
+    esperada = m.ms + 1;
+    consumidasBench.store(consumidasBench.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+}
+
+static void prepararAnilloHilos()
+{
+  pararConsumidorBench.store(false);
+  consumidasBench.store(0);
+  fueraDeOrdenBench = 0;
+  publicadasBench = 0;
+  pthread_getaffinity_np(pthread_self(), sizeof(afinidadOriginalBench), &afinidadOriginalBench);
+  consumidorBench = std::thread(consumirAnilloHilos);
+  fijadosBench = std::thread::hardware_concurrency() > 1 && fijarANucleo(pthread_self(), 0) &&
+                 fijarANucleo(consumidorBench.native_handle(), 1);
+}
+
+static void pasoAnilloHilos(uint32_t i)
+{
+  Muestra m;
+  m.tempQ4[0] = rampaQ4[i % TAM_RAMPA];
+  m.tempQ4[1] = rampaQ4[(i + TAM_RAMPA / 2) % TAM_RAMPA];
+  m.banderas = MUESTRA_SISTEMA;
+  for (uint8_t k = 0; k < RAFAGA_ANILLO; k++)
+  {
+    m.ms = publicadasBench;
+    uint8_t vueltas = 0;
+    while (!anilloHilosBench.publicar(m))
+      esperarOtroHilo(vueltas);
+    publicadasBench++;
+  }
+}
+
+static void informarAnilloHilos()
+{
+  pararConsumidorBench.store(true, std::memory_order_release);
+  consumidorBench.join();
+  pthread_setaffinity_np(pthread_self(), sizeof(afinidadOriginalBench), &afinidadOriginalBench);
+  printf(",\"nucleos_distintos\":%s,\"fuera_de_orden\":%lu,\"perdidas\":%lu,\"lleno_por_muestra\":%.2f",
+         fijadosBench ? "true" : "false", (unsigned long)fueraDeOrdenBench,
+         (unsigned long)(publicadasBench - consumidasBench.load()),
+         publicadasBench ? (double)anilloHilosBench.perdidos() / publicadasBench : 0.0);
+}
+
+// --- Temas: costo de publicar por evento y por suscriptor ---
+// Un EstadoControl (el evento que mas se publica) por paso a temas de 1, 4 y
+// 8 suscriptores que solo leen el evento: ns por paso es el costo por
+// evento y llamadas_s son llamadas a suscriptores por segundo; la diferencia
+// entre temas da lo que agrega cada suscriptor.
+template <uint8_t K>
+static void suscriptorBench(const EstadoControl &e)
+{
+  sumidero += e.muestra.ms + K;
+}
+
+typedef Tema<EstadoControl>::Suscriptor SuscriptorBench;
+static const SuscriptorBench suscriptoresBench1[] = {suscriptorBench<0>};
+static const SuscriptorBench suscriptoresBench4[] = {suscriptorBench<0>, suscriptorBench<1>, suscriptorBench<2>,
+                                                     suscriptorBench<3>};
+static const SuscriptorBench suscriptoresBench8[] = {suscriptorBench<0>, suscriptorBench<1>, suscriptorBench<2>,
+                                                     suscriptorBench<3>, suscriptorBench<4>, suscriptorBench<5>,
+                                                     suscriptorBench<6>, suscriptorBench<7>};
+static const Tema<EstadoControl> temasBench[] = {Tema<EstadoControl>("bench 1", suscriptoresBench1),
+                                                 Tema<EstadoControl>("bench 4", suscriptoresBench4),
+                                                 Tema<EstadoControl>("bench 8", suscriptoresBench8)};
+// Sin que el compilador vea que tema es, para medir el recorrido de la tabla
+static const Tema<EstadoControl> *volatile temaBench = nullptr;
+
+template <uint8_t T>
+static void prepararTema()
+{
+  temaBench = &temasBench[T];
+}
+
+static void pasoTema(uint32_t i)
+{
+  EstadoControl e;
+  e.muestra = muestraBench(i);
+  e.modo = MODO_AUTO;
+  e.lecturaNueva = true;
+  temaBench->publicar(e);
+}
+
+// --- Perfilador: lo que agrega una SondaEtapa a la etapa que mide ---
+// sonda es una etapa vacia con el reloj real (dos lecturas de reloj, dos
+// de asignaciones() y registrar()); sonda_sin_reloj cambia el reloj por un
+// contador, perfilador_registrar es solo la contabilidad y
+// memoria_asignaciones las dos cargas atomicas del contador de memoria.
+// sonda informa ademas lo que la propia sonda anota para la etapa vacia:
+// el piso que queda sumado en toda etapa medida.
+static const char *const ETAPAS_BENCH[] = {"bench"};
+static uint32_t ciclosFalsosBench = 0;
+static uint32_t relojFalsoBench() { return ciclosFalsosBench += 250; }
+static Perfilador perfiladorBench(ciclosCpu, MHZ_CICLOS_HOST, ETAPAS_BENCH, 1);
+static Perfilador perfiladorSinRelojBench(relojFalsoBench, MHZ_CICLOS_HOST, ETAPAS_BENCH, 1);
+
+static void prepararPerfilador()
+{
+  perfiladorBench.reiniciar();
+  perfiladorSinRelojBench.reiniciar();
+}
+
+static void pasoSonda(uint32_t)
+{
+  SondaEtapa s(perfiladorBench, 0);
+}
+
+static void pasoSondaSinReloj(uint32_t)
+{
+  SondaEtapa s(perfiladorSinRelojBench, 0);
+}
+
+static void pasoRegistrarEtapa(uint32_t i)
+{
+  perfiladorBench.registrar(0, 100 + (i & 0x3FF) * 37, 0);
+}
+
+static void pasoAsignaciones(uint32_t)
+{
+  uint32_t antes = asignaciones();
+  sumidero += asignaciones() - antes;
+}
+
+static void informarPerfilador()
+{
+  const EstadisticasEtapa &e = perfiladorBench.estadisticas(0);
+  printf(",\"etapa_media_ns\":%lu,\"etapa_min_ns\":%lu", (unsigned long)e.mediaNs(),
+         (unsigned long)(e.cantidad ? e.minimoNs : 0));
+}
+
+struct Benchmark
+{
+  const char *nombre;
+  void (*preparar)(); // nullptr: nada que preparar
+  void (*paso)(uint32_t i);
+  uint32_t operaciones; // Por paso, para informar <unidad>_s (0: no se informa)
+  const char *unidad;   // Que cuenta 'operaciones': bytes, lecturas, muestras...
+  void (*informar)();   // Campos JSON propios al final de la linea (nullptr: ninguno)
+  uint16_t divisor;     // Pasos caros: corre iteraciones / divisor (0 o 1: todas)
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"reporte", nullptr, pasoReporte},
+    {"reporte_string", nullptr, pasoReporteString},
+    {"celsius1", nullptr, pasoCelsius},
+    {"filtro", prepararControl, pasoFiltro},
+    {"control", prepararControl, pasoControl},
+    {"render_sin_cambios", prepararRender, pasoRenderSinCambios},
+    {"render_con_cambios", prepararRender, pasoRenderConCambios},
+    {"comando", prepararComando, pasoComando},
+    {"comando_vuelta", prepararComandoVuelta, pasoComandoVuelta, BYTES_POR_VUELTA_BENCH, "bytes",
+     informarComandoVuelta},
+    {"registro", prepararRegistro, pasoRegistro},
+    {"trama", prepararTrama<1>, pasoCodificarTrama<1>, 1, "muestras", informarTrama},
+    {"trama_lote", prepararTrama<MUESTRAS_LOTE_TRAMA>, pasoCodificarTrama<MUESTRAS_LOTE_TRAMA>, MUESTRAS_LOTE_TRAMA,
+     "muestras", informarTrama},
+    {"trama_decodificar", prepararTrama<1>, pasoDecodificarTrama, 1, "muestras", informarTrama},
+    {"trama_lote_decodificar", prepararTrama<MUESTRAS_LOTE_TRAMA>, pasoDecodificarTrama, MUESTRAS_LOTE_TRAMA,
+     "muestras", informarTrama},
+    {"transporte_pty_escribir", prepararTransporte<TransporteHost::PTY>, pasoTransporteEscribir,
+     BYTES_TRANSPORTE_BENCH, "bytes", informarTransporte, 10},
+    {"transporte_pty_leer", prepararTransporte<TransporteHost::PTY>, pasoTransporteLeer, BYTES_TRANSPORTE_BENCH,
+     "bytes", informarTransporte, 10},
+    {"transporte_socket_escribir", prepararTransporte<TransporteHost::PAR_SOCKETS>, pasoTransporteEscribir,
+     BYTES_TRANSPORTE_BENCH, "bytes", informarTransporte, 10},
+    {"transporte_socket_leer", prepararTransporte<TransporteHost::PAR_SOCKETS>, pasoTransporteLeer,
+     BYTES_TRANSPORTE_BENCH, "bytes", informarTransporte, 10},
+    {"anillo", nullptr, pasoAnillo, RAFAGA_ANILLO, "muestras"},
+    {"anillo_dos_hilos", prepararAnilloHilos, pasoAnilloHilos, RAFAGA_ANILLO, "muestras", informarAnilloHilos},
+    {"tema_1", prepararTema<0>, pasoTema, 1, "llamadas"},
+    {"tema_4", prepararTema<1>, pasoTema, 4, "llamadas"},
+    {"tema_8", prepararTema<2>, pasoTema, 8, "llamadas"},
+    {"sonda", prepararPerfilador, pasoSonda, 0, nullptr, informarPerfilador},
+    {"sonda_sin_reloj", prepararPerfilador, pasoSondaSinReloj},
+    {"perfilador_registrar", prepararPerfilador, pasoRegistrarEtapa},
+    {"memoria_asignaciones", nullptr, pasoAsignaciones},
+    {"registro_flash", prepararRegistroFlash, pasoRegistroFlash, 1, "lecturas", informarRegistroFlash},
+    {"bloque_codificar", prepararBloque, pasoCodificarBloque, LECTURAS_BLOQUE_BENCH, "lecturas", informarBloque},
+    {"bloque_decodificar", prepararBloque, pasoDecodificarBloque, LECTURAS_BLOQUE_BENCH, "lecturas",
+     informarBloque},
+    {"consulta_marca_500", prepararConsulta<500>, pasoBuscarMarca, 1, "consultas", informarConsulta, 100},
+    {"consulta_rango_500", prepararConsulta<500>, pasoRango, 1, "consultas", informarConsulta, 100},
+    {"consulta_marca_2k", prepararConsulta<2000>, pasoBuscarMarca, 1, "consultas", informarConsulta, 100},
+    {"consulta_rango_2k", prepararConsulta<2000>, pasoRango, 1, "consultas", informarConsulta, 100},
+    {"consulta_marca_8k", prepararConsulta<8000>, pasoBuscarMarca, 1, "consultas", informarConsulta, 100},
+    {"consulta_rango_8k", prepararConsulta<8000>, pasoRango, 1, "consultas", informarConsulta, 100},
+};
+
+static double ahoraNs()
+{
+  using namespace std::chrono;
+  return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint8_t correrBenchmarks(uint32_t iteraciones, const char *filtro)
+{
+  if (iteraciones == 0)
+    iteraciones = ITERACIONES_BENCH;
+  prepararRampa();
+
+  uint8_t corridos = 0;
+  for (const Benchmark &b : BENCHMARKS)
+  {
+    if (filtro && strncmp(b.nombre, filtro, strlen(filtro)) != 0)
+      continue;
+    uint32_t pasos = b.divisor > 1 ? iteraciones / b.divisor : iteraciones;
+    if (pasos == 0)
+      pasos = 1;
+    if (b.preparar)
+      b.preparar();
+    // Calentamiento: cache, prediccion de saltos y la frecuencia de la CPU
+    for (uint32_t i = 0; i < pasos; i++)
+      b.paso(i);
+
+    double nsPorPaso[REPETICIONES_BENCH];
+    uint32_t asignacionesInicio = asignaciones();
+    for (uint8_t r = 0; r < REPETICIONES_BENCH; r++)
+    {
+      double inicio = ahoraNs();
+      for (uint32_t i = 0; i < pasos; i++)
+        b.paso(i);
+      nsPorPaso[r] = (ahoraNs() - inicio) / pasos;
+    }
+    double asigPorPaso = (double)(asignaciones() - asignacionesInicio) / ((double)pasos * REPETICIONES_BENCH);
+    std::sort(nsPorPaso, nsPorPaso + REPETICIONES_BENCH);
+    double mediana = nsPorPaso[REPETICIONES_BENCH / 2];
+    printf("{\"bench\":\"%s\",\"iteraciones\":%lu,\"repeticiones\":%u,\"ns_min\":%.2f,\"ns_mediana\":%.2f,"
+           "\"ns_max\":%.2f,\"asig_por_paso\":%.2f",
+           b.nombre, (unsigned long)pasos, (unsigned)REPETICIONES_BENCH, nsPorPaso[0], mediana,
+           nsPorPaso[REPETICIONES_BENCH - 1], asigPorPaso);
+    if (b.operaciones && mediana > 0)
+      printf(",\"%s_s\":%.0f", b.unidad, b.operaciones * 1e9 / mediana);
+    if (b.informar)
+      b.informar();
+    printf("}\n");
+    fflush(stdout);
+    corridos++;
+  }
+  return corridos;
+}
+
+#endif
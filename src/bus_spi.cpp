@@ -0,0 +1,167 @@
+#include "bus_spi.h"
+
+#include <string.h>
+
+// --- Histograma ---
+
+void HistogramaLatencia::reiniciar()
+{
+  memset(cubetas, 0, sizeof(cubetas));
+  total = 0;
+  maximo = 0;
+}
+
+void HistogramaLatencia::registrar(uint32_t us)
+{
+  // Cubeta i: valores en [2^(i-1), 2^i). La ultima acumula el desborde.
+  // i es la cantidad de bits significativos (una instruccion en Xtensa).
+  uint8_t i = us ? 32 - __builtin_clz(us) : 0;
+  if (i > CUBETAS - 1)
+    i = CUBETAS - 1;
+  cubetas[i]++;
+  total++;
+  if (us > maximo)
+    maximo = us;
+}
+
+uint32_t HistogramaLatencia::percentil(uint8_t p) const
+{
+  if (total == 0)
+    return 0;
+  uint32_t objetivo = (uint32_t)(((uint64_t)total * p + 99) / 100);
+  if (objetivo == 0)
+    objetivo = 1;
+  uint32_t acumulado = 0;
+  for (uint8_t i = 0; i < CUBETAS; i++)
+  {
+    acumulado += cubetas[i];
+    if (acumulado >= objetivo)
+    {
+      // La ultima cubeta no tiene cota propia: la da el maximo
+      uint32_t cota = (i == 0) ? 0 : (i == CUBETAS - 1) ? maximo : (1UL << i) - 1;
+      return cota < maximo ? cota : maximo;
+    }
+  }
+  return maximo;
+}
+
+// --- Gestor ---
+
+GestorBusSPI::GestorBusSPI(RelojMicros reloj, MuestreoTactil muestreo, uint32_t periodoTactilUs)
+    : reloj_(reloj), muestreo_(muestreo), receptor_(nullptr), linea_(nullptr), periodoTactilUs_(periodoTactilUs),
+      ultimoMuestreo_(0), sinReferencia_(true), primero_(0), cantidad_(0), tocando_(false), trabajoRespuesta_(nullptr),
+      inicioRespuesta_(0)
+{
+  reiniciarEstadisticas();
+}
+
+void GestorBusSPI::reiniciarEstadisticas()
+{
+  memset(&estadisticas_, 0, sizeof(estadisticas_));
+  latencia_.reiniciar();
+}
+
+bool GestorBusSPI::encolarPantalla(PasoPantalla trabajo)
+{
+  // Un trabajo igual que aun no empezo ya va a dibujar el estado mas reciente.
+  Trabajo *t = nullptr;
+  for (uint8_t i = 0; i < cantidad_ && !t; i++)
+  {
+    Trabajo &pendiente = trabajos_[(primero_ + i) % MAX_TRABAJOS];
+    if (pendiente.paso == trabajo && pendiente.indice == 0)
+      t = &pendiente;
+  }
+  if (!t)
+  {
+    if (cantidad_ >= MAX_TRABAJOS)
+      return false;
+    t = &trabajos_[(primero_ + cantidad_) % MAX_TRABAJOS];
+    t->paso = trabajo;
+    t->indice = 0;
+    t->respuesta = false;
+    cantidad_++;
+  }
+
+  if (trabajo == trabajoRespuesta_)
+  {
+    t->respuesta = true;
+    t->inicioRespuesta = inicioRespuesta_;
+    trabajoRespuesta_ = nullptr;
+  }
+  return true;
+}
+
+void GestorBusSPI::muestrear(uint32_t ahora)
+{
+  if (!sinReferencia_)
+  {
+    uint32_t retraso = ahora - ultimoMuestreo_ - periodoTactilUs_;
+    if (retraso > estadisticas_.retrasoTactilMaxUs)
+      estadisticas_.retrasoTactilMaxUs = retraso;
+  }
+  ultimoMuestreo_ = ahora;
+  sinReferencia_ = false;
+
+  // Sin toque en curso y con PENIRQ en reposo no hace falta gastar el bus
+  uint16_t x = 0, y = 0;
+  if (!tocando_ && linea_ && !linea_())
+  {
+    estadisticas_.muestrasEvitadas++;
+  }
+  else
+  {
+    tocando_ = muestreo_(&x, &y);
+    estadisticas_.muestrasTactil++;
+  }
+
+  if (receptor_)
+    receptor_(tocando_, x, y, ahora);
+}
+
+void GestorBusSPI::iniciarRespuesta(PasoPantalla trabajo, uint32_t desdeUs)
+{
+  trabajoRespuesta_ = trabajo;
+  inicioRespuesta_ = desdeUs;
+}
+
+bool GestorBusSPI::ejecutarPaso()
+{
+  Trabajo &t = trabajos_[primero_];
+  uint32_t t0 = reloj_();
+  bool quedan = t.paso(t.indice++);
+  uint32_t duracion = reloj_() - t0;
+
+  estadisticas_.pasosPantalla++;
+  if (duracion > estadisticas_.pasoMaximoUs)
+    estadisticas_.pasoMaximoUs = duracion;
+
+  if (!quedan)
+  {
+    // La respuesta a un toque termina cuando su redibujado salio por el bus
+    if (t.respuesta)
+      latencia_.registrar(reloj_() - t.inicioRespuesta);
+    primero_ = (primero_ + 1) % MAX_TRABAJOS;
+    cantidad_--;
+  }
+  return quedan;
+}
+
+void GestorBusSPI::servir(uint32_t presupuestoUs)
+{
+  uint32_t inicio = reloj_();
+  do
+  {
+    uint32_t ahora = reloj_();
+    if (sinReferencia_ || ahora - ultimoMuestreo_ >= periodoTactilUs_)
+      muestrear(ahora);
+    if (cantidad_ == 0)
+      break;
+    ejecutarPaso();
+  } while (reloj_() - inicio < presupuestoUs);
+}
+
+void GestorBusSPI::vaciarPantalla()
+{
+  while (cantidad_ > 0)
+    ejecutarPaso();
+}
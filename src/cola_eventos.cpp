@@ -0,0 +1,24 @@
+#include "cola_eventos.h"
+
+ColaEventos::ColaEventos(RelojMicros reloj) : reloj_(reloj)
+{
+  duracionCallback_.reiniciar();
+  latencia_.reiniciar();
+}
+
+bool ColaEventos::publicar(uint8_t tipo, uint32_t dato)
+{
+  EventoDiferido ev;
+  ev.tipo = tipo;
+  ev.dato = dato;
+  ev.encoladoUs = reloj_();
+  return anillo_.publicar(ev);
+}
+
+bool ColaEventos::siguiente(EventoDiferido &evento)
+{
+  if (!anillo_.siguiente(evento))
+    return false;
+  latencia_.registrar(reloj_() - evento.encoladoUs);
+  return true;
+}
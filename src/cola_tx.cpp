@@ -0,0 +1,101 @@
+#include "cola_tx.h"
+
+#include <string.h>
+
+void ColaTransmision::vaciar()
+{
+  primero_ = 0;
+  cantidad_ = 0;
+  enviado_ = 0;
+}
+
+void ColaTransmision::reiniciarEstadisticas() { memset(&estadisticas_, 0, sizeof(estadisticas_)); }
+
+void ColaTransmision::quitar(uint8_t i)
+{
+  // Corre hacia adelante las ranuras que estaban despues de i
+  for (uint8_t j = i; j + 1 < cantidad_; j++)
+    ranura(j) = ranura(j + 1);
+  cantidad_--;
+}
+
+bool ColaTransmision::encolar(ClaseMensaje clase, const uint8_t *datos, size_t len)
+{
+  if (len == 0 || len > TAM_RANURA)
+  {
+    estadisticas_.rechazados++;
+    return false;
+  }
+
+  // La primera ranura puede estar a medio enviar: esa no se toca
+  uint8_t desde = enviado_ > 0 ? 1 : 0;
+  Ranura *destino = nullptr;
+
+  if (esReemplazable(clase))
+  {
+    for (uint8_t i = desde; i < cantidad_; i++)
+    {
+      if (ranura(i).clase == clase)
+      {
+        destino = &ranura(i);
+        estadisticas_.coalescidos++;
+        break;
+      }
+    }
+  }
+
+  if (!destino && cantidad_ == RANURAS)
+  {
+    for (uint8_t i = desde; i < cantidad_; i++)
+    {
+      if (esReemplazable(ranura(i).clase))
+      {
+        quitar(i);
+        estadisticas_.descartados++;
+        break;
+      }
+    }
+    if (cantidad_ == RANURAS)
+    {
+      estadisticas_.rechazados++;
+      return false;
+    }
+  }
+
+  if (!destino)
+    destino = &ranura(cantidad_++);
+  destino->clase = clase;
+  destino->len = (uint8_t)len;
+  memcpy(destino->datos, datos, len);
+  estadisticas_.encolados++;
+  return true;
+}
+
+bool ColaTransmision::encolar(ClaseMensaje clase, const char *texto)
+{
+  return encolar(clase, (const uint8_t *)texto, strlen(texto));
+}
+
+size_t ColaTransmision::bombear(EscritorEnlace escritor, size_t maxBytes)
+{
+  size_t total = 0;
+  while (cantidad_ > 0 && total < maxBytes)
+  {
+    Ranura &r = ranura(0);
+    size_t pendiente = r.len - enviado_;
+    if (pendiente > maxBytes - total)
+      pendiente = maxBytes - total;
+
+    size_t aceptados = escritor(r.datos + enviado_, pendiente);
+    total += aceptados;
+    enviado_ += aceptados;
+    if (enviado_ < r.len)
+      break; // El enlace no acepto todo: se reintenta en la proxima vuelta
+
+    primero_ = (primero_ + 1) % RANURAS;
+    cantidad_--;
+    enviado_ = 0;
+  }
+  estadisticas_.bytesEnviados += total;
+  return total;
+}
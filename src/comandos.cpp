@@ -0,0 +1,142 @@
+#include "comandos.h"
+
+static const uint8_t MAX_ARGUMENTOS = 6;
+
+bool LectorLineas::consumir(char c)
+{
+  if (c == '\r')
+    return false;
+
+  if (c == '\n')
+  {
+    bool completa = !descartando_;
+    buf_[len_] = '\0';
+    len_ = 0;
+    descartando_ = false;
+    return completa;
+  }
+
+  if (descartando_)
+    return false;
+
+  if (len_ >= MAX_LINEA)
+  {
+    descartando_ = true;
+    desbordes_++;
+    len_ = 0;
+    return false;
+  }
+  buf_[len_++] = c;
+  return false;
+}
+
+static char aMayuscula(char c)
+{
+  return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+bool igualSinMayusculas(const char *a, const char *b)
+{
+  while (*a && *b)
+  {
+    if (aMayuscula(*a++) != aMayuscula(*b++))
+      return false;
+  }
+  return *a == *b;
+}
+
+ResultadoComando despacharComando(char *linea, const Comando *tabla, size_t cantidad)
+{
+  char *palabras[MAX_ARGUMENTOS + 1];
+  uint8_t n = 0;
+  bool sobran = false;
+  char *p = linea;
+
+  while (*p)
+  {
+    while (*p == ' ' || *p == '\t')
+      *p++ = '\0';
+    if (!*p)
+      break;
+    if (n > MAX_ARGUMENTOS)
+    {
+      sobran = true;
+      break;
+    }
+    palabras[n++] = p;
+    while (*p && *p != ' ' && *p != '\t')
+      p++;
+  }
+  if (n == 0)
+    return CMD_VACIO;
+
+  for (size_t i = 0; i < cantidad; i++)
+  {
+    if (!igualSinMayusculas(palabras[0], tabla[i].nombre))
+      continue;
+    uint8_t argc = n - 1;
+    if (argc < tabla[i].minArgs || argc > tabla[i].maxArgs || sobran)
+      return CMD_ARGUMENTOS;
+    tabla[i].ejecutar(argc, palabras + 1);
+    return CMD_OK;
+  }
+  return CMD_DESCONOCIDO;
+}
+
+bool parsearEntero(const char *texto, uint32_t &valor)
+{
+  if (!*texto)
+    return false;
+  uint32_t v = 0;
+  while (*texto >= '0' && *texto <= '9')
+  {
+    uint8_t digito = *texto++ - '0';
+    if (v > (UINT32_MAX - digito) / 10)
+      return false; // Desborde
+    v = v * 10 + digito;
+  }
+  if (*texto)
+    return false;
+  valor = v;
+  return true;
+}
+
+bool parsearDecimas(const char *texto, int16_t &decimas)
+{
+  bool negativo = false;
+  if (*texto == '-' || *texto == '+')
+    negativo = (*texto++ == '-');
+  if (!*texto)
+    return false;
+
+  int32_t entero = 0;
+  bool hayDigitos = false;
+  while (*texto >= '0' && *texto <= '9')
+  {
+    entero = entero * 10 + (*texto++ - '0');
+    hayDigitos = true;
+    if (entero > 3200)
+      return false;
+  }
+
+  int32_t valor = entero * 10;
+  if (*texto == '.' || *texto == ',')
+  {
+    texto++;
+    if (*texto >= '0' && *texto <= '9')
+    {
+      valor += *texto++ - '0';
+      hayDigitos = true;
+      // Redondeo por la segunda decimal; el resto se ignora
+      if (*texto >= '5' && *texto <= '9')
+        valor++;
+      while (*texto >= '0' && *texto <= '9')
+        texto++;
+    }
+  }
+  if (!hayDigitos || *texto)
+    return false;
+
+  decimas = (int16_t)(negativo ? -valor : valor);
+  return true;
+}
@@ -0,0 +1,224 @@
+#include "compresion.h"
+
+// --- Codificador ---
+
+void CodificadorBloque::iniciar(uint8_t *buf, size_t cap)
+{
+  buf_ = buf;
+  cap_ = cap;
+  bits_ = 0;
+  cantidad_ = 0;
+  deltaMarca_ = 0;
+}
+
+void CodificadorBloque::poner(uint32_t valor, uint8_t n)
+{
+  while (n--)
+  {
+    if (bits_ % 8 == 0)
+      buf_[bits_ / 8] = 0;
+    if ((valor >> n) & 1)
+      buf_[bits_ / 8] |= 0x80 >> (bits_ % 8);
+    bits_++;
+  }
+}
+
+void CodificadorBloque::ponerTemperatura(int16_t anterior, int16_t actual)
+{
+  int32_t d = (int32_t)actual - anterior;
+  if (d == 0)
+    poner(0, 1);
+  else if (d >= -2 && d <= 2)
+  {
+    // Ruido de +-1/+-2 LSB del DS18B20: sin el cero, alcanzan 2 bits
+    poner(0x2, 2);
+    poner(d < 0 ? d + 2 : d + 1, 2);
+  }
+  else if (d >= -16 && d < 16)
+  {
+    poner(0x6, 3);
+    poner((uint32_t)d & 0x1F, 5);
+  }
+  else if (d >= -2048 && d < 2048)
+  {
+    poner(0xE, 4);
+    poner((uint32_t)d & 0xFFF, 12);
+  }
+  else
+  {
+    // Saltos grandes (y TEMP_Q4_ERROR): el valor completo
+    poner(0xF, 4);
+    poner((uint16_t)actual, 16);
+  }
+}
+
+bool CodificadorBloque::agregar(const Lectura &l)
+{
+  size_t necesarios = cantidad_ == 0 ? BITS_PRIMERA : MAX_BITS_LECTURA;
+  if (bits_ + necesarios > cap_ * 8)
+    return false;
+
+  if (cantidad_ == 0)
+  {
+    poner(l.t, 32);
+    poner((uint16_t)l.tempQ4[0], 16);
+    poner((uint16_t)l.tempQ4[1], 16);
+    poner(l.banderas, 8);
+    deltaMarca_ = 0;
+  }
+  else
+  {
+    // Aritmetica modulo 2^32: el decodificador deshace exactamente lo mismo
+    int32_t delta = (int32_t)(l.t - anterior_.t);
+    int32_t dd = (int32_t)((uint32_t)delta - (uint32_t)deltaMarca_);
+    deltaMarca_ = delta;
+    if (dd == 0)
+      poner(0, 1);
+    else if (dd >= -64 && dd < 64)
+    {
+      poner(0x2, 2);
+      poner((uint32_t)dd & 0x7F, 7);
+    }
+    else if (dd >= -2048 && dd < 2048)
+    {
+      poner(0x6, 3);
+      poner((uint32_t)dd & 0xFFF, 12);
+    }
+    else
+    {
+      poner(0x7, 3);
+      poner((uint32_t)dd, 32);
+    }
+
+    ponerTemperatura(anterior_.tempQ4[0], l.tempQ4[0]);
+    ponerTemperatura(anterior_.tempQ4[1], l.tempQ4[1]);
+
+    if (l.banderas == anterior_.banderas)
+      poner(0, 1);
+    else
+    {
+      poner(1, 1);
+      poner(l.banderas, 8);
+    }
+  }
+
+  anterior_ = l;
+  cantidad_++;
+  return true;
+}
+
+// --- Decodificador ---
+
+DecodificadorBloque::DecodificadorBloque(const uint8_t *buf, size_t largo, uint16_t cantidad)
+    : buf_(buf), totalBits_(largo * 8), pos_(0), restantes_(cantidad), primera_(true), deltaMarca_(0)
+{
+}
+
+bool DecodificadorBloque::tomar(uint8_t n, uint32_t &valor)
+{
+  if (pos_ + n > totalBits_)
+    return false;
+  valor = 0;
+  while (n--)
+  {
+    valor = (valor << 1) | ((buf_[pos_ / 8] >> (7 - pos_ % 8)) & 1);
+    pos_++;
+  }
+  return true;
+}
+
+bool DecodificadorBloque::tomarConSigno(uint8_t n, int32_t &valor)
+{
+  uint32_t v;
+  if (!tomar(n, v))
+    return false;
+  if (n < 32 && (v & (1UL << (n - 1))))
+    v |= ~((1UL << n) - 1);
+  valor = (int32_t)v;
+  return true;
+}
+
+// Cuenta unos hasta el primer cero (o hasta 'maximo' unos, sin cero final)
+bool DecodificadorBloque::tomarPrefijo(uint8_t maximo, uint8_t &unos)
+{
+  unos = 0;
+  uint32_t bit;
+  while (unos < maximo)
+  {
+    if (!tomar(1, bit))
+      return false;
+    if (!bit)
+      break;
+    unos++;
+  }
+  return true;
+}
+
+bool DecodificadorBloque::tomarTemperatura(int16_t anterior, int16_t &actual)
+{
+  static const uint8_t BITS_DELTA[] = {0, 2, 5, 12};
+  uint8_t unos;
+  if (!tomarPrefijo(4, unos))
+    return false;
+  if (unos == 4)
+  {
+    uint32_t v;
+    if (!tomar(16, v))
+      return false;
+    actual = (int16_t)v;
+    return true;
+  }
+  int32_t d = 0;
+  if (unos == 1)
+  {
+    uint32_t v;
+    if (!tomar(2, v))
+      return false;
+    d = v < 2 ? (int32_t)v - 2 : (int32_t)v - 1; // 00 -2, 01 -1, 10 +1, 11 +2
+  }
+  else if (unos > 1 && !tomarConSigno(BITS_DELTA[unos], d))
+    return false;
+  actual = (int16_t)(anterior + d);
+  return true;
+}
+
+bool DecodificadorBloque::siguiente(Lectura &l)
+{
+  if (restantes_ == 0)
+    return false;
+
+  bool ok;
+  if (primera_)
+  {
+    uint32_t t, t1, t2, b;
+    ok = tomar(32, t) && tomar(16, t1) && tomar(16, t2) && tomar(8, b);
+    l.t = t;
+    l.tempQ4[0] = (int16_t)t1;
+    l.tempQ4[1] = (int16_t)t2;
+    l.banderas = (uint8_t)b;
+    primera_ = false;
+  }
+  else
+  {
+    static const uint8_t BITS_MARCA[] = {0, 7, 12, 32};
+    uint8_t unos;
+    int32_t dd = 0;
+    ok = tomarPrefijo(3, unos) && (unos == 0 || tomarConSigno(BITS_MARCA[unos], dd));
+    deltaMarca_ = (int32_t)((uint32_t)deltaMarca_ + (uint32_t)dd);
+    l.t = anterior_.t + (uint32_t)deltaMarca_;
+
+    uint32_t cambio = 0, b = anterior_.banderas;
+    ok = ok && tomarTemperatura(anterior_.tempQ4[0], l.tempQ4[0]) &&
+         tomarTemperatura(anterior_.tempQ4[1], l.tempQ4[1]) && tomar(1, cambio) && (!cambio || tomar(8, b));
+    l.banderas = (uint8_t)b;
+  }
+
+  if (!ok)
+  {
+    restantes_ = 0;
+    return false;
+  }
+  anterior_ = l;
+  restantes_--;
+  return true;
+}
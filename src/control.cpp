@@ -0,0 +1,39 @@
+#include "control.h"
+
+const char *nombreModo(ModoControl modo)
+{
+  switch (modo)
+  {
+  case MODO_DEMO:
+    return "DEMO";
+  case MODO_MANUAL:
+    return "MANUAL";
+  case MODO_AUTO:
+    return "AUTO";
+  }
+  return "?";
+}
+
+int16_t FiltroTemperatura::paso(int16_t medida)
+{
+  if (!iniciado)
+  {
+    acumulado = (int32_t)medida * 4;
+    iniciado = true;
+  }
+  else
+  {
+    // acumulado += (medida*4 - acumulado) / 4
+    acumulado += medida - acumulado / 4;
+  }
+  return valor();
+}
+
+bool pasoTermostato(bool encendido, int16_t medida, int16_t consigna, int16_t histeresis)
+{
+  if (medida <= consigna - histeresis)
+    return true;
+  if (medida >= consigna + histeresis)
+    return false;
+  return encendido;
+}
@@ -0,0 +1,32 @@
+#include "crc.h"
+
+// Tabla de 16 entradas (nibble a nibble): 64 bytes de flash en lugar de 1 KB
+static const uint32_t TABLA_CRC32[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+uint32_t crc32(const void *datos, size_t len, uint32_t semilla)
+{
+  const uint8_t *p = (const uint8_t *)datos;
+  uint32_t crc = ~semilla;
+  while (len--)
+  {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ TABLA_CRC32[crc & 0x0F];
+    crc = (crc >> 4) ^ TABLA_CRC32[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+uint16_t crc16(const void *datos, size_t len, uint16_t semilla)
+{
+  const uint8_t *p = (const uint8_t *)datos;
+  uint16_t crc = semilla;
+  while (len--)
+  {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
@@ -0,0 +1,86 @@
+#ifndef ARDUINO
+
+#include "flash_emulada.h"
+
+#include <stdio.h>
+#include <string.h>
+
+FlashEmulada::FlashEmulada(uint32_t tamano, const TiemposFlash &tiempos)
+    : tiempos_(tiempos), datos_(tamano, 0xFF), borradosPorSector_(tamano / TAM_SECTOR, 0), tiempoUs_(0),
+      bytesProgramados_(0), corteProgramado_(false), bytesHastaCorte_(0), cortada_(false)
+{
+}
+
+bool FlashEmulada::leer(uint32_t dir, void *out, size_t len)
+{
+  if (cortada_ || dir + len > datos_.size())
+    return false;
+  memcpy(out, &datos_[dir], len);
+  return true;
+}
+
+bool FlashEmulada::escribir(uint32_t dir, const void *datos, size_t len)
+{
+  if (cortada_ || dir + len > datos_.size())
+    return false;
+
+  const uint8_t *p = (const uint8_t *)datos;
+  for (size_t i = 0; i < len; i++)
+  {
+    if (corteProgramado_ && bytesHastaCorte_-- == 0)
+    {
+      cortada_ = true;
+      return false;
+    }
+    datos_[dir + i] &= p[i]; // NOR: solo 1 -> 0
+    bytesProgramados_++;
+  }
+  // Una programacion por pagina tocada
+  uint32_t paginas = (dir + len - 1) / TAM_PAGINA - dir / TAM_PAGINA + 1;
+  tiempoUs_ += len ? paginas * tiempos_.usPorPagina : 0;
+  return true;
+}
+
+bool FlashEmulada::borrarSector(uint32_t dir)
+{
+  if (cortada_ || dir % TAM_SECTOR || dir + TAM_SECTOR > datos_.size())
+    return false;
+  memset(&datos_[dir], 0xFF, TAM_SECTOR);
+  borradosPorSector_[dir / TAM_SECTOR]++;
+  tiempoUs_ += tiempos_.usPorBorrado;
+  return true;
+}
+
+void FlashEmulada::programarCorte(uint32_t bytes)
+{
+  corteProgramado_ = true;
+  bytesHastaCorte_ = bytes;
+}
+
+void FlashEmulada::restaurarEnergia()
+{
+  corteProgramado_ = false;
+  cortada_ = false;
+}
+
+bool FlashEmulada::guardar(const char *ruta) const
+{
+  FILE *f = fopen(ruta, "wb");
+  if (!f)
+    return false;
+  bool ok = fwrite(datos_.data(), 1, datos_.size(), f) == datos_.size();
+  fclose(f);
+  return ok;
+}
+
+bool FlashEmulada::cargar(const char *ruta)
+{
+  FILE *f = fopen(ruta, "rb");
+  if (!f)
+    return false;
+  bool ok = fread(datos_.data(), 1, datos_.size(), f) == datos_.size();
+  fclose(f);
+  return ok;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifdef ARDUINO
+
+#include "flash_particion.h"
+
+bool FlashParticion::begin(const char *etiqueta)
+{
+  particion_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, etiqueta);
+  return particion_ != nullptr;
+}
+
+bool FlashParticion::leer(uint32_t dir, void *out, size_t len)
+{
+  return particion_ && esp_partition_read(particion_, dir, out, len) == ESP_OK;
+}
+
+bool FlashParticion::escribir(uint32_t dir, const void *datos, size_t len)
+{
+  return particion_ && esp_partition_write(particion_, dir, datos, len) == ESP_OK;
+}
+
+bool FlashParticion::borrarSector(uint32_t dir)
+{
+  return particion_ && esp_partition_erase_range(particion_, dir, TAM_SECTOR) == ESP_OK;
+}
+
+#endif
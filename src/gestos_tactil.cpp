@@ -0,0 +1,109 @@
+#include "gestos_tactil.h"
+
+MaquinaGestos::MaquinaGestos(const ConfigGestos &config) : config_(config)
+{
+  reiniciar();
+}
+
+void MaquinaGestos::reiniciar()
+{
+  estado_ = REPOSO;
+  x_ = y_ = 0;
+  tCambio_ = tBajada_ = tProximaRepeticion_ = 0;
+  largoEmitido_ = false;
+  primero_ = cantidad_ = 0;
+  descartados_ = 0;
+}
+
+void MaquinaGestos::emitir(TipoEventoTactil tipo, uint32_t us)
+{
+  if (cantidad_ >= CAPACIDAD_COLA)
+  {
+    descartados_++;
+    return;
+  }
+  EventoTactil &ev = cola_[(primero_ + cantidad_) % CAPACIDAD_COLA];
+  ev.tipo = tipo;
+  ev.x = x_;
+  ev.y = y_;
+  ev.us = us;
+  cantidad_++;
+}
+
+bool MaquinaGestos::siguiente(EventoTactil &evento)
+{
+  if (cantidad_ == 0)
+    return false;
+  evento = cola_[primero_];
+  primero_ = (primero_ + 1) % CAPACIDAD_COLA;
+  cantidad_--;
+  return true;
+}
+
+void MaquinaGestos::muestra(bool presionado, uint16_t x, uint16_t y, uint32_t us)
+{
+  const uint32_t rebote = (uint32_t)config_.msRebote * 1000;
+
+  switch (estado_)
+  {
+  case REPOSO:
+    if (presionado)
+    {
+      estado_ = CONFIRMANDO_BAJADA;
+      tCambio_ = us;
+      x_ = x;
+      y_ = y;
+    }
+    break;
+
+  case CONFIRMANDO_BAJADA:
+    if (!presionado)
+    {
+      estado_ = REPOSO; // Pico espurio
+    }
+    else if (us - tCambio_ >= rebote)
+    {
+      estado_ = PRESIONADO;
+      tBajada_ = tCambio_;
+      largoEmitido_ = false;
+      emitir(TOQUE_BAJADA, us);
+    }
+    break;
+
+  case PRESIONADO:
+    if (!presionado)
+    {
+      estado_ = CONFIRMANDO_SUBIDA;
+      tCambio_ = us;
+      break;
+    }
+    x_ = x;
+    y_ = y;
+    if (!largoEmitido_ && us - tBajada_ >= (uint32_t)config_.msLargo * 1000)
+    {
+      largoEmitido_ = true;
+      tProximaRepeticion_ = us + (uint32_t)config_.msRepeticion * 1000;
+      emitir(TOQUE_LARGO, us);
+    }
+    else if (largoEmitido_ && (int32_t)(us - tProximaRepeticion_) >= 0)
+    {
+      tProximaRepeticion_ += (uint32_t)config_.msRepeticion * 1000;
+      emitir(TOQUE_REPETICION, us);
+    }
+    break;
+
+  case CONFIRMANDO_SUBIDA:
+    if (presionado)
+    {
+      estado_ = PRESIONADO; // Rebote durante la liberacion
+    }
+    else if (us - tCambio_ >= rebote)
+    {
+      estado_ = REPOSO;
+      emitir(TOQUE_SUBIDA, us);
+      if (!largoEmitido_)
+        emitir(TOQUE_CLICK, us);
+    }
+    break;
+  }
+}
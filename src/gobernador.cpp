@@ -0,0 +1,86 @@
+#include "gobernador.h"
+
+// Los que admite setCpuFrequencyMhz() con el cristal de 40 MHz sin bajar el
+// APB (el BT y el SPI siguen funcionando)
+const uint32_t Gobernador::MHZ[ESCALONES] = {80, 160, 240};
+
+Gobernador::Gobernador(FijarFrecuencia fijar, RelojMicros reloj)
+    : fijar_(fijar), reloj_(reloj), escalon_(ESCALONES - 1), piso_(0), ventanasBajas_(0), desdeUs_(0),
+      cambios_(0), vencidos_(0), ultimaCarga_(0)
+{
+  for (uint8_t i = 0; i < ESCALONES; i++)
+    tiempoUs_[i] = 0;
+}
+
+void Gobernador::iniciar()
+{
+  desdeUs_ = reloj_();
+  escalon_ = ESCALONES - 1;
+  fijar_(MHZ[escalon_]);
+}
+
+void Gobernador::evaluar(uint32_t cargaMilesimas, uint32_t vencidos)
+{
+  acumular();
+  ultimaCarga_ = cargaMilesimas;
+  vencidos_ += vencidos;
+
+  // La misma cantidad de trabajo en otro escalon ocupa carga * f / f'
+  uint8_t necesario = ESCALONES - 1;
+  if (vencidos == 0)
+  {
+    necesario = piso_;
+    while (necesario < ESCALONES - 1 &&
+           (uint64_t)cargaMilesimas * MHZ[escalon_] > (uint64_t)UMBRAL_SUBIDA * MHZ[necesario])
+      necesario++;
+  }
+  if (necesario > escalon_)
+  {
+    ventanasBajas_ = 0;
+    cambiar(necesario);
+    return;
+  }
+
+  uint8_t abajo = escalon_ > piso_ ? escalon_ - 1 : escalon_;
+  if (abajo == escalon_ || (uint64_t)cargaMilesimas * MHZ[escalon_] > (uint64_t)UMBRAL_BAJADA * MHZ[abajo])
+  {
+    ventanasBajas_ = 0;
+    return;
+  }
+  if (++ventanasBajas_ < VENTANAS_PARA_BAJAR)
+    return;
+  ventanasBajas_ = 0;
+  cambiar(abajo);
+}
+
+void Gobernador::impulsar()
+{
+  ventanasBajas_ = 0;
+  cambiar(ESCALONES - 1);
+}
+
+void Gobernador::fijarPiso(uint32_t mhz)
+{
+  piso_ = 0;
+  while (piso_ < ESCALONES - 1 && MHZ[piso_] < mhz)
+    piso_++;
+  if (escalon_ < piso_)
+    cambiar(piso_);
+}
+
+void Gobernador::cambiar(uint8_t escalon)
+{
+  if (escalon == escalon_)
+    return;
+  acumular();
+  escalon_ = escalon;
+  cambios_++;
+  fijar_(MHZ[escalon_]);
+}
+
+void Gobernador::acumular()
+{
+  uint32_t ahora = reloj_();
+  tiempoUs_[escalon_] += ahora - desdeUs_;
+  desdeUs_ = ahora;
+}
@@ -0,0 +1,15 @@
+#include "hal.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+void Consola::printf(const char *formato, ...)
+{
+  char texto[256];
+  va_list args;
+  va_start(args, formato);
+  int n = vsnprintf(texto, sizeof(texto), formato, args);
+  va_end(args);
+  if (n > 0)
+    escribir(texto);
+}
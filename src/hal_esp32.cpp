@@ -0,0 +1,241 @@
+#ifdef ARDUINO
+
+#include "hal.h"
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <TFT_eSPI.h>
+#include "FS.h"
+#include "SPIFFS.h"
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include "esp32-hal-cpu.h"
+#include "esp_heap_caps.h"
+#include "flash_particion.h"
+#include "transporte_spp.h"
+#include "telemetria.h" // celsiusAQ4, TEMP_Q4_ERROR
+
+namespace
+{
+
+class RelojEsp32 : public Reloj
+{
+public:
+  uint32_t micros() override { return ::micros(); }
+  uint32_t millis() override { return ::millis(); }
+  void esperarMs(uint32_t ms) override { delay(ms); }
+};
+
+class GpioEsp32 : public Gpio
+{
+public:
+  void salida(uint8_t pin) override { pinMode(pin, OUTPUT); }
+  void entrada(uint8_t pin) override { pinMode(pin, INPUT); }
+  void escribir(uint8_t pin, bool alto) override { digitalWrite(pin, alto ? HIGH : LOW); }
+  bool leer(uint8_t pin) override { return digitalRead(pin) == HIGH; }
+};
+
+class PantallaEsp32 : public Pantalla
+{
+public:
+  explicit PantallaEsp32(TFT_eSPI &tft) : tft_(tft) {}
+
+  void iniciar() override
+  {
+    tft_.init();
+    tft_.setRotation(0);
+    tft_.fillScreen(TFT_BLACK);
+  }
+  void encender(bool encendida) override
+  {
+    if (encendida)
+    {
+      tft_.writecommand(0x11); // Wake up display
+      delay(120);
+    }
+    else
+      tft_.writecommand(0x10); // Sleep display
+  }
+  void rellenar(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override
+  {
+    tft_.fillRect(x, y, w, h, color);
+  }
+  void rellenarRedondeado(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) override
+  {
+    tft_.fillRoundRect(x, y, w, h, r, color);
+  }
+  void bordeRedondeado(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) override
+  {
+    tft_.drawRoundRect(x, y, w, h, r, color);
+  }
+  void lineaHorizontal(int16_t x, int16_t y, int16_t w, uint16_t color) override
+  {
+    tft_.drawFastHLine(x, y, w, color);
+  }
+  void textoCentrado(const char *texto, int16_t x, int16_t y, uint8_t fuente, uint16_t color,
+                     uint32_t fondo) override
+  {
+    if (fondo == SIN_FONDO)
+      tft_.setTextColor(color);
+    else
+      tft_.setTextColor(color, (uint16_t)fondo);
+    tft_.setTextDatum(MC_DATUM);
+    tft_.drawString(texto, x, y, fuente);
+  }
+
+private:
+  TFT_eSPI &tft_;
+};
+
+// El XPT2046 comparte el bus con la pantalla y lo maneja TFT_eSPI
+class TactilEsp32 : public Tactil
+{
+public:
+  explicit TactilEsp32(TFT_eSPI &tft) : tft_(tft) {}
+
+  bool leer(uint16_t &x, uint16_t &y) override { return tft_.getTouch(&x, &y, 250); }
+  bool presionado() override { return digitalRead(PIN_T_IRQ) == LOW; }
+  void calibracion(const uint16_t datos[5]) override
+  {
+    uint16_t copia[5];
+    memcpy(copia, datos, sizeof(copia));
+    tft_.setTouch(copia);
+  }
+  void calibrar(uint16_t datos[5]) override
+  {
+    tft_.fillScreen(TFT_BLACK);
+    tft_.setCursor(20, 0);
+    tft_.setTextFont(2);
+    tft_.setTextSize(1);
+    tft_.setTextColor(TFT_WHITE, TFT_BLACK);
+
+    tft_.println("Toca las esquinas indicadas para calibrar");
+
+    tft_.setTextFont(1);
+    tft_.println("(Mantente presionado hasta que desaparezca)");
+
+    // Ejecuta la rutina de la libreria
+    tft_.calibrateTouch(datos, TFT_MAGENTA, TFT_BLACK, 15);
+    tft_.fillScreen(TFT_BLACK);
+  }
+
+private:
+  TFT_eSPI &tft_;
+};
+
+class SensoresDallas : public SensoresTemperatura
+{
+public:
+  explicit SensoresDallas(DallasTemperature &dallas) : dallas_(dallas) {}
+
+  void iniciar() override
+  {
+    dallas_.begin();
+    dallas_.setWaitForConversion(false); // La lectura es un trabajo aparte
+  }
+  void pedirConversion() override { dallas_.requestTemperatures(); }
+  uint32_t msConversion() override { return dallas_.millisToWaitForConversion(dallas_.getResolution()); }
+  int16_t leerQ4(uint8_t indice) override
+  {
+    float t = dallas_.getTempCByIndex(indice);
+    return (t != DEVICE_DISCONNECTED_C) ? celsiusAQ4(t) : TEMP_Q4_ERROR;
+  }
+
+private:
+  DallasTemperature &dallas_;
+};
+
+class ConsolaSerie : public Consola
+{
+public:
+  void escribir(const char *texto) override { Serial.print(texto); }
+  bool hayEntrada() override { return Serial.available(); }
+};
+
+class ArchivosSpiffs : public SistemaArchivos
+{
+public:
+  bool existe(const char *ruta) override { return SPIFFS.exists(ruta); }
+  bool borrar(const char *ruta) override { return SPIFFS.remove(ruta); }
+  size_t leer(const char *ruta, size_t desde, void *datos, size_t len) override
+  {
+    fs::File f = SPIFFS.open(ruta, "r");
+    if (!f)
+      return 0;
+    size_t n = f.seek(desde) ? f.read((uint8_t *)datos, len) : 0;
+    f.close();
+    return n;
+  }
+  size_t escribir(const char *ruta, const void *datos, size_t len) override
+  {
+    fs::File f = SPIFFS.open(ruta, "w");
+    if (!f)
+      return 0;
+    size_t n = f.write((const uint8_t *)datos, len);
+    f.close();
+    return n;
+  }
+};
+
+class PlataformaEsp32 : public Plataforma
+{
+public:
+  void frecuenciaCpu(uint32_t mhz) override { setCpuFrequencyMhz(mhz); }
+
+  // El heap de uso general (el que usan malloc y new)
+  EstadoMemoria memoria() override
+  {
+    EstadoMemoria m;
+    m.libre = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    m.minimoLibre = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    m.mayorBloque = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    return m;
+  }
+};
+
+TFT_eSPI tft = TFT_eSPI();
+OneWire oneWire(ONE_WIRE_BUS);
+DallasTemperature dallas(&oneWire);
+
+RelojEsp32 relojEsp32;
+GpioEsp32 gpioEsp32;
+PantallaEsp32 pantallaEsp32(tft);
+TactilEsp32 tactilEsp32(tft);
+SensoresDallas sensoresDallas(dallas);
+ConsolaSerie consolaSerie;
+ArchivosSpiffs archivosSpiffs;
+PlataformaEsp32 plataformaEsp32;
+FlashParticion flashParticion;
+TransporteSPP transporteSPP;
+
+} // namespace
+
+Reloj &reloj = relojEsp32;
+Gpio &gpio = gpioEsp32;
+Pantalla &pantalla = pantallaEsp32;
+Tactil &tactil = tactilEsp32;
+SensoresTemperatura &sensores = sensoresDallas;
+Consola &consola = consolaSerie;
+SistemaArchivos &archivos = archivosSpiffs;
+Plataforma &plataforma = plataformaEsp32;
+Transporte &enlaceBT = transporteSPP;
+MemoriaFlash &flashDatos = flashParticion;
+
+bool iniciarHal()
+{
+  Serial.begin(115200);
+  bool ok = true;
+  if (!SPIFFS.begin(true))
+  {
+    Serial.println("Error SPIFFS");
+    ok = false;
+  }
+  if (!flashParticion.begin("datalog"))
+  {
+    Serial.println("Error particion datalog");
+    ok = false;
+  }
+  return ok;
+}
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef ARDUINO
+
+#include "hal_host.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include "crc.h"
+
+static int64_t ahoraUs()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+RelojHost::RelojHost() : origenUs_(ahoraUs()), simulado_(false), virtualUs_(0) {}
+
+void RelojHost::simular(uint64_t inicioUs)
+{
+  simulado_ = true;
+  virtualUs_ = inicioUs;
+}
+
+uint64_t RelojHost::us64() { return simulado_ ? virtualUs_ : (uint64_t)(ahoraUs() - origenUs_); }
+uint32_t RelojHost::micros() { return (uint32_t)us64(); }
+uint32_t RelojHost::millis() { return (uint32_t)(us64() / 1000); }
+
+void RelojHost::esperarMs(uint32_t ms)
+{
+  if (simulado_)
+    virtualUs_ += (uint64_t)ms * 1000;
+  else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+GpioHost::GpioHost()
+{
+  memset(nivel_, 0, sizeof(nivel_));
+  memset(salida_, 0, sizeof(salida_));
+  memset(cambios_, 0, sizeof(cambios_));
+}
+
+void GpioHost::salida(uint8_t pin)
+{
+  if (pin < PINES)
+    salida_[pin] = true;
+}
+
+void GpioHost::entrada(uint8_t pin)
+{
+  if (pin < PINES)
+    salida_[pin] = false;
+}
+
+void GpioHost::escribir(uint8_t pin, bool alto)
+{
+  if (pin >= PINES || !salida_[pin])
+    return;
+  if (nivel_[pin] != alto)
+    cambios_[pin]++;
+  nivel_[pin] = alto;
+}
+
+bool GpioHost::leer(uint8_t pin) { return pin < PINES && nivel_[pin]; }
+
+void GpioHost::fijar(uint8_t pin, bool alto)
+{
+  if (pin < PINES && !salida_[pin])
+    nivel_[pin] = alto;
+}
+
+PantallaHost::PantallaHost() : operaciones_(0), encendida_(true) { ultimoTexto_[0] = '\0'; }
+
+void PantallaHost::textoCentrado(const char *texto, int16_t, int16_t, uint8_t, uint16_t, uint32_t)
+{
+  operaciones_++;
+  strncpy(ultimoTexto_, texto, sizeof(ultimoTexto_) - 1);
+  ultimoTexto_[sizeof(ultimoTexto_) - 1] = '\0';
+}
+
+TactilHost::TactilHost() : tocando_(false), lecturas_(0), x_(0), y_(0) {}
+
+bool TactilHost::leer(uint16_t &x, uint16_t &y)
+{
+  lecturas_++;
+  if (!tocando_)
+    return false;
+  x = x_;
+  y = y_;
+  return true;
+}
+
+// Sin panel que tocar: la calibracion identidad del XPT2046 a 240x320
+void TactilHost::calibrar(uint16_t datos[5])
+{
+  static const uint16_t IDENTIDAD[5] = {0, 240, 0, 320, 0};
+  memcpy(datos, IDENTIDAD, sizeof(IDENTIDAD));
+}
+
+void TactilHost::tocar(uint16_t x, uint16_t y)
+{
+  x_ = x;
+  y_ = y;
+  tocando_ = true;
+}
+
+// 25.0 C en ambos canales hasta que se fije otra cosa
+SensoresHost::SensoresHost() : conversiones_(0) { q4_[0] = q4_[1] = 25 * 16; }
+
+void SensoresHost::fijar(uint8_t indice, int16_t q4)
+{
+  if (indice < 2)
+    q4_[indice] = q4;
+}
+
+void ConsolaHost::escribir(const char *texto)
+{
+  size_t len = strlen(texto);
+  crc_ = crc32(texto, len, crc_);
+  for (size_t i = 0; i < len; i++)
+    lineas_ += texto[i] == '\n';
+  if (silenciada_)
+    return;
+  fputs(texto, stdout);
+  fflush(stdout);
+}
+
+EstadoMemoria PlataformaHost::memoria()
+{
+  struct mallinfo2 info = mallinfo2();
+  EstadoMemoria m;
+  m.libre = (uint32_t)info.fordblks;
+  if (m.libre < minimoLibre_)
+    minimoLibre_ = m.libre;
+  m.minimoLibre = minimoLibre_;
+  m.mayorBloque = m.libre;
+  return m;
+}
+
+ArchivosHost::ArchivosHost(const char *directorio) : directorio_(directorio) {}
+
+void ArchivosHost::completar(const char *ruta, char *completa, size_t cap)
+{
+  mkdir(directorio_, 0755);
+  snprintf(completa, cap, "%s%s", directorio_, ruta);
+}
+
+bool ArchivosHost::existe(const char *ruta)
+{
+  char completa[128];
+  completar(ruta, completa, sizeof(completa));
+  return access(completa, F_OK) == 0;
+}
+
+bool ArchivosHost::borrar(const char *ruta)
+{
+  char completa[128];
+  completar(ruta, completa, sizeof(completa));
+  return remove(completa) == 0;
+}
+
+size_t ArchivosHost::leer(const char *ruta, size_t desde, void *datos, size_t len)
+{
+  char completa[128];
+  completar(ruta, completa, sizeof(completa));
+  FILE *f = fopen(completa, "rb");
+  if (!f)
+    return 0;
+  size_t n = fseek(f, (long)desde, SEEK_SET) == 0 ? fread(datos, 1, len, f) : 0;
+  fclose(f);
+  return n;
+}
+
+size_t ArchivosHost::escribir(const char *ruta, const void *datos, size_t len)
+{
+  char completa[128];
+  completar(ruta, completa, sizeof(completa));
+  FILE *f = fopen(completa, "wb");
+  if (!f)
+    return 0;
+  size_t n = fwrite(datos, 1, len, f);
+  fclose(f);
+  return n;
+}
+
+RelojHost relojHost;
+GpioHost gpioHost;
+PantallaHost pantallaHost;
+TactilHost tactilHost;
+SensoresHost sensoresHost;
+ConsolaHost consolaHost;
+ArchivosHost archivosHost("datos_host");
+PlataformaHost plataformaHost;
+TransporteHost transporteHost(TransporteHost::PTY);
+FlashEmulada flashHost(0xB0000); // Mismo tamano que la particion datalog
+
+Reloj &reloj = relojHost;
+Gpio &gpio = gpioHost;
+Pantalla &pantalla = pantallaHost;
+Tactil &tactil = tactilHost;
+SensoresTemperatura &sensores = sensoresHost;
+Consola &consola = consolaHost;
+SistemaArchivos &archivos = archivosHost;
+Plataforma &plataforma = plataformaHost;
+Transporte &enlaceBT = transporteHost;
+MemoriaFlash &flashDatos = flashHost;
+
+// La flash arranca con lo que quedo de la corrida anterior, si hay
+bool iniciarHal()
+{
+  char ruta[128];
+  archivosHost.completar(ARCHIVO_FLASH_HOST, ruta, sizeof(ruta));
+  flashHost.cargar(ruta);
+  return true;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef ARDUINO
+
+#include "lazo_host.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <atomic>
+#include "aplicacion.h"
+#include "ajustes.h"
+#include "control.h"
+#include "hal_host.h"
+
+static std::atomic<bool> avisos[4];
+
+void avisar(Tarea &t)
+{
+  if (t.handle)
+    ((std::atomic<bool> *)t.handle)->store(true);
+}
+
+// Un solo hilo con la pila del proceso: no hay nada que medir
+uint32_t pilaLibre(const Tarea *) { return 0; }
+
+void iniciarTareasHost()
+{
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+  {
+    tareas[i]->handle = &avisos[i];
+    avisos[i] = true;
+  }
+}
+
+uint32_t correrTareasHost()
+{
+  uint32_t corridas = 0;
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+  {
+    Tarea &t = *tareas[i];
+    bool vencida = !t.sinPlazo && (int32_t)(t.proximoUs - reloj.micros()) <= 0;
+    if (avisos[i].exchange(false) || vencida)
+    {
+      pasoTarea(t);
+      corridas++;
+    }
+  }
+  return corridas;
+}
+
+uint32_t esperaHost(uint32_t maximoUs)
+{
+  uint32_t ahora = reloj.micros();
+  uint32_t esperaUs = maximoUs;
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+  {
+    const Tarea &t = *tareas[i];
+    if (avisos[i])
+      return 0;
+    if (t.sinPlazo)
+      continue;
+    int32_t falta = (int32_t)(t.proximoUs - ahora);
+    uint32_t us = falta > 0 ? (uint32_t)falta : 0;
+    if (us < esperaUs)
+      esperaUs = us;
+  }
+  return esperaUs;
+}
+
+uint64_t simularHost(uint64_t us)
+{
+  uint64_t fin = relojHost.us64() + us;
+  uint64_t activaciones = 0;
+  while (relojHost.us64() < fin)
+  {
+    activaciones += correrTareasHost();
+    uint64_t restante = fin - relojHost.us64();
+    uint32_t esperaUs = esperaHost(restante < UINT32_MAX ? (uint32_t)restante : UINT32_MAX);
+    if (esperaUs == UINT32_MAX)
+      break;
+    relojHost.avanzar(esperaUs);
+  }
+  return activaciones;
+}
+
+static uint32_t microsHost() { return reloj.micros(); }
+
+void prepararHost(const char *directorio, uint64_t relojInicialUs)
+{
+  relojHost.simular(relojInicialUs);
+  archivosHost.directorio(directorio);
+  archivosHost.borrar("/ajustes_a.bin");
+  archivosHost.borrar("/ajustes_b.bin");
+  archivosHost.borrar(ARCHIVO_FLASH_HOST);
+
+  AlmacenAjustes semilla(archivos, microsHost);
+  semilla.begin();
+  Ajustes &a = semilla.editar();
+  a.modo = MODO_AUTO;
+  tactil.calibrar(a.calTactil);
+  a.calValida = 1;
+  semilla.confirmar();
+}
+
+void tocarHost(uint16_t x, uint16_t y)
+{
+  tactilHost.tocar(x, y);
+  toquePendiente = true;
+  avisar(tareaInterfaz);
+}
+
+void pulsarHost(uint16_t x, uint16_t y)
+{
+  tocarHost(x, y);
+  simularHost(100000);
+  tactilHost.soltar();
+  simularHost(400000);
+}
+
+int abrirClientePty(const char *ruta)
+{
+  if (!ruta || !ruta[0])
+    return -1;
+  int fd = open(ruta, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  struct termios t;
+  if (fd >= 0 && tcgetattr(fd, &t) == 0)
+  {
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  return fd;
+}
+
+int abrirClienteBT() { return abrirClientePty(transporteHost.rutaPty()); }
+
+// El pty pasa los bytes al master en diferido (workqueue del kernel)
+static const useconds_t ESPERA_PTY_US = 2000;
+
+bool enviarBT(int cliente, const char *linea)
+{
+  size_t largo = strlen(linea);
+  if (cliente < 0 || write(cliente, linea, largo) != (ssize_t)largo)
+    return false;
+  usleep(ESPERA_PTY_US);
+  return true;
+}
+
+#endif
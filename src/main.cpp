@@ -1,363 +1,146 @@
-
+#ifdef ARDUINO
 
 #include <Arduino.h>
-#include <SPI.h>
-#include <TFT_eSPI.h>
-#include "FS.h"
-#include "SPIFFS.h"
-#include <OneWire.h>
-#include <DallasTemperature.h>
-#include "esp32-hal-cpu.h"
-#include "BluetoothSerial.h"
-
-// --- Configuración de Hardware ---
-#define PIN_BL 32
-#define PIN_RELE1 33
-#define PIN_RELE2 26
-#define ONE_WIRE_BUS 27
-
-// --- Instancias ---
-TFT_eSPI tft = TFT_eSPI();
-OneWire oneWire(ONE_WIRE_BUS);
-DallasTemperature sensors(&oneWire);
-BluetoothSerial SerialBT;
-
-// --- Variables de Estado (Iniciamos explícitamente en TRUE) ---
-bool sistemaEstado = false;
-bool pantallaEncendida = true; // Forzar estado activo
-bool btActivo = false;
-unsigned long lastRelayMillis = 0;
-unsigned long lastTempMillis = 0;
-bool estadoRele = false;
-
-// --- Colores ---
-#define COL_FONDO 0x0842
-#define COL_CARD 0x10A4
-#define COL_ACCENT 0x03EF
-#define COL_BTN_ON 0x2661
-#define COL_BTN_OFF 0x114F
-#define COL_TEXTO 0xFFFF
-#define COL_SUBTEXTO 0xAD75
-
-// --- Geometría ---
-const int btnY = 250;
-const int btnH = 60;
-const int btnW = 105;
-const int btn1X = 10;
-const int btn2X = 125;
-int cardH = 85;
-
-// Prototipos
-void dibujarInterfazBase();
-void dibujarBotonSistema(bool estado);
-void dibujarBotonBL();
-void touch_calibrate();
-void gestionarModoEnergia(bool despertar);
-void actualizarVisualReles();
-void actualizarTemperaturas();
-void toggleBluetooth();
-void enviarReporteEstado();
-
-void btCallback(esp_spp_cb_event_t event, esp_spp_cb_param_t *param)
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "aplicacion.h"
+#include "hal.h"
+
+// --- Tareas: prioridad (mayor gana), nucleo y pila en bytes ---
+// El stack BT corre en el nucleo 0: comunicaciones va con el, y lo que
+// toca reles y pantalla queda en el 1 sin competir con la radio.
+#define PRIORIDAD_CONTROL 5
+#define PRIORIDAD_SENSORES 4
+#define PRIORIDAD_INTERFAZ 3
+#define PRIORIDAD_COMUNICACIONES 2
+#define NUCLEO_CONTROL 1
+#define NUCLEO_SENSORES 1
+#define NUCLEO_INTERFAZ 1
+#define NUCLEO_COMUNICACIONES 0
+#define PILA_CONTROL 3072
+#define PILA_SENSORES 3072
+#define PILA_INTERFAZ 6144
+#define PILA_COMUNICACIONES 8192
+
+// --- Energia ---
+#define ESPERA_MINIMA_SLEEP_US 5000 // Por debajo no compensa entrar en light sleep
+#define PERIODO_ENERGIA_MS 20       // Sondeo de loop() mientras alguna tarea no puede dormir
+
+StackType_t pilaControl[PILA_CONTROL];
+StackType_t pilaSensores[PILA_SENSORES];
+StackType_t pilaInterfaz[PILA_INTERFAZ];
+StackType_t pilaComunicaciones[PILA_COMUNICACIONES];
+StaticTask_t tcbControl, tcbSensores, tcbInterfaz, tcbComunicaciones;
+TaskHandle_t tareaLoop = nullptr;
+
+void dormirHasta(uint32_t esperaUs);
+
+void avisar(Tarea &t)
 {
-  if (event == ESP_SPP_SRV_OPEN_EVT)
-  {
-    Serial.println("\n[BT] ¡Cliente conectado!");
-    delay(200);
-    enviarReporteEstado();
-  }
+  // Antes de crearse la tarea no hace falta: drena sus anillos al arrancar
+  if (t.handle)
+    xTaskNotifyGive((TaskHandle_t)t.handle);
 }
 
-void setup()
+uint32_t pilaLibre(const Tarea *t)
 {
-  // 1. Iniciar Serial y Frecuencia Máxima
-  Serial.begin(115200);
-  setCpuFrequencyMhz(240);
-
-  // 2. Configurar pines de relés
-  pinMode(PIN_RELE1, OUTPUT);
-  pinMode(PIN_RELE2, OUTPUT);
-  digitalWrite(PIN_RELE1, LOW);
-  digitalWrite(PIN_RELE2, HIGH);
-
-  // 3. Inicializar Sensores y FS
-  sensors.begin();
-  if (!SPIFFS.begin(true))
-    Serial.println("Error SPIFFS");
-
-  // 4. Inicializar Pantalla (La librería podría intentar apagar el pin 32 aquí)
-  tft.init();
-  tft.setRotation(0);
-  tft.fillScreen(TFT_BLACK);
-
-  // 5. Configuración de Bluetooth
-  SerialBT.register_callback(btCallback);
-
-  // 6. Dibujar Interfaz (Aún con la luz apagada para evitar ver el "dibujado")
-  touch_calibrate();
-  dibujarInterfazBase();
-  dibujarBotonSistema(sistemaEstado);
-  dibujarBotonBL();
-  actualizarVisualReles();
-  actualizarTemperaturas();
-
-  // 7. FINAL DEL SETUP: FORZAR ENCENDIDO DE LUZ
-  pinMode(PIN_BL, OUTPUT);
-  digitalWrite(PIN_BL, LOW); // 1 = ON
-  pantallaEncendida = true;
-
-  Serial.println("--- Sistema Iniciado y Pantalla ON ---");
+  return uxTaskGetStackHighWaterMark(t ? (TaskHandle_t)t->handle : tareaLoop);
 }
 
-void loop()
+void correrTarea(void *arg)
 {
-  uint16_t x, y;
-
-  // Escucha Bluetooth
-  if (btActivo && SerialBT.available())
-  {
-    String incoming = SerialBT.readStringUntil('\n');
-    Serial.println("BT RECIBIDO: " + incoming);
-  }
-
-  // Sensores cada 2s
-  if (millis() - lastTempMillis >= 2000)
-  {
-    lastTempMillis = millis();
-    sensors.requestTemperatures();
-    if (pantallaEncendida)
-      actualizarTemperaturas();
-  }
-
-  // Relés cada 3s
-  if (millis() - lastRelayMillis >= 3000)
+  Tarea &t = *(Tarea *)arg;
+  while (true)
   {
-    lastRelayMillis = millis();
-    estadoRele = !estadoRele;
-    digitalWrite(PIN_RELE1, estadoRele);
-    digitalWrite(PIN_RELE2, !estadoRele);
-    if (pantallaEncendida)
-      actualizarVisualReles();
-  }
-
-  if (tft.getTouch(&x, &y, 250))
-  {
-    // Esquina superior derecha: Toggle BT
-    if (y < 40 && x > 180)
-    {
-      toggleBluetooth();
-      delay(300);
-      return;
-    }
-
-    if (!pantallaEncendida)
-    {
-      // Área de botón para despertar
-      if ((x > btn2X) && (x < (btn2X + btnW)) && (y > btnY) && (y < (btnY + btnH)))
-      {
-        gestionarModoEnergia(true);
-        delay(300);
-      }
-    }
-    else
-    {
-      // Botón Táctil ON/OFF
-      if ((x > btn1X) && (x < (btn1X + btnW)) && (y > btnY) && (y < (btnY + btnH)))
-      {
-        sistemaEstado = !sistemaEstado;
-        dibujarBotonSistema(sistemaEstado);
-        Serial.println("Tactil presionado: " + String(sistemaEstado ? "ON" : "OFF"));
-        enviarReporteEstado();
-        delay(350);
-      }
-      // Botón Sleep
-      else if ((x > btn2X) && (x < (btn2X + btnW)) && (y > btnY) && (y < (btnY + btnH)))
-      {
-        gestionarModoEnergia(false);
-      }
-    }
-    while (tft.getTouch(&x, &y, 250))
-      ;
+    uint32_t esperaUs = pasoTarea(t);
+    if (esperaUs == 0)
+      continue;
+    // El tick es de 1 ms: se redondea hacia arriba para no despertar antes
+    ulTaskNotifyTake(pdTRUE, esperaUs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS((esperaUs + 999) / 1000));
   }
 }
 
-void enviarReporteEstado()
+void crearTarea(Tarea &t, StaticTask_t &tcb, StackType_t *pila, uint32_t bytesPila, UBaseType_t prioridad,
+                BaseType_t nucleo)
 {
-  float t1 = sensors.getTempCByIndex(0);
-  float t2 = sensors.getTempCByIndex(1);
-
-  String reporte = "\n--- REPORTE ESP32 ---\n";
-  reporte += "S1: " + (t1 == DEVICE_DISCONNECTED_C ? "ERR" : String(t1, 1) + "C") + " | ";
-  reporte += "S2: " + (t2 == DEVICE_DISCONNECTED_C ? "ERR" : String(t2, 1) + "C") + "\n";
-  reporte += "Reles: K1=" + String(estadoRele ? "ON" : "OFF") + " K2=" + String(!estadoRele ? "ON" : "OFF") + "\n";
-  reporte += "Tactil: " + String(sistemaEstado ? "ENCENDIDO" : "APAGADO") + "\n";
-  reporte += "Pantalla: " + String(pantallaEncendida ? "ON" : "SLEEP") + "\n";
-  reporte += "---------------------\n";
-
-  Serial.print(reporte);
-  if (SerialBT.hasClient())
-    SerialBT.print(reporte);
+  t.handle = xTaskCreateStaticPinnedToCore(correrTarea, t.nombre, bytesPila, &t, prioridad, pila, &tcb, nucleo);
 }
 
-void toggleBluetooth()
+// PENIRQ baja mientras el panel esta presionado
+void IRAM_ATTR isrTactil()
 {
-  btActivo = !btActivo;
-  if (btActivo)
-  {
-    setCpuFrequencyMhz(240);
-    SerialBT.begin("ESP32_TFT_TEST");
-    Serial.println("BT: Visible");
-  }
-  else
-  {
-    SerialBT.end();
-    Serial.println("BT: Apagado");
-  }
-
-  if (pantallaEncendida)
-  {
-    tft.fillRect(190, 5, 45, 30, btActivo ? COL_ACCENT : COL_CARD);
-    tft.setTextColor(COL_TEXTO);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString(btActivo ? "BT ON" : "BT OFF", 212, 20, 1);
-  }
-}
-
-void gestionarModoEnergia(bool despertar)
-{
-  if (despertar)
-  {
-    setCpuFrequencyMhz(240);
-    tft.writecommand(0x11); // Wake up display
-    delay(120);
-    digitalWrite(PIN_BL, LOW); // 1 = ON
-    pantallaEncendida = true;
-
-    dibujarInterfazBase();
-    dibujarBotonSistema(sistemaEstado);
-    dibujarBotonBL();
-    actualizarVisualReles();
-    actualizarTemperaturas();
-  }
-  else
-  {
-    digitalWrite(PIN_BL, LOW); // 0 = OFF
-    tft.writecommand(0x10);    // Sleep display
-    if (btActivo)
-      setCpuFrequencyMhz(160);
-    else
-      setCpuFrequencyMhz(80);
-    pantallaEncendida = false;
-  }
-}
-
-void actualizarTemperaturas()
-{
-  float t1 = sensors.getTempCByIndex(0);
-  float t2 = sensors.getTempCByIndex(1);
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextColor(COL_TEXTO, COL_CARD);
-  tft.drawString(t1 == DEVICE_DISCONNECTED_C ? "--.- C" : String(t1, 1) + " C", 62, 105, 4);
-  tft.drawString(t2 == DEVICE_DISCONNECTED_C ? "--.- C" : String(t2, 1) + " C", 177, 105, 4);
-}
-
-void actualizarVisualReles()
-{
-  tft.setTextDatum(MC_DATUM);
-  tft.setTextColor(estadoRele ? COL_BTN_ON : COL_SUBTEXTO, COL_CARD);
-  tft.drawString(estadoRele ? " ESTADO: ON " : " ESTADO: OFF", 62, 195, 2);
-  tft.setTextColor(!estadoRele ? COL_BTN_ON : COL_SUBTEXTO, COL_CARD);
-  tft.drawString(!estadoRele ? " ESTADO: ON " : " ESTADO: OFF", 177, 195, 2);
+  toquePendiente = true;
+  if (!tareaInterfaz.handle)
+    return;
+  BaseType_t despertada = pdFALSE;
+  vTaskNotifyGiveFromISR((TaskHandle_t)tareaInterfaz.handle, &despertada);
+  if (despertada)
+    portYIELD_FROM_ISR();
 }
 
-void dibujarBotonSistema(bool estado)
+void setup()
 {
-  uint16_t color = estado ? COL_BTN_ON : COL_BTN_OFF;
-  tft.fillRoundRect(btn1X, btnY, btnW, btnH, 8, color);
-  tft.drawRoundRect(btn1X, btnY, btnW, btnH, 8, COL_ACCENT);
-  tft.setTextColor(COL_TEXTO);
-  tft.setTextDatum(MC_DATUM);
-  tft.drawString(estado ? "TACTIL ON" : "TACTIL OFF", btn1X + (btnW / 2), btnY + (btnH / 2), 2);
-}
+  iniciarAplicacion();
+  attachInterrupt(digitalPinToInterrupt(PIN_T_IRQ), isrTactil, FALLING);
 
-void dibujarBotonBL()
-{
-  tft.fillRoundRect(btn2X, btnY, btnW, btnH, 8, COL_CARD);
-  tft.drawRoundRect(btn2X, btnY, btnW, btnH, 8, COL_ACCENT);
-  tft.setTextColor(COL_TEXTO);
-  tft.setTextDatum(MC_DATUM);
-  tft.drawString("SLEEP", btn2X + (btnW / 2), btnY + (btnH / 2), 2);
-}
+  // Tareas (setup y loop() corren en loopTask, prioridad 1 del nucleo 1)
+  tareaLoop = xTaskGetCurrentTaskHandle();
+  crearTarea(tareaComunicaciones, tcbComunicaciones, pilaComunicaciones, PILA_COMUNICACIONES,
+             PRIORIDAD_COMUNICACIONES, NUCLEO_COMUNICACIONES);
+  crearTarea(tareaInterfaz, tcbInterfaz, pilaInterfaz, PILA_INTERFAZ, PRIORIDAD_INTERFAZ, NUCLEO_INTERFAZ);
+  crearTarea(tareaSensores, tcbSensores, pilaSensores, PILA_SENSORES, PRIORIDAD_SENSORES, NUCLEO_SENSORES);
+  crearTarea(tareaControl, tcbControl, pilaControl, PILA_CONTROL, PRIORIDAD_CONTROL, NUCLEO_CONTROL);
 
-void dibujarInterfazBase()
-{
-  tft.fillScreen(COL_FONDO);
-  tft.fillRect(0, 0, 240, 40, COL_CARD);
-  tft.drawFastHLine(0, 40, 240, COL_ACCENT);
-  tft.setTextColor(COL_TEXTO);
-  tft.setTextDatum(MC_DATUM);
-  tft.drawString("PANEL DE CONTROL", 100, 20, 2);
-  tft.fillRect(190, 5, 45, 30, btActivo ? COL_ACCENT : COL_CARD);
-  tft.drawString(btActivo ? "BT ON" : "BT OFF", 212, 20, 1);
-  tft.drawRoundRect(10, 55, 105, cardH, 8, TFT_WHITE);
-  tft.drawRoundRect(125, 55, 105, cardH, 8, TFT_WHITE);
-  tft.drawRoundRect(10, 150, 105, cardH, 8, TFT_WHITE);
-  tft.drawRoundRect(125, 150, 105, cardH, 8, TFT_WHITE);
-  tft.setTextColor(COL_SUBTEXTO);
-  tft.drawString("Sensor 1", 62, 70, 2);
-  tft.drawString("Sensor 2", 177, 70, 2);
-  tft.drawString("Rele 1", 62, 165, 2);
-  tft.drawString("Rele 2", 177, 165, 2);
+  Serial.println("--- Sistema Iniciado y Pantalla ON ---");
 }
 
-void touch_calibrate()
+// loop() es la tarea de menor prioridad del nucleo 1: solo decide el light
+// sleep. Con la pantalla en reposo, sin BT y todas las tareas bloqueadas,
+// el chip duerme hasta la activacion mas cercana.
+void loop()
 {
-  uint16_t calData[5];
-  uint8_t check = 0; // Inicializamos check en 0
-
-  // 1. Verificar si existe el archivo de calibración usando el namespace fs::
-  if (SPIFFS.exists("/TouchCalData"))
+  uint32_t ahora = micros();
+  uint32_t esperaUs = UINT32_MAX;
+  bool reposo = true;
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
   {
-    fs::File f = SPIFFS.open("/TouchCalData", "r"); // Cambiado a fs::File
-    if (f)
-    {
-      if (f.readBytes((char *)calData, 14) == 14)
-        check = 1;
-      f.close();
-    }
+    const Tarea &t = *tareas[i];
+    reposo = reposo && t.enReposo;
+    if (t.sinPlazo)
+      continue;
+    int32_t falta = (int32_t)(t.proximoUs - ahora);
+    uint32_t us = falta > 0 ? (uint32_t)falta : 0;
+    if (us < esperaUs)
+      esperaUs = us;
   }
 
-  if (check && !Serial.available())
+  if (!reposo || esperaUs < ESPERA_MINIMA_SLEEP_US)
   {
-    // 2. Si el archivo existe, cargar los datos
-    tft.setTouch(calData);
-    Serial.println("Datos de calibracion cargados desde SPIFFS");
+    vTaskDelay(pdMS_TO_TICKS(PERIODO_ENERGIA_MS));
+    return;
   }
-  else
-  {
-    // 3. Si no existe, ejecutar calibracion interactiva
-    tft.fillScreen(TFT_BLACK);
-    tft.setCursor(20, 0);
-    tft.setTextFont(2);
-    tft.setTextSize(1);
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-
-    tft.println("Toca las esquinas indicadas para calibrar");
-
-    tft.setTextFont(1);
-    tft.println("(Mantente presionado hasta que desaparezca)");
+  dormirHasta(esperaUs);
+}
 
-    // Ejecuta la rutina de la libreria
-    tft.calibrateTouch(calData, TFT_MAGENTA, TFT_BLACK, 15);
+// Light sleep: lo despiertan el temporizador o PENIRQ
+void dormirHasta(uint32_t esperaUs)
+{
+  Serial.flush();
+  gpio_wakeup_enable((gpio_num_t)PIN_T_IRQ, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_timer_wakeup((uint64_t)esperaUs);
+  esp_light_sleep_start();
+
+  // gpio_wakeup_enable() cambia el tipo de interrupcion: restaurar el flanco
+  gpio_wakeup_disable((gpio_num_t)PIN_T_IRQ);
+  gpio_set_intr_type((gpio_num_t)PIN_T_IRQ, GPIO_INTR_NEGEDGE);
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO)
+    toquePendiente = true;
+
+  // micros() se compensa al despertar pero el tick de FreeRTOS no: las
+  // tareas vuelven a mirar su planificador en vez de esperar el timeout
+  for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+    avisar(*tareas[i]);
+}
 
-    // 4. Guardar los nuevos datos en SPIFFS usando fs::File
-    fs::File f = SPIFFS.open("/TouchCalData", "w"); // Cambiado a fs::File
-    if (f)
-    {
-      f.write((const unsigned char *)calData, 14);
-      f.close();
-      Serial.println("Calibracion completa y guardada.");
-    }
-    tft.fillScreen(TFT_BLACK);
-  }
-}
\ No newline at end of file
+#endif
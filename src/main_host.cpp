@@ -0,0 +1,222 @@
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING) // Las pruebas de test/ traen su main()
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "aplicacion.h"
+#include "benchmarks.h"
+#include "lazo_host.h"
+#include "hal_host.h"
+#include "crc.h"
+
+// --- Aplicacion en Linux ([env:native]) ---
+// Las cuatro tareas corren cooperativas en un solo hilo (lazo_host.h) y
+// entre vuelta y vuelta se espera hasta la proxima. El hardware son los
+// dobles de hal_host.h; el enlace BT es un PTY que abre cualquier terminal.
+//
+//   controlador_host [segundos] [--bt]
+//   controlador_host --sim <dias>
+//   controlador_host --bench [iteraciones] [nombre]
+//
+// Sin segundos corre hasta Ctrl-C. Con --bt enciende el Bluetooth tocando
+// el indicador de la pantalla, como haria un usuario.
+//
+// --sim corre en tiempo virtual: en vez de dormir, el reloj salta al
+// proximo plazo. Arranca de cero en datos_sim/ con el termostato en AUTO,
+// prende el sistema y apaga la pantalla desde el tactil, y alimenta los
+// sensores con una rampa determinista. millis() da la vuelta a mitad de la
+// corrida. Al final resume lo que paso con CRCs de la consola y la flash:
+// dos corridas iguales dan los mismos numeros. Si despues de la primera hora
+// hubo algun pedido al heap (memoria.h), sale con error.
+//
+// --bench mide los caminos calientes por separado (benchmarks.h) y sale.
+
+#define ESPERA_MAXIMA_HOST_US 10000 // Sondeo del PTY aunque nadie tenga plazo
+#define TOQUE_HOST_MS 100
+
+// --- Simulacion ---
+#define HORAS_HASTA_VUELTA_SIM 84ULL           // millis() da la vuelta a las 3.5 dias
+#define PERIODO_RAMPA_SIM_MS (4ULL * 3600000) // Subida y bajada de la temperatura
+#define AMPLITUD_RAMPA_SIM_Q4 (3 * 16)        // +-3 C alrededor de la consigna
+#define REGIMEN_SIM_MS 3600000ULL             // Desde aca no se pide mas memoria
+
+// El dedo se apoya en (x, y) a los 'ms' del arranque y se levanta
+// TOQUE_HOST_MS despues
+struct ToqueHost
+{
+  uint32_t ms;
+  uint16_t x;
+  uint16_t y;
+};
+
+static const ToqueHost TOQUES_BT[] = {{0, 212, 20}};                    // Indicador BT
+static const ToqueHost TOQUES_SIM[] = {{500, 62, 280}, {2000, 177, 280}}; // TACTIL ON, SLEEP
+
+static volatile sig_atomic_t salir = 0;
+
+static void alSenal(int) { salir = 1; }
+
+// Estado limpio y ajustes fijos para que la corrida sea reproducible
+static void prepararSimulacion()
+{
+  prepararHost("datos_sim", ((1ULL << 32) - HORAS_HASTA_VUELTA_SIM * 3600000) * 1000);
+  consolaHost.silenciar(true);
+}
+
+// Rampa triangular alrededor de la consigna por defecto (25.0 C); el canal 2
+// va a contrafase
+static void alimentarSensores(uint64_t transcurridoMs)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    uint64_t fase = (transcurridoMs + i * PERIODO_RAMPA_SIM_MS / 2) % PERIODO_RAMPA_SIM_MS;
+    uint64_t mitad = PERIODO_RAMPA_SIM_MS / 2;
+    int32_t subida = (int32_t)((fase < mitad ? fase : PERIODO_RAMPA_SIM_MS - fase) * 2 * AMPLITUD_RAMPA_SIM_Q4 / mitad);
+    sensoresHost.fijar(i, (int16_t)(25 * 16 - AMPLITUD_RAMPA_SIM_Q4 + subida));
+  }
+}
+
+static uint32_t crcFlash()
+{
+  uint8_t bloque[MemoriaFlash::TAM_SECTOR];
+  uint32_t crc = 0;
+  for (uint32_t dir = 0; dir < flashHost.tamano(); dir += sizeof(bloque))
+  {
+    flashHost.leer(dir, bloque, sizeof(bloque));
+    crc = crc32(bloque, sizeof(bloque), crc);
+  }
+  return crc;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+  {
+    uint32_t iteraciones = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 0;
+    return correrBenchmarks(iteraciones, argc > 3 ? argv[3] : nullptr) ? 0 : 1;
+  }
+
+  uint32_t segundos = 0;
+  uint32_t diasSimulados = 0;
+  bool encenderBT = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--bt") == 0)
+      encenderBT = true;
+    else if (strcmp(argv[i], "--sim") == 0 && i + 1 < argc)
+      diasSimulados = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else
+      segundos = (uint32_t)strtoul(argv[i], nullptr, 10);
+  }
+  signal(SIGINT, alSenal);
+  signal(SIGTERM, alSenal);
+
+  bool simulado = diasSimulados > 0;
+  if (simulado)
+    prepararSimulacion();
+  uint64_t inicioUs = relojHost.us64();
+  uint64_t duracionUs = simulado ? diasSimulados * 86400000000ULL : segundos * 1000000ULL;
+  auto inicioReal = std::chrono::steady_clock::now();
+
+  iniciarAplicacion();
+  iniciarTareasHost();
+  consola.escribir("--- Sistema Iniciado (host) ---\n");
+
+  const ToqueHost *toques = simulado ? TOQUES_SIM : encenderBT ? TOQUES_BT : nullptr;
+  size_t cantidadToques = simulado ? sizeof(TOQUES_SIM) / sizeof(TOQUES_SIM[0])
+                          : encenderBT ? sizeof(TOQUES_BT) / sizeof(TOQUES_BT[0])
+                                       : 0;
+  size_t proximoToque = 0;
+  uint64_t activaciones = 0;
+  uint32_t millisInicial = reloj.millis();
+  uint32_t asignacionesRegimen = 0;
+  bool enRegimen = false;
+  bool ptyInformado = false;
+
+  while (!salir)
+  {
+    uint64_t transcurridoUs = relojHost.us64() - inicioUs;
+    if (duracionUs && transcurridoUs >= duracionUs)
+      break;
+    uint64_t transcurridoMs = transcurridoUs / 1000;
+    if (simulado)
+      alimentarSensores(transcurridoMs);
+    if (!enRegimen && transcurridoMs >= REGIMEN_SIM_MS)
+    {
+      asignacionesRegimen = asignaciones();
+      enRegimen = true;
+    }
+
+    // Toques: apoyar y soltar, en orden
+    if (proximoToque < cantidadToques)
+    {
+      const ToqueHost &t = toques[proximoToque];
+      if (!tactilHost.presionado() && transcurridoMs >= t.ms && transcurridoMs < t.ms + TOQUE_HOST_MS)
+      {
+        tocarHost(t.x, t.y);
+      }
+      else if (tactilHost.presionado() && transcurridoMs >= t.ms + TOQUE_HOST_MS)
+      {
+        tactilHost.soltar();
+        proximoToque++;
+      }
+    }
+
+    activaciones += correrTareasHost();
+
+    if (!ptyInformado && transporteHost.rutaPty()[0])
+    {
+      consola.printf("[HOST] BT en %s\n", transporteHost.rutaPty());
+      ptyInformado = true;
+    }
+
+    // Hasta el plazo mas cercano; con un toque en curso, de a TOQUE_HOST_MS
+    uint32_t esperaUs = simulado ? UINT32_MAX : ESPERA_MAXIMA_HOST_US;
+    if (proximoToque < cantidadToques && esperaUs > TOQUE_HOST_MS * 1000)
+      esperaUs = TOQUE_HOST_MS * 1000;
+    esperaUs = esperaHost(esperaUs);
+    if (esperaUs == UINT32_MAX)
+      break; // Nada mas va a pasar
+    if (duracionUs && esperaUs > duracionUs - transcurridoUs)
+      esperaUs = (uint32_t)(duracionUs - transcurridoUs);
+    if (esperaUs == 0)
+      continue;
+    if (simulado)
+      relojHost.avanzar(esperaUs);
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(esperaUs));
+  }
+
+  char ruta[128];
+  archivosHost.completar(ARCHIVO_FLASH_HOST, ruta, sizeof(ruta));
+  if (!flashHost.guardar(ruta))
+    consola.printf("Error guardando %s\n", ruta);
+
+  if (simulado)
+  {
+    double realS = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicioReal).count();
+    uint64_t simuladoUs = relojHost.us64() - inicioUs;
+    printf("[SIM] %.2f dias en %.2fs: activaciones=%llu conversiones=%lu cambios K1=%lu K2=%lu\n",
+           simuladoUs / 86400e6, realS, (unsigned long long)activaciones, (unsigned long)sensoresHost.conversiones(),
+           (unsigned long)gpioHost.cambios(PIN_RELE1), (unsigned long)gpioHost.cambios(PIN_RELE2));
+    printf("[SIM] millis %lu -> %lu flash programada=%luB borrados sector 0=%lu\n", (unsigned long)millisInicial,
+           (unsigned long)reloj.millis(), (unsigned long)flashHost.bytesProgramados(),
+           (unsigned long)flashHost.borrados(0));
+    printf("[SIM] consola lineas=%lu crc=%08lx flash crc=%08lx\n", (unsigned long)consolaHost.lineas(),
+           (unsigned long)consolaHost.crc(), (unsigned long)crcFlash());
+    if (enRegimen)
+    {
+      asignacionesRegimen = asignaciones() - asignacionesRegimen;
+      printf("[SIM] memoria: asignaciones en regimen=%lu (total %lu)\n", (unsigned long)asignacionesRegimen,
+             (unsigned long)asignaciones());
+      if (asignacionesRegimen > 0)
+        return 1;
+    }
+  }
+  return 0;
+}
+
+#endif
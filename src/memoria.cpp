@@ -0,0 +1,81 @@
+#include "memoria.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+static std::atomic<uint32_t> cuentaAsignaciones(0);
+static std::atomic<uint32_t> cuentaLiberaciones(0);
+
+uint32_t asignaciones() { return cuentaAsignaciones.load(std::memory_order_relaxed); }
+uint32_t liberaciones() { return cuentaLiberaciones.load(std::memory_order_relaxed); }
+
+uint8_t fragmentacion(const EstadoMemoria &m)
+{
+  if (m.libre == 0 || m.mayorBloque >= m.libre)
+    return 0;
+  return (uint8_t)(100 - (uint64_t)m.mayorBloque * 100 / m.libre);
+}
+
+// --- malloc y compania (-Wl,--wrap=malloc,...) ---
+// Toda referencia a malloc() del programa enlazado llega a __wrap_malloc();
+// __real_malloc() es el de la biblioteca C.
+extern "C"
+{
+  void *__real_malloc(size_t n);
+  void *__real_calloc(size_t cantidad, size_t n);
+  void *__real_realloc(void *p, size_t n);
+  void __real_free(void *p);
+
+  void *__wrap_malloc(size_t n)
+  {
+    cuentaAsignaciones.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(n);
+  }
+
+  void *__wrap_calloc(size_t cantidad, size_t n)
+  {
+    cuentaAsignaciones.fetch_add(1, std::memory_order_relaxed);
+    return __real_calloc(cantidad, n);
+  }
+
+  void *__wrap_realloc(void *p, size_t n)
+  {
+    if (n > 0)
+      cuentaAsignaciones.fetch_add(1, std::memory_order_relaxed);
+    else if (p)
+      cuentaLiberaciones.fetch_add(1, std::memory_order_relaxed);
+    return __real_realloc(p, n);
+  }
+
+  void __wrap_free(void *p)
+  {
+    if (p)
+      cuentaLiberaciones.fetch_add(1, std::memory_order_relaxed);
+    __real_free(p);
+  }
+}
+
+// --- operator new/delete ---
+// Sobre malloc()/free(), que ya cuentan: en el host los de libstdc++ estan
+// en una biblioteca compartida que el --wrap no alcanza.
+
+// Sin memoria no hay como seguir: igual que un new que lanza sin nadie que
+// lo atrape
+void *operator new(size_t n)
+{
+  void *p = malloc(n ? n : 1);
+  if (!p)
+    abort();
+  return p;
+}
+
+void *operator new[](size_t n) { return operator new(n); }
+void *operator new(size_t n, const std::nothrow_t &) noexcept { return malloc(n ? n : 1); }
+void *operator new[](size_t n, const std::nothrow_t &) noexcept { return malloc(n ? n : 1); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
@@ -0,0 +1,95 @@
+#include "perfilador.h"
+#include <stdio.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+uint32_t ciclosCpu() { return ESP.getCycleCount(); }
+#else
+#include <chrono>
+
+uint32_t ciclosCpu()
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+Perfilador::Perfilador(RelojCiclos reloj, uint32_t mhz, const char *const *nombres, uint8_t cantidad)
+    : reloj_(reloj), nombres_(nombres), cantidad_(cantidad < MAX_ETAPAS ? cantidad : MAX_ETAPAS)
+{
+  frecuencia(mhz);
+  reiniciar();
+}
+
+void Perfilador::frecuencia(uint32_t mhz)
+{
+  mhz_ = mhz ? mhz : 1;
+  nsPorCicloQ16_ = ((1000UL << 16) + mhz_ / 2) / mhz_;
+}
+
+void Perfilador::reiniciar()
+{
+  for (uint8_t i = 0; i < cantidad_; i++)
+  {
+    EstadisticasEtapa &e = etapas_[i];
+    e.cantidad = 0;
+    e.minimoNs = UINT32_MAX;
+    e.maximoNs = 0;
+    e.sumaNs = 0;
+    e.asignaciones = 0;
+    e.histogramaNs.reiniciar();
+  }
+}
+
+void Perfilador::registrar(uint8_t etapa, uint32_t ciclos, uint32_t asignaciones)
+{
+  if (etapa >= cantidad_)
+    return;
+  // Sin division: producto 32x32 (mull/muluh en el Xtensa) por el factor
+  // precalculado. Vale mientras la etapa dure menos de 4 s.
+  uint32_t ns = (uint32_t)(((uint64_t)ciclos * nsPorCicloQ16_) >> 16);
+
+  EstadisticasEtapa &e = etapas_[etapa];
+  e.cantidad++;
+  e.sumaNs += ns;
+  e.asignaciones += asignaciones;
+  if (ns < e.minimoNs)
+    e.minimoNs = ns;
+  if (ns > e.maximoNs)
+    e.maximoNs = ns;
+  e.histogramaNs.registrar(ns);
+}
+
+// Microsegundos con un decimal a partir de nanosegundos
+static int escribirUs(char *buf, size_t tam, const char *etiqueta, uint32_t ns)
+{
+  return snprintf(buf, tam, " %s=%lu.%luus", etiqueta, (unsigned long)(ns / 1000), (unsigned long)(ns % 1000 / 100));
+}
+
+size_t Perfilador::describir(uint8_t etapa, char *buf, size_t tam) const
+{
+  if (tam == 0)
+    return 0;
+  buf[0] = '\0';
+  if (etapa >= cantidad_)
+    return 0;
+
+  const EstadisticasEtapa &e = etapas_[etapa];
+  int r = snprintf(buf, tam, "%s n=%lu", nombres_[etapa], (unsigned long)e.cantidad);
+  size_t n = r < 0 ? 0 : (size_t)r;
+  if (e.cantidad > 0)
+  {
+    const uint32_t valores[] = {e.minimoNs, e.mediaNs(), e.histogramaNs.percentil(99), e.maximoNs};
+    const char *etiquetas[] = {"min", "media", "p99", "max"};
+    for (uint8_t i = 0; i < 4 && n < tam; i++)
+    {
+      r = escribirUs(buf + n, tam - n, etiquetas[i], valores[i]);
+      if (r < 0)
+        break;
+      n += r;
+    }
+  }
+  return n < tam ? n : tam - 1;
+}
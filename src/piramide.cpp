@@ -0,0 +1,182 @@
+#include "piramide.h"
+
+const uint32_t PiramideResumen::SEGUNDOS_NIVEL[NIVELES] = {60, 3600};
+const uint16_t PiramideResumen::CAPACIDAD_NIVEL[NIVELES] = {CAPACIDAD_MINUTOS, CAPACIDAD_HORAS};
+
+// Posicion de cada anillo dentro de datos_
+static const uint16_t INICIO_NIVEL[PiramideResumen::NIVELES] = {0, PiramideResumen::CAPACIDAD_MINUTOS};
+
+void PiramideResumen::reiniciar()
+{
+  for (uint8_t n = 0; n < NIVELES; n++)
+  {
+    primero_[n] = 0;
+    usados_[n] = 0;
+    abiertos_[n].abierto = false;
+  }
+}
+
+void PiramideResumen::agregar(const Lectura &l)
+{
+  for (uint8_t n = 0; n < NIVELES; n++)
+  {
+    Acumulador &a = abiertos_[n];
+    uint32_t inicio = l.t - l.t % SEGUNDOS_NIVEL[n];
+    if (a.abierto && a.t != inicio)
+      cerrar(n);
+    if (!a.abierto)
+    {
+      a.t = inicio;
+      a.abierto = true;
+      for (uint8_t i = 0; i < 2; i++)
+      {
+        a.minQ4[i] = INT16_MAX;
+        a.maxQ4[i] = INT16_MIN;
+        a.suma[i] = 0;
+        a.cantidad[i] = 0;
+      }
+    }
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+      int16_t v = l.tempQ4[i];
+      if (v == TEMP_Q4_ERROR || a.cantidad[i] == UINT16_MAX)
+        continue;
+      if (v < a.minQ4[i])
+        a.minQ4[i] = v;
+      if (v > a.maxQ4[i])
+        a.maxQ4[i] = v;
+      a.suma[i] += v;
+      a.cantidad[i]++;
+    }
+  }
+}
+
+void PiramideResumen::cerrar(uint8_t nivel)
+{
+  uint16_t capacidad = CAPACIDAD_NIVEL[nivel];
+  uint16_t pos;
+  if (usados_[nivel] < capacidad)
+    pos = (primero_[nivel] + usados_[nivel]++) % capacidad;
+  else
+  {
+    // Lleno: el intervalo nuevo ocupa el lugar del mas viejo
+    pos = primero_[nivel];
+    primero_[nivel] = (primero_[nivel] + 1) % capacidad;
+  }
+  datos_[INICIO_NIVEL[nivel] + pos] = agregado(abiertos_[nivel]);
+  abiertos_[nivel].abierto = false;
+}
+
+Agregado PiramideResumen::agregado(const Acumulador &a)
+{
+  Agregado g;
+  g.t = a.t;
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    g.minQ4[i] = a.minQ4[i];
+    g.maxQ4[i] = a.maxQ4[i];
+    g.mediaQ4[i] = media(a.suma[i], a.cantidad[i]);
+  }
+  return g;
+}
+
+int16_t PiramideResumen::media(int32_t suma, uint16_t cantidad)
+{
+  if (cantidad == 0)
+    return TEMP_Q4_ERROR;
+  int32_t mitad = suma < 0 ? -(int32_t)(cantidad / 2) : cantidad / 2;
+  return (int16_t)((suma + mitad) / cantidad);
+}
+
+Agregado PiramideResumen::en(uint8_t nivel, uint16_t i) const
+{
+  if (i >= usados_[nivel])
+    return agregado(abiertos_[nivel]);
+  return datos_[INICIO_NIVEL[nivel] + (primero_[nivel] + i) % CAPACIDAD_NIVEL[nivel]];
+}
+
+uint16_t PiramideResumen::buscar(uint8_t nivel, uint32_t t) const
+{
+  uint16_t bajo = 0;
+  uint16_t alto = tamano(nivel);
+  while (bajo < alto)
+  {
+    uint16_t medio = (bajo + alto) / 2;
+    if (en(nivel, medio).t < t)
+      bajo = medio + 1;
+    else
+      alto = medio;
+  }
+  return bajo;
+}
+
+// --- Reduccion de series ---
+
+void ReductorSerie::sumar(const Agregado &g)
+{
+  if (g.t < desde_)
+    return;
+  uint32_t intervalo = (g.t - desde_) / ancho_;
+  if (abierto_ && intervalo != intervalo_)
+    cerrar();
+  if (!abierto_)
+  {
+    if (n_ >= max_ || intervalo >= max_)
+      return;
+    intervalo_ = intervalo;
+    actual_.t = desde_ + intervalo * ancho_;
+    for (uint8_t i = 0; i < 2; i++)
+    {
+      actual_.minQ4[i] = INT16_MAX;
+      actual_.maxQ4[i] = INT16_MIN;
+      suma_[i] = 0;
+      cantidad_[i] = 0;
+    }
+    abierto_ = true;
+  }
+
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (g.minQ4[i] > g.maxQ4[i])
+      continue;
+    if (g.minQ4[i] < actual_.minQ4[i])
+      actual_.minQ4[i] = g.minQ4[i];
+    if (g.maxQ4[i] > actual_.maxQ4[i])
+      actual_.maxQ4[i] = g.maxQ4[i];
+    if (g.mediaQ4[i] != TEMP_Q4_ERROR && cantidad_[i] < UINT16_MAX)
+    {
+      suma_[i] += g.mediaQ4[i];
+      cantidad_[i]++;
+    }
+  }
+}
+
+void ReductorSerie::sumar(const Lectura &l)
+{
+  Agregado g;
+  g.t = l.t;
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    bool valida = l.tempQ4[i] != TEMP_Q4_ERROR;
+    g.minQ4[i] = valida ? l.tempQ4[i] : INT16_MAX;
+    g.maxQ4[i] = valida ? l.tempQ4[i] : INT16_MIN;
+    g.mediaQ4[i] = l.tempQ4[i];
+  }
+  sumar(g);
+}
+
+size_t ReductorSerie::terminar()
+{
+  if (abierto_)
+    cerrar();
+  return n_;
+}
+
+void ReductorSerie::cerrar()
+{
+  for (uint8_t i = 0; i < 2; i++)
+    actual_.mediaQ4[i] = PiramideResumen::media(suma_[i], cantidad_[i]);
+  out_[n_++] = actual_;
+  abierto_ = false;
+}
@@ -0,0 +1,233 @@
+#include "planificador.h"
+
+// Las marcas de tiempo dan la vuelta (micros() cada ~71 min): se comparan
+// por diferencia, valido mientras esten a menos de ~35 min entre si.
+static bool anterior(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+Planificador::Planificador(RelojMicros reloj) : reloj_(reloj), cantidad_(0), vencidos_(0)
+{
+  esperando_.cantidad = 0;
+  esperando_.porPlazo = false;
+  listos_.cantidad = 0;
+  listos_.porPlazo = true;
+}
+
+uint8_t Planificador::agregar(const char *nombre, FuncionTrabajo funcion, uint32_t periodoUs, uint32_t plazoUs,
+                              uint32_t presupuestoUs)
+{
+  if (cantidad_ >= MAX_TRABAJOS)
+    return SIN_TRABAJO;
+  Trabajo &t = trabajos_[cantidad_];
+  t.nombre = nombre;
+  t.funcion = funcion;
+  t.periodoUs = periodoUs;
+  t.plazoUs = plazoUs;
+  t.presupuestoUs = presupuestoUs;
+  t.estado = INACTIVO;
+  t.estadisticas.retraso.reiniciar();
+  t.estadisticas.duracion.reiniciar();
+  t.estadisticas.vencidos = 0;
+  t.estadisticas.excedidos = 0;
+  t.estadisticas.omitidos = 0;
+  return cantidad_++;
+}
+
+uint8_t Planificador::periodico(const char *nombre, FuncionTrabajo funcion, uint32_t periodoUs, uint32_t plazoUs,
+                                uint32_t presupuestoUs, uint32_t faseUs)
+{
+  if (periodoUs == 0)
+    return SIN_TRABAJO;
+  uint8_t id = agregar(nombre, funcion, periodoUs, plazoUs ? plazoUs : periodoUs, presupuestoUs);
+  if (id != SIN_TRABAJO)
+    activar(id, faseUs);
+  return id;
+}
+
+uint8_t Planificador::unaVez(const char *nombre, FuncionTrabajo funcion, uint32_t plazoUs, uint32_t presupuestoUs)
+{
+  return agregar(nombre, funcion, 0, plazoUs, presupuestoUs);
+}
+
+void Planificador::activar(uint8_t id, uint32_t demoraUs)
+{
+  if (id >= cantidad_)
+    return;
+  pausar(id);
+  programar(id, reloj_() + demoraUs);
+}
+
+void Planificador::pausar(uint8_t id)
+{
+  if (id >= cantidad_)
+    return;
+  if (trabajos_[id].estado == ESPERANDO)
+    quitar(esperando_, id);
+  else if (trabajos_[id].estado == LISTO)
+    quitar(listos_, id);
+  trabajos_[id].estado = INACTIVO;
+}
+
+void Planificador::programar(uint8_t id, uint32_t activacion)
+{
+  Trabajo &t = trabajos_[id];
+  t.activacion = activacion;
+  t.plazo = activacion + t.plazoUs;
+  t.estado = ESPERANDO;
+  insertar(esperando_, id);
+}
+
+// Pasa a listos todo lo que ya se activo
+void Planificador::liberar(uint32_t ahora)
+{
+  while (esperando_.cantidad > 0 && !anterior(ahora, trabajos_[esperando_.ids[0]].activacion))
+  {
+    uint8_t id = extraer(esperando_);
+    trabajos_[id].estado = LISTO;
+    insertar(listos_, id);
+  }
+}
+
+uint8_t Planificador::ejecutar()
+{
+  uint8_t corridos = 0;
+  while (corridos < cantidad_)
+  {
+    uint32_t inicio = reloj_();
+    liberar(inicio);
+    if (listos_.cantidad == 0)
+      break;
+
+    uint8_t id = extraer(listos_);
+    Trabajo &t = trabajos_[id];
+    t.estado = CORRIENDO;
+    t.funcion();
+    uint32_t fin = reloj_();
+    corridos++;
+
+    EstadisticasTrabajo &e = t.estadisticas;
+    e.retraso.registrar(inicio - t.activacion);
+    e.duracion.registrar(fin - inicio);
+    if (anterior(t.plazo, fin))
+    {
+      e.vencidos++;
+      vencidos_++;
+    }
+    if (fin - inicio > t.presupuestoUs)
+      e.excedidos++;
+
+    // El trabajo pudo pausarse o reprogramarse a si mismo
+    if (t.estado != CORRIENDO)
+      continue;
+    if (t.periodoUs == 0)
+    {
+      t.estado = INACTIVO;
+      continue;
+    }
+    // Sigue la fase original; si el atraso paso un periodo entero, las
+    // activaciones perdidas no se recuperan en rafaga
+    uint32_t proxima = t.activacion + t.periodoUs;
+    while (!anterior(fin, proxima + t.periodoUs))
+    {
+      proxima += t.periodoUs;
+      e.omitidos++;
+    }
+    programar(id, proxima);
+  }
+  return corridos;
+}
+
+uint32_t Planificador::hastaProximo() const
+{
+  if (listos_.cantidad > 0)
+    return 0;
+  if (esperando_.cantidad == 0)
+    return UINT32_MAX;
+  int32_t falta = (int32_t)(trabajos_[esperando_.ids[0]].activacion - reloj_());
+  return falta > 0 ? (uint32_t)falta : 0;
+}
+
+void Planificador::reiniciarEstadisticas()
+{
+  for (uint8_t i = 0; i < cantidad_; i++)
+  {
+    EstadisticasTrabajo &e = trabajos_[i].estadisticas;
+    e.retraso.reiniciar();
+    e.duracion.reiniciar();
+    e.vencidos = 0;
+    e.excedidos = 0;
+    e.omitidos = 0;
+  }
+}
+
+// --- Monticulos de ids ---
+
+bool Planificador::antes(const Monticulo &m, uint8_t a, uint8_t b) const
+{
+  if (m.porPlazo)
+    return anterior(trabajos_[a].plazo, trabajos_[b].plazo);
+  return anterior(trabajos_[a].activacion, trabajos_[b].activacion);
+}
+
+void Planificador::subir(Monticulo &m, uint8_t pos)
+{
+  while (pos > 0)
+  {
+    uint8_t padre = (pos - 1) / 2;
+    if (!antes(m, m.ids[pos], m.ids[padre]))
+      break;
+    uint8_t id = m.ids[pos];
+    m.ids[pos] = m.ids[padre];
+    m.ids[padre] = id;
+    pos = padre;
+  }
+}
+
+void Planificador::bajar(Monticulo &m, uint8_t pos)
+{
+  while (true)
+  {
+    uint8_t menor = pos;
+    uint8_t izq = 2 * pos + 1;
+    uint8_t der = izq + 1;
+    if (izq < m.cantidad && antes(m, m.ids[izq], m.ids[menor]))
+      menor = izq;
+    if (der < m.cantidad && antes(m, m.ids[der], m.ids[menor]))
+      menor = der;
+    if (menor == pos)
+      return;
+    uint8_t id = m.ids[pos];
+    m.ids[pos] = m.ids[menor];
+    m.ids[menor] = id;
+    pos = menor;
+  }
+}
+
+void Planificador::insertar(Monticulo &m, uint8_t id)
+{
+  m.ids[m.cantidad] = id;
+  subir(m, m.cantidad++);
+}
+
+uint8_t Planificador::extraer(Monticulo &m)
+{
+  uint8_t id = m.ids[0];
+  m.ids[0] = m.ids[--m.cantidad];
+  bajar(m, 0);
+  return id;
+}
+
+void Planificador::quitar(Monticulo &m, uint8_t id)
+{
+  for (uint8_t pos = 0; pos < m.cantidad; pos++)
+  {
+    if (m.ids[pos] != id)
+      continue;
+    m.ids[pos] = m.ids[--m.cantidad];
+    if (pos < m.cantidad)
+    {
+      subir(m, pos);
+      bajar(m, pos);
+    }
+    return;
+  }
+}
@@ -0,0 +1,695 @@
+#include "registro_datos.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "crc.h"
+
+static const uint32_t MAGIA_REGISTRO = 0x474F4C52; // "RLOG"
+static const uint16_t VERSION_REGISTRO = 2;
+static const uint32_t TAM_SECTOR = MemoriaFlash::TAM_SECTOR;
+static const uint32_t SIN_MARCA = UINT32_MAX;
+
+enum FormatoLote : uint8_t
+{
+  LOTE_INVALIDO = 0, // Marca de cierre: nada de aca en adelante es valido
+  LOTE_DELTA = 1     // Bloque de CodificadorBloque
+};
+
+static void resumenVacio(ResumenLecturas &r)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    r.minQ4[i] = INT16_MAX;
+    r.maxQ4[i] = INT16_MIN;
+  }
+}
+
+static void incluirRango(ResumenLecturas &r, const int16_t minQ4[2], const int16_t maxQ4[2])
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (minQ4[i] < r.minQ4[i])
+      r.minQ4[i] = minQ4[i];
+    if (maxQ4[i] > r.maxQ4[i])
+      r.maxQ4[i] = maxQ4[i];
+  }
+}
+
+static void incluirLectura(ResumenLecturas &r, const Lectura &l)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (l.tempQ4[i] == TEMP_Q4_ERROR)
+      continue;
+    if (l.tempQ4[i] < r.minQ4[i])
+      r.minQ4[i] = l.tempQ4[i];
+    if (l.tempQ4[i] > r.maxQ4[i])
+      r.maxQ4[i] = l.tempQ4[i];
+  }
+}
+
+RegistroDatos::RegistroDatos(MemoriaFlash &flash, RelojMicros reloj)
+    : flash_(flash), reloj_(reloj), listo_(false), segmentos_(0), cabeza_(0), cola_(0), posicion_(0),
+      secuencia_(0), sellado_(false), siguientePreparado_(false), proximoIndice_(0), ultimaMarca_(0),
+      cursorSegmento_(0), cursorPos_(0), cursorIndice_(0), cursorValido_(false)
+{
+  memset(&estadisticas_, 0, sizeof(estadisticas_));
+  codificador_.iniciar(lote_ + sizeof(CabeceraLote), MAX_DATOS_LOTE);
+  resumenVacio(resumenLote_);
+}
+
+bool RegistroDatos::leerCabecera(uint16_t segmento, CabeceraSegmento &cab)
+{
+  return flash_.leer(direccion(segmento, 0), &cab, sizeof(cab)) && cab.magia == MAGIA_REGISTRO &&
+         cab.version == VERSION_REGISTRO && cab.crc == crc16(&cab, offsetof(CabeceraSegmento, crc));
+}
+
+bool RegistroDatos::leerCabeceraLote(uint16_t segmento, uint32_t pos, CabeceraLote &cab, uint32_t &primeraMarca)
+{
+  uint8_t crudo[sizeof(CabeceraLote) + 4];
+  if (pos + sizeof(crudo) > TAM_SECTOR || !flash_.leer(direccion(segmento, pos), crudo, sizeof(crudo)))
+    return false;
+  memcpy(&cab, crudo, sizeof(cab));
+  estadisticas_.cabecerasLeidas++;
+  if (cab.formato != LOTE_DELTA || cab.cantidad == 0 || cab.cantidad > LECTURAS_POR_LOTE ||
+      cab.largo < CodificadorBloque::BITS_PRIMERA / 8 || cab.largo > MAX_DATOS_LOTE ||
+      pos + sizeof(cab) + cab.largo > TAM_SECTOR)
+    return false;
+  primeraMarca = DecodificadorBloque::marcaInicial(crudo + sizeof(cab));
+  return true;
+}
+
+bool RegistroDatos::leerDatosLote(uint16_t segmento, uint32_t pos, const CabeceraLote &cab, uint8_t *datos)
+{
+  if (!flash_.leer(direccion(segmento, pos + sizeof(cab)), datos, cab.largo))
+    return false;
+  return cab.crc == crc16(datos, cab.largo, crc16(&cab, offsetof(CabeceraLote, crc)));
+}
+
+// Copia hasta max lecturas del lote a partir de la numero 'desde'
+size_t RegistroDatos::decodificarLote(uint16_t segmento, uint32_t pos, const CabeceraLote &cab, size_t desde,
+                                      Lectura *out, size_t max)
+{
+  uint8_t datos[MAX_DATOS_LOTE];
+  if (!leerDatosLote(segmento, pos, cab, datos))
+    return 0;
+  estadisticas_.lotesDecodificados++;
+
+  DecodificadorBloque bloque(datos, cab.largo, cab.cantidad);
+  Lectura l;
+  size_t n = 0;
+  for (size_t i = 0; n < max && bloque.siguiente(l); i++)
+  {
+    if (i >= desde)
+      out[n++] = l;
+  }
+  return n;
+}
+
+size_t RegistroDatos::decodificarPendientes(size_t desde, Lectura *out, size_t max) const
+{
+  DecodificadorBloque bloque(lote_ + sizeof(CabeceraLote), codificador_.bytes(), codificador_.cantidad());
+  Lectura l;
+  size_t n = 0;
+  for (size_t i = 0; n < max && bloque.siguiente(l); i++)
+  {
+    if (i >= desde)
+      out[n++] = l;
+  }
+  return n;
+}
+
+// Avanza lote por lote armando el resumen del segmento. Con 'verificar' se
+// comprueba el CRC de cada lote y que despues del ultimo este todo borrado;
+// devuelve false si no (pos queda donde termina lo valido).
+bool RegistroDatos::recorrerSegmento(uint16_t segmento, bool verificar, uint32_t &pos, uint32_t &cantidad,
+                                     uint32_t &posUltimo)
+{
+  ResumenSegmento &r = resumenes_[segmento];
+  r.primeraMarca = SIN_MARCA;
+  resumenVacio(r.lecturas);
+
+  uint8_t datos[MAX_DATOS_LOTE];
+  pos = sizeof(CabeceraSegmento);
+  cantidad = 0;
+  posUltimo = pos;
+  while (true)
+  {
+    CabeceraLote cab;
+    uint32_t marca;
+    if (!leerCabeceraLote(segmento, pos, cab, marca))
+      return !verificar || restoBorrado(segmento, pos);
+    if (verificar && !leerDatosLote(segmento, pos, cab, datos))
+      return false;
+
+    if (cantidad == 0)
+      r.primeraMarca = marca;
+    incluirRango(r.lecturas, cab.minQ4, cab.maxQ4);
+    cantidad += cab.cantidad;
+    posUltimo = pos;
+    pos += sizeof(cab) + cab.largo;
+  }
+}
+
+bool RegistroDatos::restoBorrado(uint16_t segmento, uint32_t pos)
+{
+  uint8_t bloque[64];
+  while (pos < TAM_SECTOR)
+  {
+    size_t n = TAM_SECTOR - pos < sizeof(bloque) ? TAM_SECTOR - pos : sizeof(bloque);
+    if (!flash_.leer(direccion(segmento, pos), bloque, n))
+      return false;
+    for (size_t i = 0; i < n; i++)
+    {
+      if (bloque[i] != 0xFF)
+        return false;
+    }
+    pos += n;
+  }
+  return true;
+}
+
+// Deja constancia en flash de que el segmento termina en pos: el formato en
+// 0 corta cualquier recorrido de cabeceras sin tener que leer los datos.
+void RegistroDatos::cerrarEn(uint16_t segmento, uint32_t pos)
+{
+  uint8_t invalido = LOTE_INVALIDO;
+  if (pos + offsetof(CabeceraLote, formato) < TAM_SECTOR)
+    flash_.escribir(direccion(segmento, pos + offsetof(CabeceraLote, formato)), &invalido, 1);
+  sellado_ = true;
+}
+
+uint16_t RegistroDatos::segmentoDe(uint32_t indice) const
+{
+  // El ultimo segmento (en orden de escritura) que empieza en o antes del indice
+  uint16_t bajo = 0;
+  uint16_t alto = cantidadSegmentos() - 1;
+  while (bajo < alto)
+  {
+    uint16_t medio = (bajo + alto + 1) / 2;
+    if (resumenes_[segmentoEn(medio)].primerIndice <= indice)
+      bajo = medio;
+    else
+      alto = medio - 1;
+  }
+  return segmentoEn(bajo);
+}
+
+bool RegistroDatos::begin()
+{
+  listo_ = false;
+  codificador_.iniciar(lote_ + sizeof(CabeceraLote), MAX_DATOS_LOTE);
+  resumenVacio(resumenLote_);
+  piramide_.reiniciar();
+  cursorValido_ = false;
+  uint32_t sectores = flash_.tamano() / TAM_SECTOR;
+  segmentos_ = sectores < MAX_SEGMENTOS ? sectores : MAX_SEGMENTOS;
+  if (segmentos_ < 3)
+    return false;
+
+  // La cabeza es el segmento valido con la secuencia mas alta
+  CabeceraSegmento cab;
+  bool hay = false;
+  for (uint16_t i = 0; i < segmentos_; i++)
+  {
+    if (leerCabecera(i, cab) && (!hay || cab.secuencia > secuencia_))
+    {
+      hay = true;
+      secuencia_ = cab.secuencia;
+      cabeza_ = i;
+      resumenes_[i].primerIndice = cab.primerIndice;
+    }
+  }
+
+  if (!hay)
+  {
+    // Flash vacia o con otro contenido: se empieza de cero
+    proximoIndice_ = 0;
+    ultimaMarca_ = 0;
+    siguientePreparado_ = false;
+    if (!flash_.borrarSector(direccion(0, 0)) || !abrirSegmento(0, 1))
+      return false;
+    estadisticas_.borrados++;
+    cola_ = 0;
+    listo_ = true;
+    return true;
+  }
+
+  // Hacia atras mientras las secuencias sean consecutivas
+  cola_ = cabeza_;
+  for (uint16_t k = 1; k < segmentos_; k++)
+  {
+    uint16_t s = (cabeza_ + segmentos_ - k) % segmentos_;
+    if (!leerCabecera(s, cab) || cab.secuencia != secuencia_ - k || cab.primerIndice > resumenes_[cola_].primerIndice)
+      break;
+    resumenes_[s].primerIndice = cab.primerIndice;
+    cola_ = s;
+  }
+
+  // Indice: solo cabeceras de lote, salvo el segmento activo que se verifica
+  uint32_t pos, cantidad, posUltimo;
+  uint16_t segUltimo = cabeza_;
+  uint32_t posLoteUltimo = 0;
+  bool hayLotes = false;
+  uint16_t total = cantidadSegmentos();
+  for (uint16_t k = 0; k + 1 < total; k++)
+  {
+    uint16_t s = segmentoEn(k);
+    recorrerSegmento(s, false, pos, cantidad, posUltimo);
+    if (cantidad > 0)
+    {
+      segUltimo = s;
+      posLoteUltimo = posUltimo;
+      hayLotes = true;
+    }
+  }
+
+  bool completo = recorrerSegmento(cabeza_, true, posicion_, cantidad, posUltimo);
+  sellado_ = false;
+  if (!completo)
+  {
+    cerrarEn(cabeza_, posicion_);
+    estadisticas_.sellados++;
+  }
+  proximoIndice_ = resumenes_[cabeza_].primerIndice + cantidad;
+  if (cantidad > 0)
+  {
+    segUltimo = cabeza_;
+    posLoteUltimo = posUltimo;
+    hayLotes = true;
+  }
+
+  // Un segmento sin lotes toma la primera marca del siguiente con datos,
+  // asi las marcas del indice quedan ordenadas para la busqueda binaria.
+  uint32_t siguienteMarca = SIN_MARCA;
+  for (uint16_t k = total; k-- > 0;)
+  {
+    ResumenSegmento &r = resumenes_[segmentoEn(k)];
+    if (r.primeraMarca == SIN_MARCA)
+      r.primeraMarca = siguienteMarca;
+    else
+      siguienteMarca = r.primeraMarca;
+  }
+
+  ultimaMarca_ = 0;
+  CabeceraLote lote;
+  uint32_t marca;
+  Lectura ultima;
+  if (hayLotes && leerCabeceraLote(segUltimo, posLoteUltimo, lote, marca) &&
+      decodificarLote(segUltimo, posLoteUltimo, lote, lote.cantidad - 1, &ultima, 1))
+    ultimaMarca_ = ultima.t;
+
+  uint16_t siguiente = (cabeza_ + 1) % segmentos_;
+  siguientePreparado_ = siguiente != cola_ && restoBorrado(siguiente, 0);
+  listo_ = true;
+
+  // Los resumenes se rearman con lo que quedo en flash
+  uint32_t retencion = PiramideResumen::retencion();
+  Lectura lecturas[LECTURAS_POR_LOTE];
+  for (uint32_t i = buscarMarca(ultimaMarca_ > retencion ? ultimaMarca_ - retencion : 0); i < proximoIndice_;)
+  {
+    size_t n = leer(i, lecturas, LECTURAS_POR_LOTE);
+    if (n == 0)
+      break;
+    for (size_t k = 0; k < n; k++)
+      piramide_.agregar(lecturas[k]);
+    i += n;
+  }
+  return true;
+}
+
+bool RegistroDatos::abrirSegmento(uint16_t segmento, uint32_t secuencia)
+{
+  CabeceraSegmento cab;
+  cab.magia = MAGIA_REGISTRO;
+  cab.secuencia = secuencia;
+  cab.primerIndice = proximoIndice_;
+  cab.version = VERSION_REGISTRO;
+  cab.crc = crc16(&cab, offsetof(CabeceraSegmento, crc));
+  if (!flash_.escribir(direccion(segmento, 0), &cab, sizeof(cab)))
+    return false;
+
+  estadisticas_.bytesEscritos += sizeof(cab);
+  ResumenSegmento &r = resumenes_[segmento];
+  r.primerIndice = proximoIndice_;
+  r.primeraMarca = SIN_MARCA;
+  resumenVacio(r.lecturas);
+  cabeza_ = segmento;
+  secuencia_ = secuencia;
+  posicion_ = sizeof(cab);
+  sellado_ = false;
+  return true;
+}
+
+bool RegistroDatos::rotar()
+{
+  uint16_t siguiente = (cabeza_ + 1) % segmentos_;
+  if (!siguientePreparado_)
+  {
+    // Registro lleno: se pierde el segmento mas viejo
+    if (siguiente == cola_)
+      cola_ = (cola_ + 1) % segmentos_;
+    if (cursorSegmento_ == siguiente)
+      cursorValido_ = false;
+    if (!flash_.borrarSector(direccion(siguiente, 0)))
+    {
+      // El activo ya no tiene lugar: queda sellado y se reintenta en el
+      // proximo lote (o en mantenimiento())
+      sellado_ = true;
+      return false;
+    }
+    estadisticas_.borrados++;
+    estadisticas_.borradosEnLinea++;
+  }
+  siguientePreparado_ = false;
+  if (!abrirSegmento(siguiente, secuencia_ + 1))
+  {
+    sellado_ = true;
+    return false;
+  }
+  return true;
+}
+
+void RegistroDatos::mantenimiento()
+{
+  if (!listo_ || siguientePreparado_)
+    return;
+  uint16_t siguiente = (cabeza_ + 1) % segmentos_;
+  if (siguiente == cola_)
+    cola_ = (cola_ + 1) % segmentos_;
+  if (cursorSegmento_ == siguiente)
+    cursorValido_ = false;
+  if (flash_.borrarSector(direccion(siguiente, 0)))
+  {
+    estadisticas_.borrados++;
+    siguientePreparado_ = true;
+  }
+}
+
+void RegistroDatos::agregar(const Lectura &l)
+{
+  if (!listo_)
+    return;
+  Lectura p = l;
+  if (p.t < ultimaMarca_)
+    p.t = ultimaMarca_;
+  ultimaMarca_ = p.t;
+  codificador_.agregar(p); // El bloque tiene lugar para el peor caso
+  incluirLectura(resumenLote_, p);
+  piramide_.agregar(p);
+  if (codificador_.cantidad() >= LECTURAS_POR_LOTE)
+    vaciar();
+}
+
+void RegistroDatos::vaciar()
+{
+  uint16_t cantidad = codificador_.cantidad();
+  if (!listo_ || cantidad == 0)
+    return;
+  uint32_t inicio = reloj_();
+
+  CabeceraLote cab;
+  cab.largo = codificador_.bytes();
+  cab.cantidad = cantidad;
+  cab.formato = LOTE_DELTA;
+  memcpy(cab.minQ4, resumenLote_.minQ4, sizeof(cab.minQ4));
+  memcpy(cab.maxQ4, resumenLote_.maxQ4, sizeof(cab.maxQ4));
+  cab.crc = crc16(lote_ + sizeof(cab), cab.largo, crc16(&cab, offsetof(CabeceraLote, crc)));
+  memcpy(lote_, &cab, sizeof(cab));
+  size_t total = sizeof(cab) + cab.largo;
+
+  // Nunca se escribe pasando el fin del sector: si no se pudo rotar el lote
+  // se descarta
+  bool lugar = !sellado_ && posicion_ + total <= TAM_SECTOR;
+  if (!lugar)
+    lugar = rotar();
+  if (lugar && flash_.escribir(direccion(cabeza_, posicion_), lote_, total))
+  {
+    ResumenSegmento &r = resumenes_[cabeza_];
+    if (r.primeraMarca == SIN_MARCA)
+    {
+      r.primeraMarca = DecodificadorBloque::marcaInicial(lote_ + sizeof(cab));
+      // Segmentos previos que quedaron sin lotes (cerrados por un corte)
+      for (uint16_t s = cabeza_; s != cola_;)
+      {
+        s = (s + segmentos_ - 1) % segmentos_;
+        if (resumenes_[s].primeraMarca != SIN_MARCA)
+          break;
+        resumenes_[s].primeraMarca = r.primeraMarca;
+      }
+    }
+    incluirRango(r.lecturas, cab.minQ4, cab.maxQ4);
+    posicion_ += total;
+    proximoIndice_ += cantidad;
+    estadisticas_.lotes++;
+    estadisticas_.bytesEscritos += total;
+  }
+  else
+  {
+    // Un lote que fallo a medias queda con CRC invalido: el segmento se cierra
+    if (!sellado_)
+      cerrarEn(cabeza_, posicion_);
+    estadisticas_.errores++;
+  }
+  codificador_.iniciar(lote_ + sizeof(CabeceraLote), MAX_DATOS_LOTE);
+  resumenVacio(resumenLote_);
+
+  uint32_t us = reloj_() - inicio;
+  estadisticas_.ultimaEscrituraUs = us;
+  if (us > estadisticas_.peorEscrituraUs)
+    estadisticas_.peorEscrituraUs = us;
+}
+
+size_t RegistroDatos::leer(uint32_t indice, Lectura *out, size_t max)
+{
+  if (!listo_ || indice < inicio() || indice >= fin() || max == 0)
+    return 0;
+  if (indice >= proximoIndice_)
+    return decodificarPendientes(indice - proximoIndice_, out, max);
+
+  uint16_t s = segmentoDe(indice);
+  uint32_t pos = sizeof(CabeceraSegmento);
+  uint32_t base = resumenes_[s].primerIndice;
+  if (cursorValido_ && cursorSegmento_ == s && cursorIndice_ <= indice)
+  {
+    pos = cursorPos_;
+    base = cursorIndice_;
+  }
+
+  CabeceraLote cab;
+  uint32_t marca;
+  while (leerCabeceraLote(s, pos, cab, marca))
+  {
+    if (indice < base + cab.cantidad)
+    {
+      cursorSegmento_ = s;
+      cursorPos_ = pos;
+      cursorIndice_ = base;
+      cursorValido_ = true;
+      return decodificarLote(s, pos, cab, indice - base, out, max);
+    }
+    base += cab.cantidad;
+    pos += sizeof(cab) + cab.largo;
+  }
+  return 0;
+}
+
+uint32_t RegistroDatos::buscarMarca(uint32_t t)
+{
+  uint32_t indice = buscarMarcaFlash(t);
+  if (indice < proximoIndice_ || codificador_.cantidad() == 0)
+    return indice;
+
+  // Todo lo de flash es anterior a t: sigue en el lote en RAM
+  if (t > ultimaMarca_)
+    return fin();
+  Lectura lecturas[LECTURAS_POR_LOTE];
+  size_t n = decodificarPendientes(0, lecturas, LECTURAS_POR_LOTE);
+  for (size_t i = 0; i < n; i++)
+  {
+    if (lecturas[i].t >= t)
+      return proximoIndice_ + i;
+  }
+  return proximoIndice_ + n;
+}
+
+// Primer indice en flash con marca >= t (proximoIndice_ si no hay ninguno)
+uint32_t RegistroDatos::buscarMarcaFlash(uint32_t t)
+{
+  if (!listo_ || inicio() >= proximoIndice_)
+    return proximoIndice_;
+  if (resumenes_[cola_].primeraMarca >= t)
+    return inicio();
+
+  // Ultimo segmento cuya primera marca es anterior a t
+  uint16_t bajo = 0;
+  uint16_t alto = cantidadSegmentos() - 1;
+  while (bajo < alto)
+  {
+    uint16_t medio = (bajo + alto + 1) / 2;
+    if (resumenes_[segmentoEn(medio)].primeraMarca < t)
+      bajo = medio;
+    else
+      alto = medio - 1;
+  }
+  uint16_t s = segmentoEn(bajo);
+
+  // Dentro del segmento: el ultimo lote que empieza antes de t
+  uint32_t pos = sizeof(CabeceraSegmento);
+  uint32_t base = resumenes_[s].primerIndice;
+  CabeceraLote cab, candidato;
+  uint32_t marca, posCandidato = 0, baseCandidato = base;
+  bool hayCandidato = false;
+  while (leerCabeceraLote(s, pos, cab, marca) && marca < t)
+  {
+    candidato = cab;
+    posCandidato = pos;
+    baseCandidato = base;
+    hayCandidato = true;
+    base += cab.cantidad;
+    pos += sizeof(cab) + cab.largo;
+  }
+  if (!hayCandidato)
+    return base;
+
+  Lectura lecturas[LECTURAS_POR_LOTE];
+  size_t n = decodificarLote(s, posCandidato, candidato, 0, lecturas, candidato.cantidad);
+  for (size_t i = 0; i < n; i++)
+  {
+    if (lecturas[i].t >= t)
+      return baseCandidato + i;
+  }
+  return baseCandidato + candidato.cantidad;
+}
+
+void RegistroDatos::resumir(uint32_t desde, uint32_t hasta, ResumenLecturas &r)
+{
+  resumenVacio(r);
+  if (!listo_)
+    return;
+  if (desde < inicio())
+    desde = inicio();
+  if (hasta > fin())
+    hasta = fin();
+  if (desde >= hasta)
+    return;
+
+  // Lo que esta en el lote en RAM: entero sale de su resumen
+  if (hasta > proximoIndice_)
+  {
+    if (desde <= proximoIndice_ && hasta == fin())
+    {
+      incluirRango(r, resumenLote_.minQ4, resumenLote_.maxQ4);
+    }
+    else
+    {
+      Lectura lecturas[LECTURAS_POR_LOTE];
+      uint32_t primera = desde > proximoIndice_ ? desde : proximoIndice_;
+      size_t n = decodificarPendientes(primera - proximoIndice_, lecturas, hasta - primera);
+      for (size_t i = 0; i < n; i++)
+        incluirLectura(r, lecturas[i]);
+    }
+    hasta = proximoIndice_;
+    if (desde >= hasta)
+      return;
+  }
+
+  for (uint16_t s = segmentoDe(desde);; s = (s + 1) % segmentos_)
+  {
+    const ResumenSegmento &rs = resumenes_[s];
+    uint32_t finSegmento = s == cabeza_ ? proximoIndice_ : resumenes_[(s + 1) % segmentos_].primerIndice;
+    if (desde <= rs.primerIndice && finSegmento <= hasta)
+    {
+      incluirRango(r, rs.lecturas.minQ4, rs.lecturas.maxQ4);
+    }
+    else
+    {
+      uint32_t pos = sizeof(CabeceraSegmento);
+      uint32_t base = rs.primerIndice;
+      CabeceraLote cab;
+      uint32_t marca;
+      while (base < hasta && leerCabeceraLote(s, pos, cab, marca))
+      {
+        uint32_t finLote = base + cab.cantidad;
+        if (desde <= base && finLote <= hasta)
+        {
+          incluirRango(r, cab.minQ4, cab.maxQ4);
+        }
+        else if (finLote > desde)
+        {
+          // Lote de un borde: solo las lecturas dentro del rango
+          Lectura lecturas[LECTURAS_POR_LOTE];
+          size_t n = decodificarLote(s, pos, cab, 0, lecturas, cab.cantidad);
+          for (size_t i = 0; i < n; i++)
+          {
+            if (base + i >= desde && base + i < hasta)
+              incluirLectura(r, lecturas[i]);
+          }
+        }
+        base = finLote;
+        pos += sizeof(cab) + cab.largo;
+      }
+    }
+    if (finSegmento >= hasta || s == cabeza_)
+      break;
+  }
+}
+
+size_t RegistroDatos::serie(uint32_t desde, uint32_t hasta, Agregado *out, size_t maxPuntos, uint8_t &nivel)
+{
+  nivel = 0;
+  if (!listo_ || hasta <= desde || maxPuntos == 0)
+    return 0;
+
+  // Del mas grueso al mas fino, el primero que cubre desde el principio y da
+  // los puntos pedidos. Si ninguno, el que mas tenga entre los que cubren.
+  bool elegido = false, mejorCubre = false;
+  uint32_t mejor = 0;
+  uint16_t primero = 0;
+  for (uint8_t n = PiramideResumen::NIVELES; n-- > 0 && !elegido;)
+  {
+    uint16_t desdePos = piramide_.buscar(n, desde);
+    uint16_t cantidad = piramide_.buscar(n, hasta) - desdePos;
+    bool cubre = piramide_.cubre(n, desde);
+    elegido = cubre && cantidad >= maxPuntos;
+    if (elegido || cubre > mejorCubre || (cubre == mejorCubre && cantidad > mejor))
+    {
+      mejor = cantidad;
+      mejorCubre = cubre;
+      nivel = n + 1;
+      primero = desdePos;
+    }
+  }
+
+  uint32_t primeraLectura = 0, ultimaLectura = 0;
+  if (!elegido)
+  {
+    primeraLectura = buscarMarca(desde);
+    ultimaLectura = buscarMarca(hasta);
+    uint32_t cantidad = ultimaLectura - primeraLectura;
+    bool cubre = inicio() == 0 || resumenes_[cola_].primeraMarca <= desde;
+    if ((cubre && cantidad >= maxPuntos) || cubre > mejorCubre || (cubre == mejorCubre && cantidad > mejor))
+      nivel = 0;
+  }
+
+  ReductorSerie reductor(desde, (hasta - desde - 1) / maxPuntos + 1, out, maxPuntos);
+  if (nivel > 0)
+  {
+    uint16_t fin = piramide_.buscar(nivel - 1, hasta);
+    for (uint16_t i = primero; i < fin; i++)
+      reductor.sumar(piramide_.en(nivel - 1, i));
+    return reductor.terminar();
+  }
+
+  Lectura lecturas[LECTURAS_POR_LOTE];
+  for (uint32_t i = primeraLectura; i < ultimaLectura;)
+  {
+    size_t n = leer(i, lecturas, ultimaLectura - i < LECTURAS_POR_LOTE ? ultimaLectura - i : LECTURAS_POR_LOTE);
+    if (n == 0)
+      break;
+    for (size_t k = 0; k < n; k++)
+      reductor.sumar(lecturas[k]);
+    i += n;
+  }
+  return reductor.terminar();
+}
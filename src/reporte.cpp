@@ -0,0 +1,94 @@
+#include "reporte.h"
+
+EscritorTexto &EscritorTexto::caracter(char c)
+{
+  if (len_ + 1 < cap_)
+  {
+    buf_[len_++] = c;
+    buf_[len_] = '\0';
+  }
+  return *this;
+}
+
+EscritorTexto &EscritorTexto::texto(const char *s)
+{
+  while (*s)
+    caracter(*s++);
+  return *this;
+}
+
+EscritorTexto &EscritorTexto::entero(uint32_t v)
+{
+  char digitos[10];
+  uint8_t n = 0;
+  do
+  {
+    digitos[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n)
+    caracter(digitos[--n]);
+  return *this;
+}
+
+// Empates x.25/x.75 que dtostrf saca hacia arriba, un bit por empate desde
+// 0.25 (bit 0 de EMPATES_ARRIBA[0]). Suma 0.05 y extrae digito a digito en
+// double, asi que el resultado depende del error de punto flotante de cada
+// valor y no sigue ninguna regla aritmetica. Cubre |t| < 128 C, que incluye
+// todo el rango del DS18B20; sale de dtostrfArduino() en test_reporte.
+static const uint8_t EMPATES_ARRIBA[32] = {
+    0x0F, 0x00, 0xFF, 0xDE, 0xFB, 0x6B, 0xAD, 0xBD, 0x00, 0x00, 0x42, 0x08, 0x21, 0x84, 0x10, 0x42,
+    0x08, 0x21, 0x84, 0x10, 0x52, 0x4A, 0x29, 0xA5, 0x94, 0xAA, 0xAA, 0x02, 0x54, 0x55, 0x05, 0xA8,
+};
+
+uint32_t q4ADecimasReporte(int16_t q4, bool &negativo)
+{
+  negativo = q4 < 0;
+  uint32_t absoluto = negativo ? (uint32_t)(-(int32_t)q4) : (uint32_t)q4;
+
+  // Decimas = absoluto * 10 / 16 = absoluto * 5 / 8. Solo hay empate con
+  // resto 4/8 (x.25 y x.75); fuera de la tabla se redondea hacia arriba.
+  uint32_t octavos = absoluto * 5;
+  uint32_t decimas = octavos / 8;
+  uint32_t resto = octavos % 8;
+  if (resto > 4)
+    decimas++;
+  else if (resto == 4)
+  {
+    uint32_t empate = (absoluto / 16) * 2 + (absoluto % 16 == 12);
+    if (empate >= sizeof(EMPATES_ARRIBA) * 8 || (EMPATES_ARRIBA[empate / 8] >> (empate % 8)) & 1)
+      decimas++;
+  }
+  return decimas;
+}
+
+EscritorTexto &EscritorTexto::celsiusQ4(int16_t q4)
+{
+  bool negativo;
+  uint32_t decimas = q4ADecimasReporte(q4, negativo);
+  if (negativo)
+    caracter('-');
+  entero(decimas / 10);
+  caracter('.');
+  return caracter((char)('0' + decimas % 10));
+}
+
+size_t formatearReporte(char *buf, size_t cap, const DatosReporte &d)
+{
+  EscritorTexto w(buf, cap);
+  w.texto("\n--- REPORTE ESP32 ---\n");
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    w.texto(i == 0 ? "S1: " : "S2: ");
+    if (d.valida[i])
+      w.celsiusQ4(d.tempQ4[i]).caracter('C');
+    else
+      w.texto("ERR");
+    w.texto(i == 0 ? " | " : "\n");
+  }
+  w.texto("Reles: K1=").texto(d.k1 ? "ON" : "OFF").texto(" K2=").texto(d.k2 ? "ON" : "OFF").caracter('\n');
+  w.texto("Tactil: ").texto(d.sistema ? "ENCENDIDO" : "APAGADO").caracter('\n');
+  w.texto("Pantalla: ").texto(d.pantalla ? "ON" : "SLEEP").caracter('\n');
+  w.texto("---------------------\n");
+  return w.largo();
+}
@@ -0,0 +1,185 @@
+#include "telemetria.h"
+
+#include <math.h>
+#include "crc.h"
+
+int16_t celsiusAQ4(float celsius)
+{
+  long q4 = lroundf(celsius * 16.0f);
+  if (q4 <= INT16_MIN || q4 > INT16_MAX)
+    return TEMP_Q4_ERROR;
+  return (int16_t)q4;
+}
+
+int16_t q4ADecimas(int16_t q4)
+{
+  return (int16_t)(((int32_t)q4 * 10 + (q4 < 0 ? -8 : 8)) / 16);
+}
+
+static void escribirU16(uint8_t *out, uint16_t v)
+{
+  out[0] = (uint8_t)v;
+  out[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t leerU16(const uint8_t *in)
+{
+  return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+// Muestra y Lectura comparten formato: marca(u32) + t1 + t2 + banderas
+static size_t empaquetarRegistro(uint32_t marca, const int16_t tempQ4[2], uint8_t banderas, uint8_t *out)
+{
+  escribirU16(out, (uint16_t)marca);
+  escribirU16(out + 2, (uint16_t)(marca >> 16));
+  escribirU16(out + 4, (uint16_t)tempQ4[0]);
+  escribirU16(out + 6, (uint16_t)tempQ4[1]);
+  out[8] = banderas;
+  return MUESTRA_BYTES;
+}
+
+static void desempaquetarRegistro(const uint8_t *in, uint32_t &marca, int16_t tempQ4[2], uint8_t &banderas)
+{
+  marca = leerU16(in) | ((uint32_t)leerU16(in + 2) << 16);
+  tempQ4[0] = (int16_t)leerU16(in + 4);
+  tempQ4[1] = (int16_t)leerU16(in + 6);
+  banderas = in[8];
+}
+
+size_t empaquetarMuestra(const Muestra &m, uint8_t *out)
+{
+  return empaquetarRegistro(m.ms, m.tempQ4, m.banderas, out);
+}
+
+void desempaquetarMuestra(const uint8_t *in, Muestra &m)
+{
+  desempaquetarRegistro(in, m.ms, m.tempQ4, m.banderas);
+}
+
+size_t empaquetarLectura(const Lectura &l, uint8_t *out)
+{
+  return empaquetarRegistro(l.t, l.tempQ4, l.banderas, out);
+}
+
+void desempaquetarLectura(const uint8_t *in, Lectura &l)
+{
+  desempaquetarRegistro(in, l.t, l.tempQ4, l.banderas);
+}
+
+size_t empaquetarEstado(const Muestra &m, uint8_t modo, const int16_t consigna[2], uint8_t *out)
+{
+  size_t n = empaquetarMuestra(m, out);
+  out[n++] = modo;
+  escribirU16(out + n, (uint16_t)consigna[0]);
+  escribirU16(out + n + 2, (uint16_t)consigna[1]);
+  return n + 4;
+}
+
+size_t empaquetarCabeceraHist(uint16_t indice, uint32_t offset, uint8_t *out)
+{
+  escribirU16(out, indice);
+  escribirU16(out + 2, (uint16_t)offset);
+  escribirU16(out + 4, (uint16_t)(offset >> 16));
+  return HIST_CABECERA_BYTES;
+}
+
+// --- COBS ---
+
+size_t cobsCodificar(const uint8_t *in, size_t n, uint8_t *out)
+{
+  size_t escrito = 1;
+  size_t posCodigo = 0;
+  uint8_t codigo = 1;
+
+  for (size_t i = 0; i < n; i++)
+  {
+    if (in[i] == 0)
+    {
+      out[posCodigo] = codigo;
+      posCodigo = escrito++;
+      codigo = 1;
+      continue;
+    }
+    out[escrito++] = in[i];
+    if (++codigo == 0xFF)
+    {
+      out[posCodigo] = codigo;
+      posCodigo = escrito++;
+      codigo = 1;
+    }
+  }
+  out[posCodigo] = codigo;
+  return escrito;
+}
+
+size_t cobsDecodificar(const uint8_t *in, size_t n, uint8_t *out)
+{
+  size_t leido = 0;
+  size_t escrito = 0;
+
+  while (leido < n)
+  {
+    uint8_t codigo = in[leido++];
+    if (codigo == 0 || leido + codigo - 1 > n)
+      return 0;
+    for (uint8_t i = 1; i < codigo; i++)
+    {
+      if (in[leido] == 0)
+        return 0;
+      out[escrito++] = in[leido++];
+    }
+    // Un bloque corto implica un cero, salvo al final de la trama
+    if (codigo != 0xFF && leido < n)
+      out[escrito++] = 0;
+  }
+  return escrito;
+}
+
+// --- Tramas ---
+
+size_t CodificadorTramas::codificar(uint8_t tipo, const uint8_t *carga, size_t len, uint8_t *out)
+{
+  if (len > MAX_CARGA_TRAMA)
+    return 0;
+
+  uint8_t plano[2 + MAX_CARGA_TRAMA + 2];
+  plano[0] = tipo;
+  plano[1] = secuencia_++;
+  for (size_t i = 0; i < len; i++)
+    plano[2 + i] = carga[i];
+  escribirU16(plano + 2 + len, crc16(plano, 2 + len));
+
+  size_t n = cobsCodificar(plano, len + 4, out);
+  out[n++] = 0x00;
+  return n;
+}
+
+bool DecodificadorTramas::consumir(uint8_t b)
+{
+  if (b != 0x00)
+  {
+    if (len_ < sizeof(crudo_))
+      crudo_[len_++] = b;
+    else
+      len_ = sizeof(crudo_) + 1; // Demasiado larga: se descarta al delimitador
+    return false;
+  }
+
+  size_t n = len_;
+  len_ = 0;
+  if (n == 0)
+    return false;
+  if (n > sizeof(crudo_))
+  {
+    descartadas_++;
+    return false;
+  }
+
+  largo_ = cobsDecodificar(crudo_, n, trama_);
+  if (largo_ < 4 || crc16(trama_, largo_ - 2) != leerU16(trama_ + largo_ - 2))
+  {
+    descartadas_++;
+    return false;
+  }
+  return true;
+}
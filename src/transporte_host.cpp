@@ -0,0 +1,195 @@
+#ifndef ARDUINO
+
+#include "transporte_host.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+TransporteHost::TransporteHost(Modo modo)
+    : modo_(modo), fd_(-1), fdCliente_(-1), conectado_(false), congestionado_(false), inicioEntrada_(0),
+      finEntrada_(0)
+{
+  rutaPty_[0] = '\0';
+}
+
+TransporteHost::~TransporteHost()
+{
+  detener();
+}
+
+bool TransporteHost::iniciar(const char *)
+{
+  if (modo_ != PTY)
+    return true; // El socketpair se crea en conectarCliente()
+
+  fd_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd_ < 0 || grantpt(fd_) != 0 || unlockpt(fd_) != 0)
+    return false;
+  strncpy(rutaPty_, ptsname(fd_), sizeof(rutaPty_) - 1);
+  rutaPty_[sizeof(rutaPty_) - 1] = '\0';
+
+  // Sin eco ni edicion de linea: bytes crudos como en el SPP
+  struct termios t;
+  tcgetattr(fd_, &t);
+  cfmakeraw(&t);
+  tcsetattr(fd_, TCSANOW, &t);
+
+  // Linux solo reporta POLLHUP en el master despues de que el esclavo se abrio
+  // y cerro una vez; sin esto se veria un cliente conectado desde el inicio.
+  int esclavo = open(rutaPty_, O_RDWR | O_NOCTTY);
+  if (esclavo >= 0)
+    close(esclavo);
+  return true;
+}
+
+void TransporteHost::detener()
+{
+  if (modo_ == PAR_SOCKETS)
+    desconectarCliente();
+  if (fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
+  conectado_ = false;
+}
+
+int TransporteHost::conectarCliente()
+{
+  if (modo_ != PAR_SOCKETS)
+    return -1;
+  desconectarCliente();
+
+  int par[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, par) != 0)
+    return -1;
+  fcntl(par[0], F_SETFL, O_NONBLOCK);
+  fd_ = par[0];
+  fdCliente_ = par[1];
+  inicioEntrada_ = finEntrada_ = 0;
+  conectado_ = true;
+  congestionado_ = false;
+  notificar(TRANSPORTE_CONECTADO);
+  return fdCliente_;
+}
+
+void TransporteHost::desconectarCliente()
+{
+  if (modo_ != PAR_SOCKETS || fdCliente_ < 0)
+    return;
+  close(fdCliente_);
+  fdCliente_ = -1;
+  sondear(); // El cierre se detecta como en un cliente remoto
+}
+
+void TransporteHost::marcarDesconectado()
+{
+  if (!conectado_)
+    return;
+  conectado_ = false;
+  congestionado_ = false;
+  inicioEntrada_ = finEntrada_ = 0;
+  if (modo_ == PAR_SOCKETS && fd_ >= 0)
+  {
+    close(fd_);
+    fd_ = -1;
+  }
+  notificar(TRANSPORTE_DESCONECTADO);
+}
+
+void TransporteHost::sondear()
+{
+  if (fd_ < 0)
+    return;
+
+  // Congestionado tambien se espera POLLOUT: la aplicacion no vuelve a
+  // escribir hasta que se avise, como el CONG_EVT del stack SPP
+  struct pollfd p = {fd_, (short)(POLLIN | (congestionado_ ? POLLOUT : 0)), 0};
+  if (poll(&p, 1, 0) < 0)
+    return;
+  bool colgado = (p.revents & (POLLHUP | POLLERR)) != 0;
+
+  // Socket: un cierre ordenado deja POLLIN con 0 bytes para leer
+  if (!colgado && modo_ == PAR_SOCKETS && (p.revents & POLLIN))
+  {
+    char c;
+    colgado = recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0;
+  }
+
+  if (colgado)
+    marcarDesconectado();
+  else if (!conectado_ && modo_ == PTY)
+  {
+    // El master deja de dar POLLHUP cuando alguien abre el esclavo
+    conectado_ = true;
+    notificar(TRANSPORTE_CONECTADO);
+  }
+  else if (congestionado_ && (p.revents & POLLOUT))
+  {
+    congestionado_ = false;
+    notificar(TRANSPORTE_DESCONGESTIONADO);
+  }
+}
+
+bool TransporteHost::hayCliente()
+{
+  sondear();
+  return conectado_;
+}
+
+void TransporteHost::rellenar()
+{
+  if (!conectado_ || inicioEntrada_ < finEntrada_)
+    return;
+  ssize_t n = ::read(fd_, entrada_, sizeof(entrada_));
+  inicioEntrada_ = 0;
+  finEntrada_ = n > 0 ? (size_t)n : 0;
+}
+
+int TransporteHost::disponible()
+{
+  rellenar();
+  return (int)(finEntrada_ - inicioEntrada_);
+}
+
+int TransporteHost::leer()
+{
+  rellenar();
+  if (inicioEntrada_ >= finEntrada_)
+    return -1;
+  return entrada_[inicioEntrada_++];
+}
+
+size_t TransporteHost::escribir(const uint8_t *datos, size_t len)
+{
+  if (!conectado_)
+    return 0;
+
+  ssize_t n = modo_ == PAR_SOCKETS ? send(fd_, datos, len, MSG_DONTWAIT | MSG_NOSIGNAL) : ::write(fd_, datos, len);
+  if (n < 0)
+  {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+      if (!congestionado_)
+      {
+        congestionado_ = true;
+        notificar(TRANSPORTE_CONGESTIONADO);
+      }
+    }
+    else
+      marcarDesconectado();
+    return 0;
+  }
+  if (congestionado_)
+  {
+    congestionado_ = false;
+    notificar(TRANSPORTE_DESCONGESTIONADO);
+  }
+  return (size_t)n;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifdef ARDUINO
+
+#include "transporte_spp.h"
+
+TransporteSPP *TransporteSPP::instancia_ = nullptr;
+
+TransporteSPP::TransporteSPP()
+{
+  instancia_ = this;
+}
+
+bool TransporteSPP::iniciar(const char *nombre)
+{
+  serial_.register_callback(callbackSPP);
+  return serial_.begin(nombre);
+}
+
+void TransporteSPP::detener()
+{
+  serial_.end();
+}
+
+void TransporteSPP::callbackSPP(esp_spp_cb_event_t evento, esp_spp_cb_param_t *param)
+{
+  if (!instancia_)
+    return;
+  switch (evento)
+  {
+  case ESP_SPP_SRV_OPEN_EVT:
+    instancia_->notificar(TRANSPORTE_CONECTADO);
+    break;
+  case ESP_SPP_CLOSE_EVT:
+    instancia_->notificar(TRANSPORTE_DESCONECTADO);
+    break;
+  case ESP_SPP_CONG_EVT:
+    instancia_->notificar(param->cong.cong ? TRANSPORTE_CONGESTIONADO : TRANSPORTE_DESCONGESTIONADO);
+    break;
+  default:
+    break;
+  }
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <string.h>
+#include <unity.h>
+#include "ajustes.h"
+#include "crc.h"
+#include "hal_host.h"
+
+// Formato en archivo de AlmacenAjustes: carga empaquetada, registros de la
+// version 1 escritos como struct crudo y versiones que no se pueden leer
+
+static const char *const RUTA_A = "/ajustes_a.bin";
+static const char *const RUTA_B = "/ajustes_b.bin";
+static const uint32_t MAGIA = 0x54534A41;
+static const size_t CABECERA_BYTES = 16;
+static const size_t CARGA_V1_BYTES = 30;
+
+static uint32_t relojPrueba() { return 0; }
+
+void setUp()
+{
+  archivosHost.directorio("datos_test");
+  archivosHost.borrar(RUTA_A);
+  archivosHost.borrar(RUTA_B);
+}
+void tearDown() {}
+
+// Registro armado a mano: magia, version, longitud, secuencia y CRC de la
+// cabecera sin el CRC mas la carga
+static void escribirRegistro(const char *ruta, uint16_t version, uint32_t secuencia, const void *carga,
+                             uint16_t longitud)
+{
+  uint8_t registro[128];
+  memcpy(registro, &MAGIA, 4);
+  memcpy(registro + 4, &version, 2);
+  memcpy(registro + 6, &longitud, 2);
+  memcpy(registro + 8, &secuencia, 4);
+  uint32_t crc = crc32(carga, longitud, crc32(registro, 12));
+  memcpy(registro + 12, &crc, 4);
+  memcpy(registro + CABECERA_BYTES, carga, longitud);
+  TEST_ASSERT_EQUAL_UINT32(CABECERA_BYTES + longitud, archivos.escribir(ruta, registro, CABECERA_BYTES + longitud));
+}
+
+static Ajustes ajustesPrueba(int16_t consigna)
+{
+  Ajustes a;
+  memset(&a, 0, sizeof(a));
+  a.kp = 3.5f;
+  a.ki = 0.25f;
+  a.kd = 1.0f;
+  a.consigna[0] = consigna;
+  a.consigna[1] = (int16_t)(consigna + 10);
+  a.histeresis = 7;
+  for (uint8_t i = 0; i < 5; i++)
+    a.calTactil[i] = (uint16_t)(1000 + i);
+  a.calValida = 1;
+  a.modo = 2;
+  return a;
+}
+
+static void verificar(const Ajustes &e, const Ajustes &a)
+{
+  TEST_ASSERT_TRUE(e.kp == a.kp && e.ki == a.ki && e.kd == a.kd);
+  TEST_ASSERT_EQUAL_INT16(e.consigna[0], a.consigna[0]);
+  TEST_ASSERT_EQUAL_INT16(e.consigna[1], a.consigna[1]);
+  TEST_ASSERT_EQUAL_INT16(e.histeresis, a.histeresis);
+  TEST_ASSERT_EQUAL_MEMORY(e.calTactil, a.calTactil, sizeof(e.calTactil));
+  TEST_ASSERT_EQUAL_UINT8(e.calValida, a.calValida);
+  TEST_ASSERT_EQUAL_UINT8(e.modo, a.modo);
+}
+
+// El registro lleva la carga empaquetada, sin el relleno del struct
+static void test_ida_y_vuelta_sin_relleno()
+{
+  AlmacenAjustes almacen(archivos, relojPrueba);
+  almacen.begin();
+  almacen.editar() = ajustesPrueba(300);
+  TEST_ASSERT_TRUE(almacen.confirmar());
+  TEST_ASSERT_EQUAL_UINT32(CABECERA_BYTES + CARGA_V1_BYTES, almacen.estadisticas().ultimosBytes);
+
+  AlmacenAjustes otro(archivos, relojPrueba);
+  otro.begin();
+  TEST_ASSERT_TRUE(otro.hayRegistroValido());
+  verificar(ajustesPrueba(300), otro.leer());
+}
+
+// Lo que escribia la version 1: el struct crudo de 32 bytes con el relleno
+static void test_registro_v1_crudo_se_sigue_leyendo()
+{
+  Ajustes crudo = ajustesPrueba(280);
+  escribirRegistro(RUTA_A, 1, 1, &crudo, sizeof(crudo));
+
+  AlmacenAjustes almacen(archivos, relojPrueba);
+  almacen.begin();
+  TEST_ASSERT_TRUE(almacen.hayRegistroValido());
+  verificar(crudo, almacen.leer());
+}
+
+// Version 0 o una carga mas corta que la de su version no se pueden
+// interpretar: se descartan aunque el CRC este bien y queda la otra ranura
+static void test_version_ilegible_se_descarta()
+{
+  Ajustes buena = ajustesPrueba(260);
+  escribirRegistro(RUTA_A, 1, 1, &buena, sizeof(buena));
+  Ajustes nueva = ajustesPrueba(310);
+  escribirRegistro(RUTA_B, 0, 2, &nueva, sizeof(nueva));
+  AlmacenAjustes sinVersion(archivos, relojPrueba);
+  sinVersion.begin();
+  verificar(buena, sinVersion.leer());
+
+  escribirRegistro(RUTA_B, 1, 2, &nueva, 20);
+  AlmacenAjustes corto(archivos, relojPrueba);
+  corto.begin();
+  verificar(buena, corto.leer());
+}
+
+// Una version futura agrega campos al final: se leen los conocidos
+static void test_version_nueva_se_lee_hasta_lo_conocido()
+{
+  uint8_t carga[CARGA_V1_BYTES + 6];
+  Ajustes e = ajustesPrueba(240);
+  memcpy(carga, &e, CARGA_V1_BYTES);
+  memset(carga + CARGA_V1_BYTES, 0xA5, 6);
+  escribirRegistro(RUTA_A, AJUSTES_VERSION + 1, 1, carga, sizeof(carga));
+
+  AlmacenAjustes almacen(archivos, relojPrueba);
+  almacen.begin();
+  TEST_ASSERT_TRUE(almacen.hayRegistroValido());
+  verificar(e, almacen.leer());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ida_y_vuelta_sin_relleno);
+  RUN_TEST(test_registro_v1_crudo_se_sigue_leyendo);
+  RUN_TEST(test_version_ilegible_se_descarta);
+  RUN_TEST(test_version_nueva_se_lee_hasta_lo_conocido);
+  return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <thread>
+#include <unity.h>
+#include "anillo_spsc.h"
+
+// Un productor y un consumidor en hilos distintos: todo llega, en orden y
+// entero, y lo que no entra se cuenta en perdidos()
+
+void setUp() {}
+void tearDown() {}
+
+// Mas grande que una palabra para que una ranura leida a medias se note
+struct Paquete
+{
+  uint32_t secuencia;
+  uint32_t relleno[6];
+  uint32_t control; // Deriva de todo lo anterior
+};
+
+static uint32_t control(const Paquete &p)
+{
+  uint32_t c = p.secuencia * 2654435761u;
+  for (uint32_t r : p.relleno)
+    c = (c ^ r) * 16777619u;
+  return c;
+}
+
+static Paquete paquete(uint32_t secuencia)
+{
+  Paquete p;
+  p.secuencia = secuencia;
+  for (uint32_t i = 0; i < 6; i++)
+    p.relleno[i] = secuencia * 7 + i;
+  p.control = control(p);
+  return p;
+}
+
+static const uint32_t TOTAL = 2000000;
+
+static void test_lleno_vacio_y_perdidos()
+{
+  AnilloSpsc<uint32_t, 4> anillo;
+  uint32_t v = 0;
+  TEST_ASSERT_TRUE(anillo.vacio());
+  TEST_ASSERT_FALSE(anillo.siguiente(v));
+  for (uint32_t i = 0; i < 4; i++)
+    TEST_ASSERT_TRUE(anillo.publicar(i));
+  TEST_ASSERT_FALSE(anillo.publicar(99));
+  TEST_ASSERT_FALSE(anillo.publicar(99));
+  TEST_ASSERT_EQUAL_UINT32(2, anillo.perdidos());
+  TEST_ASSERT_EQUAL_UINT16(4, anillo.cantidad());
+  // Varias vueltas de la mascara
+  for (uint32_t i = 4; i < 40; i++)
+  {
+    TEST_ASSERT_TRUE(anillo.siguiente(v));
+    TEST_ASSERT_EQUAL_UINT32(i - 4, v);
+    TEST_ASSERT_TRUE(anillo.publicar(i));
+  }
+  TEST_ASSERT_EQUAL_UINT16(4, anillo.cantidad());
+  TEST_ASSERT_EQUAL_UINT32(2, anillo.perdidos());
+}
+
+// El productor reintenta cuando esta lleno: llegan todos, uno tras otro
+static void test_dos_hilos_sin_perdidas_en_orden()
+{
+  static AnilloSpsc<Paquete, 16> anillo;
+  std::thread productor([] {
+    for (uint32_t i = 0; i < TOTAL; i++)
+    {
+      Paquete p = paquete(i);
+      while (!anillo.publicar(p))
+        std::this_thread::yield();
+    }
+  });
+
+  uint32_t esperado = 0;
+  uint32_t corruptos = 0;
+  uint32_t fueraDeOrden = 0;
+  while (esperado < TOTAL)
+  {
+    Paquete p;
+    if (!anillo.siguiente(p))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    if (p.control != control(p))
+      corruptos++;
+    if (p.secuencia != esperado)
+      fueraDeOrden++;
+    esperado = p.secuencia + 1;
+  }
+  productor.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, corruptos);
+  TEST_ASSERT_EQUAL_UINT32(0, fueraDeOrden);
+  TEST_ASSERT_TRUE(anillo.vacio());
+}
+
+// Sin reintentos: lo que llega sigue en orden y llegados + perdidos = total
+static void test_dos_hilos_con_perdidas()
+{
+  static AnilloSpsc<Paquete, 8> anillo;
+  static std::atomic<bool> termino(false);
+  std::thread productor([] {
+    for (uint32_t i = 0; i < TOTAL; i++)
+      anillo.publicar(paquete(i));
+    termino.store(true, std::memory_order_release);
+  });
+
+  uint32_t llegados = 0;
+  uint32_t corruptos = 0;
+  uint32_t fueraDeOrden = 0;
+  int64_t anterior = -1;
+  for (;;)
+  {
+    Paquete p;
+    if (!anillo.siguiente(p))
+    {
+      if (termino.load(std::memory_order_acquire) && anillo.vacio())
+        break;
+      std::this_thread::yield();
+      continue;
+    }
+    llegados++;
+    if (p.control != control(p))
+      corruptos++;
+    if ((int64_t)p.secuencia <= anterior)
+      fueraDeOrden++;
+    anterior = p.secuencia;
+  }
+  productor.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, corruptos);
+  TEST_ASSERT_EQUAL_UINT32(0, fueraDeOrden);
+  TEST_ASSERT_EQUAL_UINT32(TOTAL, llegados + anillo.perdidos());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_lleno_vacio_y_perdidos);
+  RUN_TEST(test_dos_hilos_sin_perdidas_en_orden);
+  RUN_TEST(test_dos_hilos_con_perdidas);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+#include "bus_spi.h"
+
+// Gestor del bus sobre un reloj falso: cada paso de dibujo tarda PASO_US y
+// el tactil nunca esta presionado
+
+void setUp() {}
+void tearDown() {}
+
+static const uint32_t PERIODO_TACTIL_US = 20000;
+static const uint32_t PASO_US = 1000;
+static uint32_t ahoraUs = 1000000;
+
+static uint32_t relojFalso() { return ahoraUs; }
+static bool muestreoFalso(uint16_t *, uint16_t *) { return false; }
+
+static bool trabajoCorto(uint8_t)
+{
+  ahoraUs += PASO_US;
+  return false;
+}
+
+// Tres pasos, como un fondo en franjas
+static bool trabajoLargo(uint8_t paso)
+{
+  ahoraUs += PASO_US;
+  return paso < 2;
+}
+
+static void test_sin_redibujo_no_se_mide()
+{
+  GestorBusSPI bus(relojFalso, muestreoFalso, PERIODO_TACTIL_US);
+  bus.servir(5000);
+  ahoraUs += 10000;
+  bus.servir(5000);
+  // Un trabajo que no responde a ningun toque tampoco
+  bus.encolarPantalla(trabajoCorto);
+  bus.servir(5000);
+  TEST_ASSERT_EQUAL_UINT32(0, bus.latenciaToque().total);
+}
+
+// El toque arma la medicion y el trabajo que lo responde llega despues,
+// encolado por otra tarea: lo que sale antes no la cierra
+static void test_latencia_hasta_el_trabajo_que_responde()
+{
+  GestorBusSPI bus(relojFalso, muestreoFalso, PERIODO_TACTIL_US);
+  uint32_t toque = ahoraUs;
+  bus.iniciarRespuesta(trabajoLargo, toque);
+  bus.encolarPantalla(trabajoCorto);
+  bus.servir(5000);
+  ahoraUs += 8000;
+  bus.servir(5000); // Cola vacia: antes esto cerraba la respuesta
+  TEST_ASSERT_EQUAL_UINT32(0, bus.latenciaToque().total);
+
+  bus.encolarPantalla(trabajoLargo);
+  bus.servir(5000);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.latenciaToque().total);
+  TEST_ASSERT_EQUAL_UINT32(ahoraUs - toque, bus.latenciaToque().maximo);
+}
+
+// Un trabajo igual ya empezado dibujo el estado de antes del toque: la
+// respuesta la lleva el que se encola despues
+static void test_trabajo_ya_empezado_no_lleva_la_respuesta()
+{
+  GestorBusSPI bus(relojFalso, muestreoFalso, PERIODO_TACTIL_US);
+  bus.encolarPantalla(trabajoLargo);
+  bus.servir(PASO_US); // Un paso y queda a medias
+  uint32_t toque = ahoraUs;
+  bus.iniciarRespuesta(trabajoLargo, toque);
+  bus.servir(2 * PASO_US);
+  TEST_ASSERT_FALSE(bus.pantallaPendiente());
+  TEST_ASSERT_EQUAL_UINT32(0, bus.latenciaToque().total);
+
+  bus.encolarPantalla(trabajoLargo);
+  bus.encolarPantalla(trabajoLargo); // Se fusiona con el que lleva la respuesta
+  bus.servir(5000);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.latenciaToque().total);
+  TEST_ASSERT_EQUAL_UINT32(5 * PASO_US, bus.latenciaToque().maximo);
+}
+
+// Tras una pausa larga (pantalla apagada) el primer muestreo sale enseguida
+// y no cuenta como retraso; los siguientes si
+static void test_reanudar_no_cuenta_la_pausa()
+{
+  GestorBusSPI bus(relojFalso, muestreoFalso, PERIODO_TACTIL_US);
+  bus.servir(5000);
+  ahoraUs += PERIODO_TACTIL_US + 300;
+  bus.servir(5000);
+  TEST_ASSERT_EQUAL_UINT32(300, bus.estadisticas().retrasoTactilMaxUs);
+
+  ahoraUs += 600000000; // Diez minutos en pausa
+  bus.reanudar();
+  uint32_t muestras = bus.estadisticas().muestrasTactil;
+  bus.servir(5000);
+  TEST_ASSERT_EQUAL_UINT32(muestras + 1, bus.estadisticas().muestrasTactil);
+  TEST_ASSERT_EQUAL_UINT32(300, bus.estadisticas().retrasoTactilMaxUs);
+
+  ahoraUs += PERIODO_TACTIL_US + 700;
+  bus.servir(5000);
+  TEST_ASSERT_EQUAL_UINT32(700, bus.estadisticas().retrasoTactilMaxUs);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_sin_redibujo_no_se_mide);
+  RUN_TEST(test_latencia_hasta_el_trabajo_que_responde);
+  RUN_TEST(test_trabajo_ya_empezado_no_lleva_la_respuesta);
+  RUN_TEST(test_reanudar_no_cuenta_la_pausa);
+  return UNITY_END();
+}
@@ -0,0 +1,109 @@
+#include <string.h>
+#include <unity.h>
+#include "cola_tx.h"
+
+// Cola de transmision: coalescido, descarte y estadisticas que sobreviven a
+// una desconexion
+
+void setUp() {}
+void tearDown() {}
+
+static char salida[ColaTransmision::RANURAS * ColaTransmision::TAM_RANURA + 1];
+static size_t largoSalida = 0;
+static size_t aceptaPorLlamada = SIZE_MAX;
+
+static size_t escribir(const uint8_t *datos, size_t len)
+{
+  if (len > aceptaPorLlamada)
+    len = aceptaPorLlamada;
+  memcpy(salida + largoSalida, datos, len);
+  largoSalida += len;
+  salida[largoSalida] = '\0';
+  return len;
+}
+
+static void reiniciarSalida(size_t acepta = SIZE_MAX)
+{
+  largoSalida = 0;
+  salida[0] = '\0';
+  aceptaPorLlamada = acepta;
+}
+
+static void test_coalesce_el_estado_pendiente()
+{
+  ColaTransmision cola;
+  reiniciarSalida();
+  TEST_ASSERT_TRUE(cola.encolar(MSG_ESTADO, "e1|"));
+  TEST_ASSERT_TRUE(cola.encolar(MSG_RESPUESTA, "ok|"));
+  TEST_ASSERT_TRUE(cola.encolar(MSG_ESTADO, "e2|"));
+  cola.bombear(escribir, 1000);
+  TEST_ASSERT_EQUAL_STRING("e2|ok|", salida);
+  TEST_ASSERT_EQUAL_UINT32(1, cola.estadisticas().coalescidos);
+  TEST_ASSERT_EQUAL_UINT32(6, cola.estadisticas().bytesEnviados);
+}
+
+// Lo que ya empezo a salir no se pisa
+static void test_no_pisa_la_ranura_a_medio_enviar()
+{
+  ColaTransmision cola;
+  reiniciarSalida(2);
+  cola.encolar(MSG_ESTADO, "viejo|");
+  cola.bombear(escribir, 1000);
+  cola.encolar(MSG_ESTADO, "nuevo|");
+  reiniciarSalida();
+  cola.bombear(escribir, 1000);
+  TEST_ASSERT_EQUAL_STRING("ejo|nuevo|", salida);
+  TEST_ASSERT_EQUAL_UINT32(0, cola.estadisticas().coalescidos);
+}
+
+static void test_llena_descarta_reemplazables_y_rechaza_el_resto()
+{
+  ColaTransmision cola;
+  cola.encolar(MSG_MUESTRA, "m");
+  for (uint8_t i = 1; i < ColaTransmision::RANURAS; i++)
+    TEST_ASSERT_TRUE(cola.encolar(MSG_RESPUESTA, "r"));
+  TEST_ASSERT_TRUE(cola.encolar(MSG_RESPUESTA, "r")); // Saca la muestra
+  TEST_ASSERT_FALSE(cola.encolar(MSG_RESPUESTA, "r"));
+  TEST_ASSERT_EQUAL_UINT32(1, cola.estadisticas().descartados);
+  TEST_ASSERT_EQUAL_UINT32(1, cola.estadisticas().rechazados);
+}
+
+// Una desconexion vacia la cola pero los contadores siguen desde el arranque
+static void test_vaciar_conserva_las_estadisticas()
+{
+  ColaTransmision cola;
+  reiniciarSalida();
+  cola.encolar(MSG_ESTADO, "a");
+  cola.encolar(MSG_ESTADO, "b");
+  cola.bombear(escribir, 1000);
+  cola.encolar(MSG_RESPUESTA, "pendiente");
+  cola.vaciar();
+
+  TEST_ASSERT_TRUE(cola.vacia());
+  TEST_ASSERT_EQUAL_UINT8(ColaTransmision::RANURAS, cola.libres());
+  const EstadisticasColaTx &est = cola.estadisticas();
+  TEST_ASSERT_EQUAL_UINT32(3, est.encolados);
+  TEST_ASSERT_EQUAL_UINT32(1, est.coalescidos);
+  TEST_ASSERT_EQUAL_UINT32(1, est.bytesEnviados);
+
+  reiniciarSalida();
+  cola.encolar(MSG_RESPUESTA, "x");
+  cola.bombear(escribir, 1000);
+  TEST_ASSERT_EQUAL_STRING("x", salida);
+  TEST_ASSERT_EQUAL_UINT32(4, est.encolados);
+  TEST_ASSERT_EQUAL_UINT32(2, est.bytesEnviados);
+
+  cola.reiniciarEstadisticas();
+  TEST_ASSERT_EQUAL_UINT32(0, est.encolados);
+  TEST_ASSERT_EQUAL_UINT32(0, est.bytesEnviados);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_coalesce_el_estado_pendiente);
+  RUN_TEST(test_no_pisa_la_ranura_a_medio_enviar);
+  RUN_TEST(test_llena_descarta_reemplazables_y_rechaza_el_resto);
+  RUN_TEST(test_vaciar_conserva_las_estadisticas);
+  return UNITY_END();
+}
@@ -0,0 +1,166 @@
+#include <unity.h>
+#include "gestos_tactil.h"
+
+// Trazas sinteticas de muestras (una cada PERIODO_US, como las toma el bus
+// SPI) contra los eventos y marcas que tiene que dar la maquina, con la
+// configuracion por defecto: rebote 30 ms, largo 700 ms, repeticion 200 ms
+
+void setUp() {}
+void tearDown() {}
+
+static const uint32_t PERIODO_US = 10000;
+static const uint32_t T0 = 1000000;
+
+// 'ms' de muestras iguales a partir de t; devuelve el instante que sigue
+static uint32_t tramo(MaquinaGestos &m, uint32_t t, bool presionado, uint32_t ms, uint16_t x = 100,
+                      uint16_t y = 200)
+{
+  for (uint32_t fin = t + ms * 1000; (int32_t)(t - fin) < 0; t += PERIODO_US)
+    m.muestra(presionado, x, y, t);
+  return t;
+}
+
+static void esperarEvento(MaquinaGestos &m, TipoEventoTactil tipo, uint32_t us, uint16_t x = 100,
+                          uint16_t y = 200)
+{
+  EventoTactil ev;
+  TEST_ASSERT_TRUE(m.siguiente(ev));
+  TEST_ASSERT_EQUAL_UINT8(tipo, ev.tipo);
+  TEST_ASSERT_EQUAL_UINT32(us, ev.us);
+  TEST_ASSERT_EQUAL_UINT16(x, ev.x);
+  TEST_ASSERT_EQUAL_UINT16(y, ev.y);
+}
+
+static void sinMasEventos(MaquinaGestos &m)
+{
+  EventoTactil ev;
+  TEST_ASSERT_FALSE(m.siguiente(ev));
+}
+
+static void test_pico_mas_corto_que_el_rebote_se_ignora()
+{
+  MaquinaGestos m;
+  uint32_t t = tramo(m, T0, false, 50);
+  t = tramo(m, t, true, 20); // Dos muestras: 0 y 10 ms
+  t = tramo(m, t, false, 100);
+  t = tramo(m, t, true, 10);
+  tramo(m, t, false, 100);
+  sinMasEventos(m);
+  TEST_ASSERT_TRUE(m.enReposo());
+}
+
+static void test_click()
+{
+  MaquinaGestos m;
+  uint32_t t = tramo(m, T0, true, 100);
+  tramo(m, t, false, 100);
+  // La bajada se confirma a los 30 ms de la primera muestra y la subida a
+  // los 30 ms de la primera muestra suelta
+  esperarEvento(m, TOQUE_BAJADA, T0 + 30000);
+  esperarEvento(m, TOQUE_SUBIDA, T0 + 130000);
+  esperarEvento(m, TOQUE_CLICK, T0 + 130000);
+  sinMasEventos(m);
+}
+
+static void test_rebote_al_soltar_es_un_solo_toque()
+{
+  MaquinaGestos m;
+  uint32_t t = tramo(m, T0, true, 100);
+  t = tramo(m, t, false, 20); // Rebote: vuelve a tocar antes de 30 ms
+  t = tramo(m, t, true, 50);
+  uint32_t suelta = t;
+  tramo(m, t, false, 100);
+  esperarEvento(m, TOQUE_BAJADA, T0 + 30000);
+  esperarEvento(m, TOQUE_SUBIDA, suelta + 30000);
+  esperarEvento(m, TOQUE_CLICK, suelta + 30000);
+  sinMasEventos(m);
+}
+
+// Mantenido 1.2 s arrastrando el dedo: largo a los 700 ms de la primera
+// muestra y repeticiones cada 200 ms; al soltar no hay click
+static void test_largo_y_repeticiones()
+{
+  MaquinaGestos m;
+  uint32_t t = tramo(m, T0, true, 500, 10, 20);
+  t = tramo(m, t, true, 700, 30, 40);
+  tramo(m, t, false, 100);
+  esperarEvento(m, TOQUE_BAJADA, T0 + 30000, 10, 20);
+  esperarEvento(m, TOQUE_LARGO, T0 + 700000, 30, 40);
+  esperarEvento(m, TOQUE_REPETICION, T0 + 900000, 30, 40);
+  esperarEvento(m, TOQUE_REPETICION, T0 + 1100000, 30, 40);
+  esperarEvento(m, TOQUE_SUBIDA, T0 + 1230000, 30, 40);
+  sinMasEventos(m);
+}
+
+// Las mismas marcas con micros() dando la vuelta a mitad del gesto
+static void test_repeticiones_a_traves_de_la_vuelta_de_micros()
+{
+  MaquinaGestos m;
+  const uint32_t inicio = 0u - 800000u;
+  uint32_t t = tramo(m, inicio, true, 1200);
+  tramo(m, t, false, 100);
+  esperarEvento(m, TOQUE_BAJADA, inicio + 30000);
+  esperarEvento(m, TOQUE_LARGO, inicio + 700000);
+  esperarEvento(m, TOQUE_REPETICION, inicio + 900000);
+  esperarEvento(m, TOQUE_REPETICION, inicio + 1100000);
+  esperarEvento(m, TOQUE_SUBIDA, inicio + 1230000);
+  sinMasEventos(m);
+}
+
+// 5 s mantenido sin que nadie saque eventos: bajada, largo y 21
+// repeticiones mas la subida no entran en 16; lo que sobra se cuenta y la
+// cola sigue funcionando despues de vaciarla
+static void test_cola_llena_descarta_lo_nuevo()
+{
+  MaquinaGestos m;
+  uint32_t t = tramo(m, T0, true, 5000);
+  t = tramo(m, t, false, 100);
+  TEST_ASSERT_EQUAL_UINT32(24 - MaquinaGestos::CAPACIDAD_COLA, m.descartados());
+
+  esperarEvento(m, TOQUE_BAJADA, T0 + 30000);
+  esperarEvento(m, TOQUE_LARGO, T0 + 700000);
+  for (uint32_t i = 0; i < MaquinaGestos::CAPACIDAD_COLA - 2; i++)
+    esperarEvento(m, TOQUE_REPETICION, T0 + 900000 + i * 200000);
+  sinMasEventos(m);
+
+  uint32_t toque = t;
+  t = tramo(m, t, true, 100);
+  tramo(m, t, false, 100);
+  esperarEvento(m, TOQUE_BAJADA, toque + 30000);
+  esperarEvento(m, TOQUE_SUBIDA, t + 30000);
+  esperarEvento(m, TOQUE_CLICK, t + 30000);
+  sinMasEventos(m);
+  TEST_ASSERT_EQUAL_UINT32(24 - MaquinaGestos::CAPACIDAD_COLA, m.descartados());
+}
+
+static void test_configuracion_propia()
+{
+  ConfigGestos c;
+  c.msRebote = 50;
+  c.msLargo = 300;
+  c.msRepeticion = 100;
+  MaquinaGestos m(c);
+  uint32_t t = tramo(m, T0, true, 40); // Menos que el rebote
+  t = tramo(m, t, false, 100);
+  uint32_t toque = t;
+  t = tramo(m, t, true, 420);
+  tramo(m, t, false, 100);
+  esperarEvento(m, TOQUE_BAJADA, toque + 50000);
+  esperarEvento(m, TOQUE_LARGO, toque + 300000);
+  esperarEvento(m, TOQUE_REPETICION, toque + 400000);
+  esperarEvento(m, TOQUE_SUBIDA, t + 50000);
+  sinMasEventos(m);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_pico_mas_corto_que_el_rebote_se_ignora);
+  RUN_TEST(test_click);
+  RUN_TEST(test_rebote_al_soltar_es_un_solo_toque);
+  RUN_TEST(test_largo_y_repeticiones);
+  RUN_TEST(test_repeticiones_a_traves_de_la_vuelta_de_micros);
+  RUN_TEST(test_cola_llena_descarta_lo_nuevo);
+  RUN_TEST(test_configuracion_propia);
+  return UNITY_END();
+}
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include <chrono>
+#include "aplicacion.h"
+#include "crc.h"
+#include "hal_host.h"
+#include "lazo_host.h"
+
+// Dobles de hal_host.h y la aplicacion entera en tiempo virtual
+// (lazo_host.h), como corre controlador_host --sim
+
+void setUp() {}
+void tearDown() {}
+
+static void test_reloj_da_la_vuelta_en_2_32()
+{
+  relojHost.simular((1ULL << 32) * 1000 - 500);
+  uint32_t ms = reloj.millis();
+  uint32_t us = reloj.micros();
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, ms);
+  relojHost.avanzar(1000);
+  TEST_ASSERT_EQUAL_UINT32(0, reloj.millis());
+  // Las restas sin signo siguen dando el intervalo a traves de la vuelta
+  TEST_ASSERT_EQUAL_UINT32(1000, reloj.micros() - us);
+  reloj.esperarMs(5);
+  TEST_ASSERT_EQUAL_UINT32(6, reloj.millis() - ms);
+}
+
+static void test_archivos_ida_y_vuelta()
+{
+  archivosHost.directorio("datos_test");
+  const char texto[] = "controlador";
+  archivosHost.borrar("/prueba.bin");
+  TEST_ASSERT_FALSE(archivos.existe("/prueba.bin"));
+  TEST_ASSERT_EQUAL_UINT32(sizeof(texto), archivos.escribir("/prueba.bin", texto, sizeof(texto)));
+  TEST_ASSERT_TRUE(archivos.existe("/prueba.bin"));
+
+  char leido[8];
+  TEST_ASSERT_EQUAL_UINT32(5, archivos.leer("/prueba.bin", 6, leido, 5));
+  TEST_ASSERT_EQUAL_MEMORY("lador", leido, 5);
+  TEST_ASSERT_EQUAL_UINT32(0, archivos.leer("/no_existe.bin", 0, leido, sizeof(leido)));
+  TEST_ASSERT_TRUE(archivos.borrar("/prueba.bin"));
+  TEST_ASSERT_FALSE(archivos.existe("/prueba.bin"));
+}
+
+static void test_gpio_cuenta_cambios_de_las_salidas()
+{
+  const uint8_t PIN = 4;
+  gpio.salida(PIN);
+  uint32_t antes = gpioHost.cambios(PIN);
+  gpio.escribir(PIN, true);
+  gpio.escribir(PIN, true);
+  gpio.escribir(PIN, false);
+  TEST_ASSERT_EQUAL_UINT32(antes + 2, gpioHost.cambios(PIN));
+  TEST_ASSERT_TRUE(gpioHost.esSalida(PIN));
+
+  // Una entrada la maneja el lado externo; escribirla no hace nada
+  const uint8_t ENTRADA = 5;
+  gpio.entrada(ENTRADA);
+  gpioHost.fijar(ENTRADA, true);
+  gpio.escribir(ENTRADA, false);
+  TEST_ASSERT_TRUE(gpio.leer(ENTRADA));
+  TEST_ASSERT_EQUAL_UINT32(0, gpioHost.cambios(ENTRADA));
+}
+
+static void test_tactil_solo_lee_mientras_hay_dedo()
+{
+  uint16_t x = 0, y = 0;
+  TEST_ASSERT_FALSE(tactil.leer(x, y));
+  tactilHost.tocar(120, 300);
+  TEST_ASSERT_TRUE(tactil.presionado());
+  TEST_ASSERT_TRUE(tactil.leer(x, y));
+  TEST_ASSERT_EQUAL_UINT16(120, x);
+  TEST_ASSERT_EQUAL_UINT16(300, y);
+  tactilHost.soltar();
+  TEST_ASSERT_FALSE(tactil.presionado());
+  TEST_ASSERT_FALSE(tactil.leer(x, y));
+}
+
+static void test_consola_cuenta_lineas_y_crc_aunque_este_silenciada()
+{
+  consolaHost.silenciar(true);
+  uint32_t lineas = consolaHost.lineas();
+  uint32_t crc = consolaHost.crc();
+  consola.escribir("uno\ndos");
+  consola.escribir("\n");
+  TEST_ASSERT_EQUAL_UINT32(lineas + 2, consolaHost.lineas());
+  TEST_ASSERT_EQUAL_HEX32(crc32("\n", 1, crc32("uno\ndos", 7, crc)), consolaHost.crc());
+}
+
+// Arranque limpio en AUTO, sistema encendido desde el tactil y dos canales
+// que cruzan la consigna: los reles tienen que seguir a la temperatura
+static void test_aplicacion_controla_en_tiempo_virtual()
+{
+  prepararHost("datos_test", 1000000);
+  iniciarAplicacion();
+  iniciarTareasHost();
+  TEST_ASSERT_GREATER_THAN_UINT32(0, (uint32_t)simularHost(500000));
+
+  tocarHost(62, 280); // SISTEMA ON
+  simularHost(100000);
+  tactilHost.soltar();
+  simularHost(1000000);
+
+  uint32_t conversiones = sensoresHost.conversiones();
+  sensoresHost.fijar(0, 20 * 16);
+  sensoresHost.fijar(1, 20 * 16);
+  simularHost(60000000);
+  uint32_t k1 = gpioHost.cambios(PIN_RELE1);
+  uint32_t k2 = gpioHost.cambios(PIN_RELE2);
+  sensoresHost.fijar(0, 30 * 16);
+  sensoresHost.fijar(1, 30 * 16);
+  simularHost(60000000);
+
+  // Una conversion cada 2 s
+  TEST_ASSERT_UINT32_WITHIN(2, conversiones + 60, sensoresHost.conversiones());
+  TEST_ASSERT_GREATER_THAN_UINT32(k1, gpioHost.cambios(PIN_RELE1));
+  TEST_ASSERT_GREATER_THAN_UINT32(k2, gpioHost.cambios(PIN_RELE2));
+  TEST_ASSERT_EQUAL_UINT32(0, plataformaHost.mhz() % 80);
+}
+
+// --- Reposo con y sin PENIRQ ---
+static const uint32_t ESPERA_MINIMA_SLEEP_US = 5000; // La de loop() en main.cpp
+static const uint64_t VENTANA_OCIO_US = 60000000ULL;
+
+struct Ocio
+{
+  double tactilS;     // Lecturas del panel (transacciones SPI) por segundo
+  double pantallaS;   // Operaciones de dibujo por segundo
+  double activacionesS;
+  double despierto;   // % del tiempo sin poder entrar en light sleep (las
+                      // activaciones no gastan tiempo virtual)
+  double hostNsPorS;  // CPU del host por segundo simulado
+};
+
+// Como simularHost(), pero sumando el tiempo que el ESP32 pasaria en light
+// sleep: todas las tareas en reposo y al menos ESPERA_MINIMA_SLEEP_US hasta
+// la proxima activacion
+static Ocio medirOcio(const char *caso)
+{
+  uint32_t lecturas = tactilHost.lecturas();
+  uint32_t operaciones = pantallaHost.operaciones();
+  uint64_t activaciones = 0;
+  uint64_t durmiendoUs = 0;
+  uint64_t fin = relojHost.us64() + VENTANA_OCIO_US;
+  auto inicio = std::chrono::steady_clock::now();
+  while (relojHost.us64() < fin)
+  {
+    activaciones += correrTareasHost();
+    uint64_t restante = fin - relojHost.us64();
+    uint32_t esperaUs = esperaHost(restante < UINT32_MAX ? (uint32_t)restante : UINT32_MAX);
+    bool reposo = esperaUs >= ESPERA_MINIMA_SLEEP_US;
+    for (uint8_t i = 0; i < CANTIDAD_TAREAS; i++)
+      reposo = reposo && tareas[i]->enReposo;
+    if (reposo)
+      durmiendoUs += esperaUs;
+    relojHost.avanzar(esperaUs);
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count();
+
+  double s = VENTANA_OCIO_US / 1e6;
+  Ocio o;
+  o.tactilS = (tactilHost.lecturas() - lecturas) / s;
+  o.pantallaS = (pantallaHost.operaciones() - operaciones) / s;
+  o.activacionesS = activaciones / s;
+  o.despierto = 100.0 * (VENTANA_OCIO_US - durmiendoUs) / VENTANA_OCIO_US;
+  o.hostNsPorS = ns / s;
+  printf("{\"ocio\":\"%s\",\"tactil_s\":%.1f,\"pantalla_s\":%.1f,\"activaciones_s\":%.1f,"
+         "\"despierto_pct\":%.1f,\"host_ns_por_s\":%.0f}\n",
+         caso, o.tactilS, o.pantallaS, o.activacionesS, o.despierto, o.hostNsPorS);
+  return o;
+}
+
+// Sin tocar nada, con la pantalla encendida y apagada: el muestreo por
+// sondeo (una lectura cada 20 ms, la interfaz siempre activa) contra el
+// que espera a PENIRQ. Con la pantalla encendida la interfaz sigue
+// despierta para dibujar; apagada, solo con PENIRQ se puede pausar.
+static void test_penirq_contra_sondeo_en_reposo()
+{
+  simularHost(1000000);
+  usarPenirq(false);
+  simularHost(1000000);
+  Ocio sondeo = medirOcio("sondeo pantalla on");
+  usarPenirq(true);
+  simularHost(1000000);
+  Ocio penirq = medirOcio("penirq pantalla on");
+  TEST_ASSERT_TRUE(sondeo.tactilS > 45.0);
+  TEST_ASSERT_TRUE(penirq.tactilS == 0.0);
+
+  pulsarHost(177, 280); // SLEEP
+  usarPenirq(false);
+  simularHost(1000000);
+  Ocio sondeoApagada = medirOcio("sondeo pantalla off");
+  usarPenirq(true);
+  simularHost(1000000);
+  Ocio penirqApagada = medirOcio("penirq pantalla off");
+  TEST_ASSERT_TRUE(sondeoApagada.tactilS > 45.0);
+  TEST_ASSERT_TRUE(penirqApagada.tactilS == 0.0);
+  TEST_ASSERT_TRUE(sondeoApagada.despierto > 99.0);
+  TEST_ASSERT_TRUE(penirqApagada.despierto < sondeoApagada.despierto);
+  TEST_ASSERT_TRUE(penirqApagada.activacionesS < sondeoApagada.activacionesS);
+  TEST_ASSERT_TRUE(penirqApagada.pantallaS == 0.0);
+
+  // El boton de SLEEP con la interfaz pausada la vuelve a activar
+  pulsarHost(177, 280);
+  TEST_ASSERT_TRUE(pantallaHost.encendida());
+}
+
+int main(int, char **)
+{
+  consolaHost.silenciar(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_reloj_da_la_vuelta_en_2_32);
+  RUN_TEST(test_archivos_ida_y_vuelta);
+  RUN_TEST(test_gpio_cuenta_cambios_de_las_salidas);
+  RUN_TEST(test_tactil_solo_lee_mientras_hay_dedo);
+  RUN_TEST(test_consola_cuenta_lineas_y_crc_aunque_este_silenciada);
+  RUN_TEST(test_aplicacion_controla_en_tiempo_virtual);
+  RUN_TEST(test_penirq_contra_sondeo_en_reposo);
+  return UNITY_END();
+}
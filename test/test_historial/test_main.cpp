@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <unity.h>
+#include <chrono>
+#include "aplicacion.h"
+#include "hal_host.h"
+#include "lazo_host.h"
+#include "registro_datos.h"
+#include "telemetria.h"
+
+// Descarga del registro con HIST por el PTY de BT, del lado del cliente:
+// la aplicacion arranca con un registro ya lleno en la flash emulada, se
+// pasa a TELEM BIN y se decodifican las tramas TRAMA_HIST que llegan
+
+void setUp() {}
+void tearDown() {}
+
+static const uint32_t LECTURAS_PREVIAS = 3000; // ~94 lotes en flash
+static const uint64_t PASO_US = 10000;         // Cada cuanto lee el cliente
+static const uint64_t LIMITE_US = 60000000ULL;
+
+static int cliente = -1; // Terminal del otro lado del PTY de BT
+
+static Lectura lectura(uint32_t i)
+{
+  Lectura l;
+  l.t = i * 2;
+  l.tempQ4[0] = (int16_t)(25 * 16 + (i % 16));
+  l.tempQ4[1] = (int16_t)(20 * 16 - (i % 8));
+  l.banderas = (uint8_t)(MUESTRA_SISTEMA | (i & 1));
+  return l;
+}
+
+static uint32_t microsPrueba() { return reloj.micros(); }
+
+// Lo que encontraria la aplicacion despues de correr unas horas: se escribe
+// con un registro propio y queda en el archivo que carga iniciarHal()
+static void llenarRegistro()
+{
+  static RegistroDatos previo(flashHost, microsPrueba);
+  TEST_ASSERT_TRUE(previo.begin());
+  for (uint32_t i = 0; i < LECTURAS_PREVIAS; i++)
+    previo.agregar(lectura(i));
+  previo.vaciar();
+  char ruta[128];
+  archivosHost.completar(ARCHIVO_FLASH_HOST, ruta, sizeof(ruta));
+  TEST_ASSERT_TRUE(flashHost.guardar(ruta));
+}
+
+// --- Cliente ---
+static DecodificadorTramas decodificador;
+static char texto[64]; // Respuesta de texto en curso (en BIN termina en 0x00)
+static size_t largoTexto = 0;
+static uint32_t bytesRecibidos = 0;
+static uint32_t lecturasRecibidas = 0;
+static uint32_t siguiente = 0; // Proxima lectura que se espera
+static uint32_t huecos = 0;    // Tramas que no empiezan donde termino la anterior
+static uint32_t distintas = 0; // Lecturas previas que no llegaron como se escribieron
+static bool finRecibido = false;
+static uint32_t proximaFin = 0;
+static bool stopRecibido = false;
+static uint32_t lecturaStop = 0;
+
+static uint32_t leerU32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void reiniciarCliente(uint32_t desde)
+{
+  largoTexto = 0;
+  bytesRecibidos = lecturasRecibidas = huecos = distintas = 0;
+  siguiente = desde;
+  finRecibido = stopRecibido = false;
+}
+
+static void procesarTrama()
+{
+  const uint8_t *carga = decodificador.carga();
+  if (decodificador.tipo() == TRAMA_HIST_FIN)
+  {
+    finRecibido = true;
+    proximaFin = leerU32(carga);
+    return;
+  }
+  if (decodificador.tipo() != TRAMA_HIST)
+    return;
+  uint32_t primera = leerU32(carga + 2);
+  size_t n = (decodificador.largoCarga() - HIST_CABECERA_BYTES) / MUESTRA_BYTES;
+  if (primera != siguiente)
+    huecos++;
+  for (size_t k = 0; k < n; k++)
+  {
+    Lectura l;
+    desempaquetarLectura(carga + HIST_CABECERA_BYTES + k * MUESTRA_BYTES, l);
+    Lectura e = lectura(primera + (uint32_t)k);
+    if (primera + k < LECTURAS_PREVIAS &&
+        (l.t != e.t || l.tempQ4[0] != e.tempQ4[0] || l.tempQ4[1] != e.tempQ4[1] || l.banderas != e.banderas))
+      distintas++;
+  }
+  siguiente = primera + (uint32_t)n;
+  lecturasRecibidas += (uint32_t)n;
+}
+
+static void recibir()
+{
+  uint8_t buf[256];
+  ssize_t leidos;
+  while (cliente >= 0 && (leidos = read(cliente, buf, sizeof(buf))) > 0)
+  {
+    bytesRecibidos += (uint32_t)leidos;
+    for (ssize_t i = 0; i < leidos; i++)
+    {
+      bool trama = decodificador.consumir(buf[i]);
+      if (trama)
+        procesarTrama();
+      if (buf[i] != 0)
+      {
+        if (largoTexto < sizeof(texto) - 1)
+          texto[largoTexto++] = (char)buf[i];
+        continue;
+      }
+      // Un 0x00 que no cerro una trama valida cierra una respuesta de texto
+      texto[largoTexto] = '\0';
+      const char *clave = "OK HIST STOP lectura=";
+      if (!trama && strncmp(texto, clave, strlen(clave)) == 0)
+      {
+        stopRecibido = true;
+        lecturaStop = (uint32_t)strtoul(texto + strlen(clave), nullptr, 10);
+      }
+      largoTexto = 0;
+    }
+  }
+}
+
+// Corre en tiempo virtual leyendo el PTY hasta que 'listo' o el limite
+static uint64_t correrHasta(bool (*listo)())
+{
+  uint64_t us = 0;
+  while (!listo() && us < LIMITE_US)
+  {
+    simularHost(PASO_US);
+    us += PASO_US;
+    recibir();
+  }
+  return us;
+}
+
+static bool descargaTerminada() { return finRecibido; }
+static bool stopConfirmado() { return stopRecibido; }
+static bool seisTramas() { return lecturasRecibidas >= 6 * HIST_LECTURAS; }
+
+static void arrancar()
+{
+  prepararHost("datos_test", 1000000);
+  llenarRegistro();
+  iniciarAplicacion();
+  iniciarTareasHost();
+  simularHost(500000);
+  pulsarHost(62, 280); // SISTEMA ON
+  pulsarHost(212, 20); // Bluetooth
+  cliente = abrirClienteBT();
+  simularHost(500000);
+  TEST_ASSERT_TRUE(enviarBT(cliente, "TELEM BIN\n"));
+  simularHost(100000);
+  recibir();
+}
+
+// Todo el registro de una vez. El caudal es en tiempo virtual, que es el que
+// marca el firmware (una trama por vuelta de la tarea bt); aparte va el de
+// la CPU del host.
+static void test_descarga_completa_sin_huecos()
+{
+  arrancar();
+  TEST_ASSERT_NOT_EQUAL(-1, cliente);
+  reiniciarCliente(0);
+  TEST_ASSERT_TRUE(enviarBT(cliente, "HIST 0\n"));
+  auto inicio = std::chrono::steady_clock::now();
+  uint64_t us = correrHasta(descargaTerminada);
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  TEST_ASSERT_TRUE(finRecibido);
+  TEST_ASSERT_EQUAL_UINT32(0, huecos);
+  TEST_ASSERT_EQUAL_UINT32(0, distintas);
+  TEST_ASSERT_EQUAL_UINT32(siguiente, proximaFin);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(LECTURAS_PREVIAS, lecturasRecibidas);
+  printf("{\"hist\":\"pty\",\"lecturas\":%lu,\"bytes\":%lu,\"lecturas_s\":%.0f,\"bytes_s\":%.0f,"
+         "\"lecturas_s_host\":%.0f}\n",
+         (unsigned long)lecturasRecibidas, (unsigned long)bytesRecibidos, lecturasRecibidas * 1e6 / us,
+         bytesRecibidos * 1e6 / us, s > 0 ? lecturasRecibidas / s : 0.0);
+}
+
+// HIST STOP a mitad de camino y HIST desde la que sigue a la ultima
+// recibida: lo que ya estaba en la cola llega igual y la descarga retoma
+// justo ahi, sin huecos ni repetidas
+static void test_stop_y_retomar_sin_huecos()
+{
+  TEST_ASSERT_NOT_EQUAL(-1, cliente);
+  reiniciarCliente(0);
+  TEST_ASSERT_TRUE(enviarBT(cliente, "HIST 0\n"));
+  correrHasta(seisTramas);
+  TEST_ASSERT_TRUE(enviarBT(cliente, "HIST STOP\n"));
+  correrHasta(stopConfirmado);
+  TEST_ASSERT_TRUE(stopRecibido);
+  simularHost(200000);
+  recibir();
+  TEST_ASSERT_EQUAL_UINT32(lecturaStop, siguiente);
+  TEST_ASSERT_LESS_THAN_UINT32(LECTURAS_PREVIAS, siguiente);
+
+  char linea[24];
+  snprintf(linea, sizeof(linea), "HIST %lu\n", (unsigned long)siguiente);
+  TEST_ASSERT_TRUE(enviarBT(cliente, linea));
+  correrHasta(descargaTerminada);
+  TEST_ASSERT_TRUE(finRecibido);
+  TEST_ASSERT_EQUAL_UINT32(0, huecos);
+  TEST_ASSERT_EQUAL_UINT32(0, distintas);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(LECTURAS_PREVIAS, siguiente);
+}
+
+int main(int, char **)
+{
+  consolaHost.silenciar(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_descarga_completa_sin_huecos);
+  RUN_TEST(test_stop_y_retomar_sin_huecos);
+  if (cliente >= 0)
+    close(cliente);
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <unity.h>
+#include "aplicacion.h"
+#include "hal_host.h"
+#include "lazo_host.h"
+#include "memoria.h"
+
+// Pasado el arranque la aplicacion no pide memoria (memoria.h): sensores,
+// control, pantalla, registro, reportes y comandos por BT corren horas en
+// tiempo virtual sin un solo pedido al heap, sea operator new o malloc
+
+void setUp() {}
+void tearDown() {}
+
+static const uint64_t MINUTO_US = 60000000ULL;
+static int cliente = -1; // Terminal del otro lado del PTY de BT
+
+static uint32_t recibidos = 0; // Bytes que mando la aplicacion por BT
+
+static void descartarSalida()
+{
+  char buf[256];
+  ssize_t n;
+  while (cliente >= 0 && (n = read(cliente, buf, sizeof(buf))) > 0)
+    recibidos += (uint32_t)n;
+}
+
+// Una hora de operacion: la temperatura cruza la consigna cada 10 minutos y
+// por BT llegan comandos de consulta y de ajuste
+static void operarUnaHora()
+{
+  for (uint32_t m = 0; m < 60; m++)
+  {
+    int16_t q4 = (m / 10) % 2 ? 27 * 16 : 23 * 16;
+    sensoresHost.fijar(0, q4);
+    sensoresHost.fijar(1, (int16_t)(q4 + 8));
+    if (m % 15 == 0)
+    {
+      TEST_ASSERT_TRUE(enviarBT(cliente, "ESTADO\n"));
+      TEST_ASSERT_TRUE(enviarBT(cliente, "SP 1 25.5\n"));
+      TEST_ASSERT_TRUE(enviarBT(cliente, "TAREAS\n"));
+      TEST_ASSERT_TRUE(enviarBT(cliente, "MEM\n"));
+    }
+    simularHost(MINUTO_US);
+    descartarSalida();
+  }
+}
+
+static void arrancar()
+{
+  prepararHost("datos_test", 1000000);
+  iniciarAplicacion();
+  iniciarTareasHost();
+  simularHost(500000);
+  pulsarHost(62, 280); // SISTEMA ON
+  pulsarHost(212, 20); // Bluetooth
+  cliente = abrirClienteBT();
+  TEST_ASSERT_NOT_EQUAL(-1, cliente);
+  TEST_ASSERT_TRUE(enviarBT(cliente, "SUB ESTADO 2000\n"));
+}
+
+static void test_sin_asignaciones_en_regimen()
+{
+  arrancar();
+  operarUnaHora(); // Calentamiento: lo que se reserva una sola vez
+  uint32_t antes = asignaciones();
+  uint32_t liberadasAntes = liberaciones();
+  uint32_t conversiones = sensoresHost.conversiones();
+  uint32_t k1 = gpioHost.cambios(PIN_RELE1);
+  uint32_t programados = flashHost.bytesProgramados();
+  uint32_t recibidosAntes = recibidos;
+
+  for (uint8_t h = 0; h < 6; h++)
+  {
+    operarUnaHora();
+    if (h == 2)
+      pulsarHost(177, 280); // Pantalla a dormir y de vuelta
+    if (h == 3)
+      pulsarHost(120, 160);
+  }
+
+  // Que realmente haya corrido todo
+  TEST_ASSERT_UINT32_WITHIN(10, conversiones + 6 * 1800, sensoresHost.conversiones());
+  TEST_ASSERT_GREATER_THAN_UINT32(k1, gpioHost.cambios(PIN_RELE1));
+  TEST_ASSERT_GREATER_THAN_UINT32(programados, flashHost.bytesProgramados());
+  TEST_ASSERT_NOT_EQUAL(-1, cliente);
+  TEST_ASSERT_GREATER_THAN_UINT32(recibidosAntes, recibidos);
+  TEST_ASSERT_EQUAL_UINT32(antes, asignaciones());
+  TEST_ASSERT_EQUAL_UINT32(liberadasAntes, liberaciones());
+}
+
+// Lo que hace String al crecer (realloc) y Print::printf con lineas largas
+// (malloc) tiene que verse igual que un operator new
+static void *volatile bloque = nullptr;
+
+static void test_cuenta_malloc_realloc_y_free()
+{
+  uint32_t antes = asignaciones();
+  uint32_t liberadasAntes = liberaciones();
+  bloque = malloc(16);
+  bloque = realloc(bloque, 64);
+  free(bloque);
+  bloque = calloc(4, 8);
+  bloque = realloc(bloque, 0);
+  TEST_ASSERT_EQUAL_UINT32(antes + 3, asignaciones());
+  TEST_ASSERT_EQUAL_UINT32(liberadasAntes + 2, liberaciones());
+
+  int *volatile entero = new int(5);
+  delete entero;
+  TEST_ASSERT_EQUAL_UINT32(antes + 4, asignaciones());
+  TEST_ASSERT_EQUAL_UINT32(liberadasAntes + 3, liberaciones());
+}
+
+int main(int, char **)
+{
+  consolaHost.silenciar(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_cuenta_malloc_realloc_y_free);
+  RUN_TEST(test_sin_asignaciones_en_regimen);
+  if (cliente >= 0)
+    close(cliente);
+  return UNITY_END();
+}
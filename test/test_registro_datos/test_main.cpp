@@ -0,0 +1,231 @@
+#include <unity.h>
+#include "flash_emulada.h"
+#include "registro_datos.h"
+
+// Registro sobre una flash emulada que puede negarse a borrar o quedarse sin
+// energia a mitad de una escritura
+
+void setUp() {}
+void tearDown() {}
+
+class FlashConFallas : public FlashEmulada
+{
+public:
+  explicit FlashConFallas(uint32_t tamano) : FlashEmulada(tamano), fallarBorrado(false), cruces(0) {}
+
+  bool escribir(uint32_t dir, const void *datos, size_t len) override
+  {
+    if (dir % TAM_SECTOR + len > TAM_SECTOR)
+      cruces++;
+    return FlashEmulada::escribir(dir, datos, len);
+  }
+  bool borrarSector(uint32_t dir) override { return !fallarBorrado && FlashEmulada::borrarSector(dir); }
+
+  bool fallarBorrado;
+  uint32_t cruces; // Escrituras que pasan el fin de un sector
+};
+
+static const uint32_t SECTORES = 4;
+static uint32_t relojPrueba() { return 0; }
+
+static Lectura lectura(uint32_t i)
+{
+  Lectura l;
+  l.t = i * 2;
+  l.tempQ4[0] = (int16_t)(25 * 16 + (i % 16));
+  l.tempQ4[1] = (int16_t)(20 * 16 - (i % 8));
+  l.banderas = (uint8_t)(i & 1);
+  return l;
+}
+
+static void agregarLotes(RegistroDatos &registro, uint32_t &proxima, uint32_t lotes)
+{
+  for (uint32_t i = 0; i < lotes * RegistroDatos::LECTURAS_POR_LOTE; i++)
+    registro.agregar(lectura(proxima++));
+}
+
+// Lo que se agrega mientras se espera un corte de energia lleva otros
+// valores: un lote a medias sin cerrar no puede pasar por lo que se agregue
+// despues sobre el mismo lugar
+static Lectura lecturaAlterada(uint32_t i)
+{
+  Lectura l = lectura(i);
+  l.tempQ4[0] ^= 0x155;
+  return l;
+}
+
+// Cada indice disponible se lee con la lectura que le corresponde (alterada
+// en [alteradasDesde, alteradasHasta))
+static void verificarContenido(RegistroDatos &registro, uint32_t alteradasDesde = 0, uint32_t alteradasHasta = 0)
+{
+  for (uint32_t i = registro.inicio(); i < registro.fin();)
+  {
+    Lectura l[RegistroDatos::LECTURAS_POR_LOTE];
+    size_t n = registro.leer(i, l, RegistroDatos::LECTURAS_POR_LOTE);
+    TEST_ASSERT_GREATER_THAN(0, n);
+    for (size_t k = 0; k < n; k++)
+    {
+      uint32_t j = i + (uint32_t)k;
+      Lectura e = j >= alteradasDesde && j < alteradasHasta ? lecturaAlterada(j) : lectura(j);
+      TEST_ASSERT_EQUAL_UINT32(e.t, l[k].t);
+      TEST_ASSERT_EQUAL_INT16(e.tempQ4[0], l[k].tempQ4[0]);
+      TEST_ASSERT_EQUAL_INT16(e.tempQ4[1], l[k].tempQ4[1]);
+    }
+    i += (uint32_t)n;
+  }
+}
+
+static void test_agrega_y_lee_a_traves_de_la_rotacion()
+{
+  FlashConFallas flash(SECTORES * MemoriaFlash::TAM_SECTOR);
+  RegistroDatos registro(flash, relojPrueba);
+  TEST_ASSERT_TRUE(registro.begin());
+  uint32_t proxima = 0;
+  agregarLotes(registro, proxima, 250); // ~42 lotes por segmento: da mas de una vuelta
+  TEST_ASSERT_EQUAL_UINT32(0, flash.cruces);
+  TEST_ASSERT_EQUAL_UINT32(0, registro.estadisticas().errores);
+  TEST_ASSERT_EQUAL_UINT32(proxima, registro.fin());
+  TEST_ASSERT_GREATER_THAN_UINT32(0, registro.inicio());
+  verificarContenido(registro);
+}
+
+// Si el borrado del segmento siguiente falla, el activo queda sellado y los
+// lotes se pierden (contados en errores) sin pasar nunca al sector siguiente
+static void test_borrado_fallido_sella_sin_cruzar_el_sector()
+{
+  FlashConFallas flash(SECTORES * MemoriaFlash::TAM_SECTOR);
+  RegistroDatos registro(flash, relojPrueba);
+  TEST_ASSERT_TRUE(registro.begin());
+  flash.fallarBorrado = true;
+  uint32_t proxima = 0;
+  agregarLotes(registro, proxima, 60); // Mas de lo que entra en un segmento
+
+  TEST_ASSERT_EQUAL_UINT32(0, flash.cruces);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, registro.estadisticas().errores);
+  uint32_t fin = registro.fin();
+  TEST_ASSERT_LESS_THAN_UINT32(proxima, fin);
+  TEST_ASSERT_EQUAL_UINT32(registro.estadisticas().lotes * RegistroDatos::LECTURAS_POR_LOTE, fin);
+  verificarContenido(registro);
+
+  // Vuelve el borrado: rota en el proximo lote y sigue sin huecos de indice
+  flash.fallarBorrado = false;
+  uint32_t perdidas = proxima - fin;
+  agregarLotes(registro, proxima, 10);
+  TEST_ASSERT_EQUAL_UINT32(0, flash.cruces);
+  TEST_ASSERT_EQUAL_UINT32(fin + 10 * RegistroDatos::LECTURAS_POR_LOTE, registro.fin());
+
+  // Despues de un reinicio se recupera lo mismo
+  RegistroDatos reinicio(flash, relojPrueba);
+  TEST_ASSERT_TRUE(reinicio.begin());
+  TEST_ASSERT_EQUAL_UINT32(registro.inicio(), reinicio.inicio());
+  TEST_ASSERT_EQUAL_UINT32(registro.fin(), reinicio.fin());
+  Lectura l;
+  TEST_ASSERT_EQUAL_UINT32(1, reinicio.leer(fin, &l, 1));
+  TEST_ASSERT_EQUAL_UINT32(lectura(fin + perdidas).t, l.t);
+}
+
+// Un lote a medio llenar se lee, se busca y se resume desde RAM: consultar
+// no escribe nada en flash
+static void test_consultas_incluyen_el_lote_en_ram()
+{
+  FlashConFallas flash(SECTORES * MemoriaFlash::TAM_SECTOR);
+  RegistroDatos registro(flash, relojPrueba);
+  TEST_ASSERT_TRUE(registro.begin());
+  uint32_t proxima = 0;
+  agregarLotes(registro, proxima, 2);
+  for (uint8_t i = 0; i < 10; i++)
+    registro.agregar(lectura(proxima++));
+  uint32_t escritos = registro.estadisticas().bytesEscritos;
+
+  TEST_ASSERT_EQUAL_UINT32(proxima, registro.fin());
+  verificarContenido(registro);
+  TEST_ASSERT_EQUAL_UINT32(proxima - 3, registro.buscarMarca(lectura(proxima - 3).t));
+  TEST_ASSERT_EQUAL_UINT32(proxima, registro.buscarMarca(lectura(proxima).t));
+
+  // Entero, desde la mitad y cruzando de flash a RAM
+  const uint32_t desdes[] = {64, 69, 60};
+  for (uint32_t desde : desdes)
+  {
+    ResumenLecturas r, esperado;
+    registro.resumir(desde, proxima, r);
+    esperado.minQ4[0] = esperado.minQ4[1] = INT16_MAX;
+    esperado.maxQ4[0] = esperado.maxQ4[1] = INT16_MIN;
+    for (uint32_t i = desde; i < proxima; i++)
+    {
+      Lectura l = lectura(i);
+      for (uint8_t c = 0; c < 2; c++)
+      {
+        if (l.tempQ4[c] < esperado.minQ4[c])
+          esperado.minQ4[c] = l.tempQ4[c];
+        if (l.tempQ4[c] > esperado.maxQ4[c])
+          esperado.maxQ4[c] = l.tempQ4[c];
+      }
+    }
+    TEST_ASSERT_EQUAL_INT16(esperado.minQ4[0], r.minQ4[0]);
+    TEST_ASSERT_EQUAL_INT16(esperado.maxQ4[0], r.maxQ4[0]);
+    TEST_ASSERT_EQUAL_INT16(esperado.minQ4[1], r.minQ4[1]);
+    TEST_ASSERT_EQUAL_INT16(esperado.maxQ4[1], r.maxQ4[1]);
+  }
+  TEST_ASSERT_EQUAL_UINT32(escritos, registro.estadisticas().bytesEscritos);
+  TEST_ASSERT_EQUAL_UINT32(2, registro.estadisticas().lotes);
+
+  // Al completarse, el lote va a flash con los mismos indices
+  agregarLotes(registro, proxima, 1);
+  TEST_ASSERT_EQUAL_UINT32(3, registro.estadisticas().lotes);
+  verificarContenido(registro);
+}
+
+// Corte de energia en distintos bytes de las escrituras (lote, cabecera de
+// segmento al rotar): al volver, un registro nuevo descarta el lote a
+// medias, cierra ese segmento y sigue en el proximo sin huecos de indice
+static void test_corte_de_energia_a_mitad_de_escritura()
+{
+  uint32_t sellados = 0;
+  for (uint32_t corte = 0; corte < 1600; corte += 7) // Lotes de ~40 bytes
+  {
+    FlashConFallas flash(SECTORES * MemoriaFlash::TAM_SECTOR);
+    RegistroDatos registro(flash, relojPrueba);
+    TEST_ASSERT_TRUE(registro.begin());
+    uint32_t proxima = 0;
+    agregarLotes(registro, proxima, 30); // Cerca del fin del primer segmento
+    uint32_t antes = proxima;
+    flash.programarCorte(corte);
+    for (uint32_t i = 0; i < 20 * RegistroDatos::LECTURAS_POR_LOTE && !flash.sinEnergia(); i++)
+      registro.agregar(lecturaAlterada(proxima++));
+    TEST_ASSERT_TRUE(flash.sinEnergia());
+    uint32_t escritas = registro.estadisticas().lotes * RegistroDatos::LECTURAS_POR_LOTE;
+    flash.restaurarEnergia();
+
+    RegistroDatos reinicio(flash, relojPrueba);
+    TEST_ASSERT_TRUE(reinicio.begin());
+    TEST_ASSERT_EQUAL_UINT32(escritas, reinicio.fin());
+    sellados += reinicio.estadisticas().sellados;
+    verificarContenido(reinicio, antes, escritas);
+
+    // Lo que sigue continua el indice y pasa del segmento cerrado al proximo
+    proxima = reinicio.fin();
+    agregarLotes(reinicio, proxima, 50);
+    TEST_ASSERT_EQUAL_UINT32(0, reinicio.estadisticas().errores);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.cruces);
+    TEST_ASSERT_EQUAL_UINT32(proxima, reinicio.fin());
+    verificarContenido(reinicio, antes, escritas);
+
+    RegistroDatos otro(flash, relojPrueba);
+    TEST_ASSERT_TRUE(otro.begin());
+    TEST_ASSERT_EQUAL_UINT32(reinicio.inicio(), otro.inicio());
+    TEST_ASSERT_EQUAL_UINT32(proxima, otro.fin());
+    TEST_ASSERT_EQUAL_UINT32(0, otro.estadisticas().sellados);
+  }
+  // La mayoria de los cortes caen dentro de un lote
+  TEST_ASSERT_GREATER_THAN_UINT32(150, sellados);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_agrega_y_lee_a_traves_de_la_rotacion);
+  RUN_TEST(test_borrado_fallido_sella_sin_cruzar_el_sector);
+  RUN_TEST(test_consultas_incluyen_el_lote_en_ram);
+  RUN_TEST(test_corte_de_energia_a_mitad_de_escritura);
+  return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <math.h>
+#include <string>
+#include <unity.h>
+#include "memoria.h"
+#include "reporte.h"
+
+// formatearReporte() contra el reporte que armaba enviarReporteEstado() con
+// String: tiene que salir byte a byte igual y sin pedir memoria
+
+void setUp() {}
+void tearDown() {}
+
+// dtostrf() del core de Arduino para el ESP32 (stdlib_noniso.c), que es lo
+// que usa String(valor, 1) con ancho 3
+static char *dtostrfArduino(double number, signed int width, unsigned int prec, char *s)
+{
+  bool negative = false;
+  if (isnan(number))
+  {
+    strcpy(s, "nan");
+    return s;
+  }
+  if (isinf(number))
+  {
+    strcpy(s, "inf");
+    return s;
+  }
+  char *out = s;
+  int fillme = width;
+  if (prec > 0)
+    fillme -= (prec + 1);
+  if (number < 0.0)
+  {
+    negative = true;
+    fillme--;
+    number = -number;
+  }
+  double rounding = 2.0;
+  for (uint8_t i = 0; i < prec; ++i)
+    rounding *= 10.0;
+  rounding = 1.0 / rounding;
+  number += rounding;
+  double tenpow = 1.0;
+  int digitcount = 1;
+  while (number >= 10.0 * tenpow)
+  {
+    tenpow *= 10.0;
+    digitcount++;
+  }
+  number /= tenpow;
+  fillme -= digitcount;
+  while (fillme-- > 0)
+    *out++ = ' ';
+  if (negative)
+    *out++ = '-';
+  digitcount += prec;
+  int8_t digit = 0;
+  while (digitcount-- > 0)
+  {
+    digit = (int8_t)number;
+    if (digit > 9)
+      digit = 9;
+    *out++ = (char)('0' | digit);
+    if ((digitcount == (int)prec) && (prec > 0))
+      *out++ = '.';
+    number -= digit;
+    number *= 10.0;
+  }
+  *out = 0;
+  return s;
+}
+
+static std::string celsiusString(float t)
+{
+  char buf[33];
+  return dtostrfArduino(t, 3, 1, buf);
+}
+
+// El armado original con String, con std::string en su lugar
+static std::string reporteString(const DatosReporte &d)
+{
+  std::string reporte = "\n--- REPORTE ESP32 ---\n";
+  reporte += "S1: " + (!d.valida[0] ? std::string("ERR") : celsiusString(d.tempQ4[0] / 16.0f) + "C") + " | ";
+  reporte += "S2: " + (!d.valida[1] ? std::string("ERR") : celsiusString(d.tempQ4[1] / 16.0f) + "C") + "\n";
+  reporte += "Reles: K1=" + std::string(d.k1 ? "ON" : "OFF") + " K2=" + std::string(d.k2 ? "ON" : "OFF") + "\n";
+  reporte += "Tactil: " + std::string(d.sistema ? "ENCENDIDO" : "APAGADO") + "\n";
+  reporte += "Pantalla: " + std::string(d.pantalla ? "ON" : "SLEEP") + "\n";
+  reporte += "---------------------\n";
+  return reporte;
+}
+
+static DatosReporte datos(int32_t q4a, int32_t q4b, uint8_t banderas)
+{
+  DatosReporte d;
+  d.tempQ4[0] = (int16_t)q4a;
+  d.tempQ4[1] = (int16_t)q4b;
+  d.valida[0] = !(banderas & 0x40);
+  d.valida[1] = !(banderas & 0x80);
+  d.k1 = banderas & 1;
+  d.k2 = banderas & 2;
+  d.sistema = banderas & 4;
+  d.pantalla = banderas & 8;
+  return d;
+}
+
+static void verificarIgual(const DatosReporte &d)
+{
+  char buf[TAM_REPORTE];
+  size_t n = formatearReporte(buf, sizeof(buf), d);
+  std::string esperado = reporteString(d);
+  TEST_ASSERT_EQUAL_size_t(esperado.size(), n);
+  TEST_ASSERT_EQUAL_STRING(esperado.c_str(), buf);
+}
+
+static void test_reporte_fijo()
+{
+  char buf[TAM_REPORTE];
+  formatearReporte(buf, sizeof(buf), datos(393, -1, 1 | 4 | 8)); // 24.5625 y -0.0625
+  TEST_ASSERT_EQUAL_STRING("\n--- REPORTE ESP32 ---\n"
+                           "S1: 24.6C | S2: -0.1C\n"
+                           "Reles: K1=ON K2=OFF\n"
+                           "Tactil: ENCENDIDO\n"
+                           "Pantalla: ON\n"
+                           "---------------------\n",
+                           buf);
+  formatearReporte(buf, sizeof(buf), datos(0, 0, 2 | 0x40 | 0x80));
+  TEST_ASSERT_EQUAL_STRING("\n--- REPORTE ESP32 ---\n"
+                           "S1: ERR | S2: ERR\n"
+                           "Reles: K1=OFF K2=ON\n"
+                           "Tactil: APAGADO\n"
+                           "Pantalla: SLEEP\n"
+                           "---------------------\n",
+                           buf);
+}
+
+// Todo el rango de un DS18B20 de 12 bits, de a 1/16 C, con las banderas
+// rotando; los empates de dtostrf (x.25/x.75 con tres digitos) incluidos
+static void test_igual_a_string_en_todo_el_rango()
+{
+  for (int32_t q4 = -55 * 16; q4 <= 125 * 16; q4++)
+    verificarIgual(datos(q4, 125 * 16 - q4 - 55 * 16, (uint8_t)q4));
+  verificarIgual(datos(-2020, -127 * 16, 0)); // -126.25 y el -127 de un sensor caido
+  verificarIgual(datos(85 * 16, 159, 0xFF & ~0xC0));
+}
+
+// Hasta el borde de la tabla de empates, fuera del rango del sensor
+static void test_igual_a_string_hasta_128_grados()
+{
+  for (int32_t q4 = -128 * 16 + 1; q4 < 128 * 16; q4++)
+    verificarIgual(datos(q4, -q4 - 1, (uint8_t)q4 & 0x0F));
+}
+
+static void test_trunca_sin_pasarse()
+{
+  char buf[32];
+  memset(buf, 'x', sizeof(buf));
+  size_t n = formatearReporte(buf, 20, datos(392, 408, 0));
+  TEST_ASSERT_EQUAL_size_t(19, n);
+  TEST_ASSERT_EQUAL_UINT8('\0', buf[19]);
+  TEST_ASSERT_EQUAL_UINT8('x', buf[20]);
+  TEST_ASSERT_EQUAL_MEMORY(reporteString(datos(392, 408, 0)).c_str(), buf, 19);
+}
+
+static void test_sin_asignaciones()
+{
+  char buf[TAM_REPORTE];
+  // El contador ve las del armado con String...
+  uint32_t antes = asignaciones();
+  std::string viejo = reporteString(datos(392, 408, 0x0F));
+  TEST_ASSERT_GREATER_THAN_UINT32(antes, asignaciones());
+
+  // ...y el buffer fijo no pide nada
+  antes = asignaciones();
+  size_t total = 0;
+  for (int32_t q4 = -55 * 16; q4 <= 125 * 16; q4++)
+    total += formatearReporte(buf, sizeof(buf), datos(q4, q4 * 2, (uint8_t)q4));
+  TEST_ASSERT_EQUAL_UINT32(antes, asignaciones());
+  TEST_ASSERT_GREATER_THAN(0, total);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_reporte_fijo);
+  RUN_TEST(test_igual_a_string_en_todo_el_rango);
+  RUN_TEST(test_igual_a_string_hasta_128_grados);
+  RUN_TEST(test_trunca_sin_pasarse);
+  RUN_TEST(test_sin_asignaciones);
+  return UNITY_END();
+}
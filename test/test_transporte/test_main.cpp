@@ -0,0 +1,307 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <unity.h>
+#include <algorithm>
+#include "aplicacion.h"
+#include "hal_host.h"
+#include "lazo_host.h"
+#include "transporte_host.h"
+
+// TransporteHost en sus dos modos: eventos de conexion, desconexion,
+// reconexion y congestion vistos por el manejador, y la aplicacion entera
+// respondiendo ESTADO por el PTY de BT en tiempo virtual
+
+void setUp() {}
+void tearDown() {}
+
+static const int ESPERA_KERNEL_MS = 2; // El pty pasa los bytes al otro lado en diferido
+
+// --- Eventos ---
+static EventoTransporte eventos[16];
+static uint8_t cantidadEventos = 0;
+
+static void registrarEvento(EventoTransporte evento)
+{
+  if (cantidadEventos < sizeof(eventos) / sizeof(eventos[0]))
+    eventos[cantidadEventos] = evento;
+  cantidadEventos++;
+}
+
+static uint8_t contarEventos(EventoTransporte evento)
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < cantidadEventos && i < sizeof(eventos) / sizeof(eventos[0]); i++)
+    n += eventos[i] == evento;
+  return n;
+}
+
+// --- Cliente ---
+static int abrirCliente(TransporteHost &t, TransporteHost::Modo modo)
+{
+  if (modo == TransporteHost::PTY)
+    return abrirClientePty(t.rutaPty());
+  int fd = t.conectarCliente();
+  if (fd >= 0)
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+// Como un cliente remoto que corta: en PAR_SOCKETS lo cierra el arnes
+static void cerrarCliente(TransporteHost &t, TransporteHost::Modo modo, int fd)
+{
+  if (modo == TransporteHost::PTY)
+    close(fd);
+  else
+    t.desconectarCliente();
+}
+
+static bool esperarEntrada(TransporteHost &t, int n)
+{
+  for (uint8_t i = 0; i < 50 && t.disponible() < n; i++)
+    usleep(ESPERA_KERNEL_MS * 1000);
+  return t.disponible() >= n;
+}
+
+// Lo que haya del lado del cliente, esperando hasta 'esperaMs' al primer byte
+static size_t leerCliente(int fd, char *buf, size_t max, int esperaMs)
+{
+  struct pollfd p = {fd, POLLIN, 0};
+  if (poll(&p, 1, esperaMs) <= 0)
+    return 0;
+  ssize_t n = read(fd, buf, max);
+  return n > 0 ? (size_t)n : 0;
+}
+
+static void probarConexiones(TransporteHost::Modo modo)
+{
+  TransporteHost t(modo);
+  cantidadEventos = 0;
+  t.alEvento(registrarEvento);
+  TEST_ASSERT_TRUE(t.iniciar("prueba"));
+  TEST_ASSERT_FALSE(t.hayCliente());
+  TEST_ASSERT_EQUAL_UINT8(0, cantidadEventos);
+
+  // La segunda vuelta es la reconexion: los mismos eventos otra vez
+  for (uint8_t vuelta = 0; vuelta < 2; vuelta++)
+  {
+    int cliente = abrirCliente(t, modo);
+    TEST_ASSERT_NOT_EQUAL(-1, cliente);
+    TEST_ASSERT_TRUE(t.hayCliente());
+    TEST_ASSERT_TRUE(t.hayCliente());
+    TEST_ASSERT_EQUAL_UINT8(2 * vuelta + 1, cantidadEventos);
+    TEST_ASSERT_EQUAL_UINT8(TRANSPORTE_CONECTADO, eventos[2 * vuelta]);
+
+    TEST_ASSERT_EQUAL_INT(4, (int)write(cliente, "HOLA", 4));
+    TEST_ASSERT_TRUE(esperarEntrada(t, 4));
+    TEST_ASSERT_EQUAL_INT('H', t.leer());
+    TEST_ASSERT_EQUAL_INT(3, t.disponible());
+    TEST_ASSERT_EQUAL_UINT32(2, t.escribir((const uint8_t *)"OK", 2));
+    char buf[8];
+    TEST_ASSERT_EQUAL_UINT32(2, leerCliente(cliente, buf, sizeof(buf), 100));
+    TEST_ASSERT_EQUAL_MEMORY("OK", buf, 2);
+
+    cerrarCliente(t, modo, cliente);
+    TEST_ASSERT_FALSE(t.hayCliente());
+    TEST_ASSERT_EQUAL_UINT8(2 * vuelta + 2, cantidadEventos);
+    TEST_ASSERT_EQUAL_UINT8(TRANSPORTE_DESCONECTADO, eventos[2 * vuelta + 1]);
+    // Sin cliente no se acepta nada ni queda entrada vieja
+    TEST_ASSERT_EQUAL_UINT32(0, t.escribir((const uint8_t *)"OK", 2));
+    TEST_ASSERT_EQUAL_INT(0, t.disponible());
+  }
+  t.detener();
+}
+
+static void test_sockets_conecta_desconecta_y_reconecta() { probarConexiones(TransporteHost::PAR_SOCKETS); }
+static void test_pty_conecta_desconecta_y_reconecta() { probarConexiones(TransporteHost::PTY); }
+
+// Un cliente que no lee: el kernel se llena y se avisa una sola vez. Al
+// drenar, el sondeo de hayCliente() avisa que se descongestiono sin que
+// haga falta otra escritura (la aplicacion no escribe mientras tanto)
+static void probarCongestion(TransporteHost::Modo modo)
+{
+  TransporteHost t(modo);
+  cantidadEventos = 0;
+  t.alEvento(registrarEvento);
+  TEST_ASSERT_TRUE(t.iniciar("prueba"));
+  int cliente = abrirCliente(t, modo);
+  TEST_ASSERT_NOT_EQUAL(-1, cliente);
+  TEST_ASSERT_TRUE(t.hayCliente());
+
+  uint8_t bloque[256];
+  memset(bloque, 'x', sizeof(bloque));
+  uint32_t aceptados = 0;
+  for (uint32_t i = 0; i < 100000 && t.escribir(bloque, sizeof(bloque)) > 0; i++)
+    aceptados++;
+  TEST_ASSERT_GREATER_THAN_UINT32(0, aceptados);
+  TEST_ASSERT_EQUAL_UINT32(0, t.escribir(bloque, sizeof(bloque)));
+  TEST_ASSERT_EQUAL_UINT8(1, contarEventos(TRANSPORTE_CONGESTIONADO));
+  TEST_ASSERT_TRUE(t.hayCliente());
+
+  char buf[4096];
+  while (leerCliente(cliente, buf, sizeof(buf), 20) > 0)
+    ;
+  TEST_ASSERT_TRUE(t.hayCliente());
+  TEST_ASSERT_EQUAL_UINT8(1, contarEventos(TRANSPORTE_DESCONGESTIONADO));
+  TEST_ASSERT_EQUAL_UINT8(TRANSPORTE_DESCONGESTIONADO, eventos[cantidadEventos - 1]);
+  TEST_ASSERT_EQUAL_UINT32(1, t.escribir(bloque, 1));
+  TEST_ASSERT_EQUAL_UINT8(1, contarEventos(TRANSPORTE_DESCONGESTIONADO));
+
+  cerrarCliente(t, modo, cliente);
+  TEST_ASSERT_FALSE(t.hayCliente());
+  t.detener();
+}
+
+static void test_sockets_congestion() { probarCongestion(TransporteHost::PAR_SOCKETS); }
+static void test_pty_congestion() { probarCongestion(TransporteHost::PTY); }
+
+// --- Aplicacion por el PTY de BT ---
+static const uint64_t PASO_US = 250;
+static const char FIN_REPORTE[] = "---------------------\n";
+static int clienteBT = -1;
+static char salida[2048];
+static size_t largoSalida = 0;
+
+static void limpiarSalida()
+{
+  largoSalida = 0;
+  salida[0] = '\0';
+}
+
+static void recibir(int esperaMs)
+{
+  size_t n;
+  while ((n = leerCliente(clienteBT, salida + largoSalida, sizeof(salida) - 1 - largoSalida, esperaMs)) > 0)
+  {
+    largoSalida += n;
+    esperaMs = 0;
+  }
+  salida[largoSalida] = '\0';
+}
+
+static uint8_t contarReportes()
+{
+  uint8_t n = 0;
+  for (const char *p = salida; (p = strstr(p, FIN_REPORTE)) != nullptr; p += sizeof(FIN_REPORTE) - 1)
+    n++;
+  return n;
+}
+
+// Paso a paso en tiempo virtual hasta 'reportes' reportes completos.
+// Devuelve los us virtuales que tardaron (o limiteUs si no llegaron).
+static uint64_t esperarReportes(uint8_t reportes, uint64_t limiteUs)
+{
+  uint64_t us = 0;
+  while (contarReportes() < reportes && us < limiteUs)
+  {
+    simularHost(PASO_US);
+    us += PASO_US;
+    recibir(ESPERA_KERNEL_MS);
+  }
+  return us;
+}
+
+static void conectarBT()
+{
+  clienteBT = abrirClienteBT();
+  limpiarSalida();
+}
+
+static void arrancar()
+{
+  prepararHost("datos_test", 1000000);
+  iniciarAplicacion();
+  iniciarTareasHost();
+  simularHost(500000);
+  pulsarHost(62, 280); // SISTEMA ON
+  pulsarHost(212, 20); // Bluetooth
+}
+
+// Al conectar llega el reporte de bienvenida; al reconectar tambien, y sin
+// las suscripciones que tenia el cliente anterior
+static void test_aplicacion_ve_conexion_y_reconexion()
+{
+  conectarBT();
+  TEST_ASSERT_NOT_EQUAL(-1, clienteBT);
+  TEST_ASSERT_LESS_THAN_UINT32(1000000, (uint32_t)esperarReportes(1, 1000000));
+
+  TEST_ASSERT_TRUE(enviarBT(clienteBT, "SUB ESTADO 200\n"));
+  limpiarSalida();
+  esperarReportes(3, 2000000);
+  TEST_ASSERT_EQUAL_UINT8(3, contarReportes());
+
+  close(clienteBT);
+  simularHost(500000);
+  conectarBT();
+  TEST_ASSERT_LESS_THAN_UINT32(1000000, (uint32_t)esperarReportes(1, 1000000));
+  limpiarSalida();
+  esperarReportes(1, 2000000);
+  TEST_ASSERT_EQUAL_UINT8(0, contarReportes());
+}
+
+// Desde que el comando esta en el enlace hasta que termina de llegar el
+// reporte, con el comando cayendo en distintas fases del periodo de la tarea
+static void test_latencia_de_estado()
+{
+  TEST_ASSERT_NOT_EQUAL(-1, clienteBT);
+  static const uint8_t COMANDOS = 24;
+  uint32_t us[COMANDOS];
+  for (uint8_t i = 0; i < COMANDOS; i++)
+  {
+    simularHost(100000 + i * 700);
+    recibir(0);
+    limpiarSalida();
+    TEST_ASSERT_TRUE(enviarBT(clienteBT, "ESTADO\n"));
+    us[i] = (uint32_t)esperarReportes(1, 1000000);
+    TEST_ASSERT_EQUAL_UINT8(1, contarReportes());
+  }
+  std::sort(us, us + COMANDOS);
+  printf("{\"estado_pty\":\"us\",\"min\":%lu,\"mediana\":%lu,\"max\":%lu}\n", (unsigned long)us[0],
+         (unsigned long)us[COMANDOS / 2], (unsigned long)us[COMANDOS - 1]);
+  // La tarea bt corre cada 4 ms y responde en la misma vuelta
+  TEST_ASSERT_LESS_THAN_UINT32(8000, us[COMANDOS - 1]);
+}
+
+// El cliente deja de leer dos minutos con una suscripcion activa: el PTY
+// se llena y la aplicacion deja de bombear. Al drenarlo tiene que volver a
+// entregar sola, sin reconectar.
+static void test_aplicacion_sale_de_la_congestion()
+{
+  TEST_ASSERT_NOT_EQUAL(-1, clienteBT);
+  TEST_ASSERT_TRUE(enviarBT(clienteBT, "SUB ESTADO 100\n"));
+  simularHost(120000000);
+
+  char buf[4096];
+  uint32_t drenados = 0;
+  size_t n;
+  while ((n = leerCliente(clienteBT, buf, sizeof(buf), 20)) > 0)
+    drenados += (uint32_t)n;
+  TEST_ASSERT_GREATER_THAN_UINT32(sizeof(buf), drenados);
+
+  TEST_ASSERT_TRUE(enviarBT(clienteBT, "SUB ESTADO 0\n"));
+  simularHost(200000);
+  recibir(ESPERA_KERNEL_MS);
+  limpiarSalida();
+  TEST_ASSERT_TRUE(enviarBT(clienteBT, "ESTADO\n"));
+  TEST_ASSERT_LESS_THAN_UINT32(8000, (uint32_t)esperarReportes(1, 1000000));
+  TEST_ASSERT_EQUAL_UINT8(1, contarReportes());
+}
+
+int main(int, char **)
+{
+  consolaHost.silenciar(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_sockets_conecta_desconecta_y_reconecta);
+  RUN_TEST(test_pty_conecta_desconecta_y_reconecta);
+  RUN_TEST(test_sockets_congestion);
+  RUN_TEST(test_pty_congestion);
+  arrancar();
+  RUN_TEST(test_aplicacion_ve_conexion_y_reconexion);
+  RUN_TEST(test_latencia_de_estado);
+  RUN_TEST(test_aplicacion_sale_de_la_congestion);
+  if (clienteBT >= 0)
+    close(clienteBT);
+  return UNITY_END();
+}